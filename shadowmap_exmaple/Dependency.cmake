@@ -66,6 +66,9 @@ ExternalProject_Add(
     INSTALL_COMMAND ${CMAKE_COMMAND} -E copy
         ${PROJECT_BINARY_DIR}/dep_stb-prefix/src/dep_stb/stb_image.h
         ${DEP_INSTALL_DIR}/include/stb/stb_image.h
+    COMMAND ${CMAKE_COMMAND} -E copy
+        ${PROJECT_BINARY_DIR}/dep_stb-prefix/src/dep_stb/stb_dxt.h
+        ${DEP_INSTALL_DIR}/include/stb/stb_dxt.h
     )
 set(DEP_LIST ${DEP_LIST} dep_stb)
 
@@ -0,0 +1,23 @@
+// VERTEX_FORMAT_COMPACT mesh 의 attribute 복원, src/mesh.h 의 CompactVertex 와 같아야 함
+// position: bounding box 기준 unorm16 -> xyz + position * w
+// normal: octahedral snorm16 두개
+// vertexDequantize.w 가 0 이면 float vertex 이므로 그대로 쓴다
+uniform vec4 vertexDequantize;
+
+vec3 DecodePosition(vec3 position)
+{
+    if (vertexDequantize.w == 0.0)
+        return position;
+    return vertexDequantize.xyz + position * vertexDequantize.w;
+}
+
+vec3 DecodeNormal(vec3 normal)
+{
+    if (vertexDequantize.w == 0.0)
+        return normal;
+    vec3 n = vec3(normal.xy, 1.0 - abs(normal.x) - abs(normal.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
\ No newline at end of file
@@ -5,12 +5,13 @@ in vec3 position;
 
 out vec4 fragColor;
 
-uniform vec3 cameraPos;
+#include "frame_block.glsl"
+
 uniform samplerCube skybox;
 
 void main()
 {
-    vec3 I = normalize(position - cameraPos);
+    vec3 I = normalize(position - frame.viewPos);
     vec3 R = reflect(I, normalize(normal));
     fragColor = vec4(texture(skybox, R).rgb, 1.0);
 }
\ No newline at end of file
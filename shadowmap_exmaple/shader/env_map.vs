@@ -6,13 +6,13 @@ layout (location = 1) in vec3 aNormal;
 out vec3 normal;
 out vec3 position;
 
+#include "frame_block.glsl"
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 void main()
 {
     normal = mat3(transpose(inverse(model))) * aNormal;
     position = vec3(model * vec4(aPos, 1.0));
-    gl_Position = projection * view * vec4(position, 1.0);
+    gl_Position = frame.viewProjection * vec4(position, 1.0);
 }
\ No newline at end of file
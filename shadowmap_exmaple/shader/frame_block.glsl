@@ -0,0 +1,8 @@
+// src/uniform_block.h 의 FrameBlock 과 layout 이 같아야 함
+layout (std140) uniform FrameBlock
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec3 viewPos;
+} frame;
\ No newline at end of file
@@ -0,0 +1,37 @@
+#version 330 core
+
+// culling 을 통과한 instance (point) 하나를 grass.vs 와 같은 quad 로 펼친다
+layout (points) in;
+layout (triangle_strip, max_vertices = 4) out;
+
+in vec3 vsOffset[];
+out vec2 texCoord;
+
+#include "frame_block.glsl"
+
+uniform mat4 modelTransform;
+
+void main()
+{
+    vec3 offset = vsOffset[0];
+    float c = cos(offset.y);
+    float s = sin(offset.y);
+
+    mat4 offsetMat = mat4(
+        c, 0.0, s, 0.0,
+        0.0, 1.0, 0.0, 0.0,
+        -s, 0.0, c, 0.0,
+        offset.x, 0.0, offset.z, 1.0);
+    mat4 transform = frame.viewProjection * modelTransform * offsetMat;
+
+    // Mesh::CreatePlane 과 같은 크기 / texture 좌표
+    const vec2 corners[4] = vec2[4](
+        vec2(-0.5, -0.5), vec2(0.5, -0.5), vec2(-0.5, 0.5), vec2(0.5, 0.5));
+    for (int i = 0; i < 4; ++i)
+    {
+        gl_Position = transform * vec4(corners[i], 0.0, 1.0);
+        texCoord = corners[i] + 0.5;
+        EmitVertex();
+    }
+    EndPrimitive();
+}
\ No newline at end of file
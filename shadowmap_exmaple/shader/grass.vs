@@ -5,7 +5,9 @@ layout (location = 2) in vec2 aTexCoord;
 layout (location = 3) in vec3 aOffset;
 out vec2 texCoord;
 
-uniform mat4 transform;
+#include "frame_block.glsl"
+
+uniform mat4 modelTransform;
 
 void main()
 {
@@ -18,6 +20,6 @@ void main()
         -s, 0.0, c, 0.0,
         aOffset.x, 0.0, aOffset.z, 1.0);
 
-    gl_Position = transform * offsetMat * vec4(aPos, 1.0);
+    gl_Position = frame.viewProjection * modelTransform * offsetMat * vec4(aPos, 1.0);
     texCoord = aTexCoord;
 }
\ No newline at end of file
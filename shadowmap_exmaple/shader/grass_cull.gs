@@ -0,0 +1,19 @@
+#version 330 core
+
+// 보이는 instance 만 transform feedback buffer 에 남긴다
+layout (points) in;
+layout (points, max_vertices = 1) out;
+
+in vec3 vsOffset[];
+flat in int vsVisible[];
+
+out vec3 outOffset;
+
+void main()
+{
+    if (vsVisible[0] == 0)
+        return;
+    outOffset = vsOffset[0];
+    EmitVertex();
+    EndPrimitive();
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#version 330 core
+
+// instance: x, z 는 위치, y 는 y 축 회전 (grass.vs 의 aOffset 과 같음)
+layout (location = 0) in vec3 aOffset;
+
+#include "frame_block.glsl"
+
+uniform mat4 modelTransform;
+// src/frustum.h 의 Frustum::planes, 안쪽이 양수
+uniform vec4 cullPlanes[6];
+uniform float cullDistance;
+uniform float cullRadius;
+
+out vec3 vsOffset;
+flat out int vsVisible;
+
+void main()
+{
+    vec3 center = (modelTransform * vec4(aOffset.x, 0.0, aOffset.z, 1.0)).xyz;
+
+    bool visible = distance(center, frame.viewPos) < cullDistance + cullRadius;
+    for (int i = 0; i < 6; ++i)
+        visible = visible && dot(cullPlanes[i].xyz, center) + cullPlanes[i].w >= -cullRadius;
+
+    vsOffset = aOffset;
+    vsVisible = visible ? 1 : 0;
+}
\ No newline at end of file
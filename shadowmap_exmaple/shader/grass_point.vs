@@ -0,0 +1,10 @@
+#version 330 core
+
+layout (location = 0) in vec3 aOffset;
+
+out vec3 vsOffset;
+
+void main()
+{
+    vsOffset = aOffset;
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#version 330 core
+
+// r: 가장 먼 depth (occlusion test 용), g: 가장 가까운 depth
+out vec2 fragColor;
+
+uniform sampler2D source;
+
+void main()
+{
+    ivec2 coord = ivec2(gl_FragCoord.xy);
+#ifdef FROM_DEPTH
+    // 첫 level 은 depth buffer 를 그대로 옮긴다
+    float depth = texelFetch(source, coord, 0).r;
+    fragColor = vec2(depth);
+#else
+    // source 는 base level 을 바로 위 level 로 맞춰둔 같은 texture
+    ivec2 sourceSize = textureSize(source, 0);
+    ivec2 destSize = max(sourceSize / 2, ivec2(1));
+    ivec2 first = min(coord * 2, sourceSize - 1);
+    ivec2 last = min(coord * 2 + 1, sourceSize - 1);
+    // 크기가 홀수면 마지막 texel 이 남는 한 줄까지 덮어야 보수적인 값이 된다
+    if (coord.x == destSize.x - 1)
+        last.x = sourceSize.x - 1;
+    if (coord.y == destSize.y - 1)
+        last.y = sourceSize.y - 1;
+
+    vec2 result = vec2(0.0, 1.0);
+    for (int y = first.y; y <= last.y; ++y)
+    {
+        for (int x = first.x; x <= last.x; ++x)
+        {
+            vec2 value = texelFetch(source, ivec2(x, y), 0).rg;
+            result = vec2(max(result.x, value.x), min(result.y, value.y));
+        }
+    }
+    fragColor = result;
+#endif
+}
\ No newline at end of file
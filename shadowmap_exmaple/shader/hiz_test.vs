@@ -0,0 +1,51 @@
+#version 330 core
+
+// world space bounding box 하나를 depth pyramid 로 test 해서 결과를 transform feedback 으로 남긴다
+layout (location = 0) in vec3 aBoxMin;
+layout (location = 1) in vec3 aBoxMax;
+
+uniform mat4 viewProjection;
+uniform sampler2D hiZ;
+uniform int hiZLevelCount;
+
+flat out uint outVisible;
+
+void main()
+{
+    vec3 ndcMin = vec3(1.0);
+    vec3 ndcMax = vec3(-1.0);
+    for (int i = 0; i < 8; ++i)
+    {
+        vec3 corner = vec3(
+            (i & 1) != 0 ? aBoxMax.x : aBoxMin.x,
+            (i & 2) != 0 ? aBoxMax.y : aBoxMin.y,
+            (i & 4) != 0 ? aBoxMax.z : aBoxMin.z);
+        vec4 clip = viewProjection * vec4(corner, 1.0);
+        // camera 뒤로 걸치면 화면 영역을 알 수 없으니 보이는 것으로
+        if (clip.w <= 0.0)
+        {
+            outVisible = 1u;
+            return;
+        }
+        vec3 ndc = clip.xyz / clip.w;
+        ndcMin = min(ndcMin, ndc);
+        ndcMax = max(ndcMax, ndc);
+    }
+
+    ivec2 size0 = textureSize(hiZ, 0);
+    vec2 texelMin0 = clamp(ndcMin.xy * 0.5 + 0.5, 0.0, 1.0) * vec2(size0);
+    vec2 texelMax0 = clamp(ndcMax.xy * 0.5 + 0.5, 0.0, 1.0) * vec2(size0);
+    float boxDepth = ndcMin.z * 0.5 + 0.5;
+
+    // box 가 한 축에 최대 2 texel 을 덮는 level 을 고르면 네 귀퉁이만 보면 된다
+    vec2 extent = texelMax0 - texelMin0;
+    int level = clamp(int(ceil(log2(max(max(extent.x, extent.y), 1.0)))), 0, hiZLevelCount - 1);
+    ivec2 size = textureSize(hiZ, level);
+    ivec2 texelMin = min(ivec2(texelMin0) >> level, size - 1);
+    ivec2 texelMax = min(min(ivec2(texelMax0), size0 - 1) >> level, size - 1);
+
+    float farthest = max(
+        max(texelFetch(hiZ, texelMin, level).r, texelFetch(hiZ, ivec2(texelMax.x, texelMin.y), level).r),
+        max(texelFetch(hiZ, ivec2(texelMin.x, texelMax.y), level).r, texelFetch(hiZ, texelMax, level).r));
+    outVisible = boxDepth <= farthest ? 1u : 0u;
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+// src/uniform_block.h 의 LightBlock 과 layout 이 같아야 함
+layout (std140) uniform LightBlock
+{
+    mat4 transform;
+    vec3 position;
+    int directional;
+    vec3 direction;
+    int blinn;
+    vec3 attenuation;
+    vec2 cutoff;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+} light;
\ No newline at end of file
@@ -0,0 +1,82 @@
+// 공통 lighting 계산
+// LIGHT_TYPE, SPECULAR_BLINN 은 compile 시점에 정해지므로 분기 없이 특수화된다
+#include "frame_block.glsl"
+#include "light_block.glsl"
+
+#define LIGHT_TYPE_DIRECTIONAL 0
+#define LIGHT_TYPE_POINT 1
+#define LIGHT_TYPE_SPOT 2
+
+#ifndef LIGHT_TYPE
+#define LIGHT_TYPE LIGHT_TYPE_SPOT
+#endif
+
+#ifndef SPECULAR_BLINN
+#define SPECULAR_BLINN 1
+#endif
+
+struct Material {
+    sampler2D diffuse;
+    sampler2D specular;
+    float shininess;
+};
+uniform Material material;
+
+struct LightSample {
+    vec3 direction;
+    float attenuation;
+    float intensity;
+};
+
+LightSample evaluateLight(vec3 fragPos)
+{
+    LightSample result;
+#if LIGHT_TYPE == LIGHT_TYPE_DIRECTIONAL
+    result.direction = normalize(-light.direction);
+    result.attenuation = 1.0;
+    result.intensity = 1.0;
+#else
+    float dist = length(light.position - fragPos);
+    vec3 distPoly = vec3(1.0, dist, dist * dist);
+    result.direction = normalize(light.position - fragPos);
+    result.attenuation = 1.0 / dot(distPoly, light.attenuation);
+#if LIGHT_TYPE == LIGHT_TYPE_SPOT
+    float theta = dot(result.direction, normalize(-light.direction));
+    result.intensity = clamp(
+        (theta - light.cutoff[1]) / (light.cutoff[0] - light.cutoff[1]),
+        0.0, 1.0);
+#else
+    result.intensity = 1.0;
+#endif
+#endif
+    return result;
+}
+
+float specularFactor(vec3 pixelNorm, vec3 lightDir, vec3 viewDir)
+{
+#if SPECULAR_BLINN
+    vec3 halfway = normalize(lightDir + viewDir);
+    return pow(max(dot(pixelNorm, halfway), 0.0), material.shininess);
+#else
+    vec3 reflectDir = reflect(-lightDir, pixelNorm);
+    return pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+#endif
+}
+
+// ambient + (diffuse + specular) 를 계산, shadow 가 1 이면 ambient 만 남는다
+vec3 shadeFragment(vec3 fragPos, vec3 pixelNorm, vec2 texCoord, LightSample lightSample, float shadow)
+{
+    vec3 texColor = texture(material.diffuse, texCoord).xyz;
+    vec3 ambient = texColor * light.ambient;
+
+    float diff = max(dot(pixelNorm, lightSample.direction), 0.0);
+    vec3 diffuse = diff * texColor * light.diffuse;
+
+    vec3 specColor = texture(material.specular, texCoord).xyz;
+    vec3 viewDir = normalize(frame.viewPos - fragPos);
+    float spec = specularFactor(pixelNorm, lightSample.direction, viewDir);
+    vec3 specular = spec * specColor * light.specular;
+
+    vec3 result = ambient + (diffuse + specular) * lightSample.intensity * (1.0 - shadow);
+    return result * lightSample.attenuation;
+}
\ No newline at end of file
@@ -3,7 +3,8 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
 
-uniform mat4 transform;
+#include "frame_block.glsl"
+
 uniform mat4 modelTransform;
 
 out vec3 normal;
@@ -11,7 +12,7 @@ out vec2 texCoord;
 out vec3 position;
 
 void main() {
-    gl_Position = transform * vec4(aPos, 1.0);
+    gl_Position = frame.viewProjection * modelTransform * vec4(aPos, 1.0);
     normal = (transpose(inverse(modelTransform)) * vec4(aNormal, 1.0f)).xyz;
     texCoord = aTexCoord;
     position = (modelTransform * vec4(aPos, 1.0f)).xyz;
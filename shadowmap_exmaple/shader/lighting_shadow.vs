@@ -12,15 +12,17 @@ out VS_OUT
     vec4 fragPosLight;
 } vs_out;
 
-uniform mat4 transform;
-uniform mat4 modelTransform;
-uniform mat4 lightTransform;
+#include "frame_block.glsl"
+#include "light_block.glsl"
+
+#include "model_transform.glsl"
+#include "compact_vertex.glsl"
 
 void main()
 {
-    gl_Position = transform * vec4(aPos, 1.0);
-    vs_out.fragPos = vec3(modelTransform * vec4(aPos, 1.0));
-    vs_out.normal = transpose(inverse(mat3(modelTransform))) * aNormal;
+    vs_out.fragPos = vec3(MODEL_TRANSFORM * vec4(DecodePosition(aPos), 1.0));
+    gl_Position = frame.viewProjection * vec4(vs_out.fragPos, 1.0);
+    vs_out.normal = transpose(inverse(mat3(MODEL_TRANSFORM))) * DecodeNormal(aNormal);
     vs_out.texCoord = aTexCoord;
-    vs_out.fragPosLight = lightTransform * vec4(vs_out.fragPos, 1.0);
+    vs_out.fragPosLight = light.transform * vec4(vs_out.fragPos, 1.0);
 }
\ No newline at end of file
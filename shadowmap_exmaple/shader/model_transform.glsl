@@ -0,0 +1,9 @@
+// INSTANCED 가 정의되면 model matrix 를 instance attribute (location 4~7) 로 받는다
+// src/render_queue.cpp 의 INSTANCE_TRANSFORM_LOCATION 과 같아야 함
+#ifdef INSTANCED
+layout (location = 4) in mat4 aModelTransform;
+#define MODEL_TRANSFORM aModelTransform
+#else
+uniform mat4 modelTransform;
+#define MODEL_TRANSFORM modelTransform
+#endif
\ No newline at end of file
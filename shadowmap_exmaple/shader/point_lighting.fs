@@ -4,47 +4,17 @@ in vec2 texCoord;
 in vec3 position;
 out vec4 fragColor;
 
-uniform vec3 viewPos;
-
-struct Light {
-    vec3 position;
-    vec3 attenuation;
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
-uniform Light light;
- 
-struct Material {
-    sampler2D diffuse;
-    sampler2D specular;
-    float shininess;
-};
-uniform Material material;
+#ifndef LIGHT_TYPE
+#define LIGHT_TYPE LIGHT_TYPE_POINT
+#endif
+#ifndef SPECULAR_BLINN
+#define SPECULAR_BLINN 0
+#endif
+#include "lighting.glsl"
 
 void main() {
     // Phong Illumination 모델
-
-    // ambient light 계산
-    vec3 texColor = texture2D(material.diffuse, texCoord).xyz;
-    vec3 ambient = texColor * light.ambient;
-
-    // diffuse light 계산
-    float dist = length(light.position - position);
-    vec3 distPoly = vec3(1.0, dist, dist * dist);
-    float attenuation = 1.0 / dot(distPoly, light.attenuation);
-    vec3 lightDir = normalize(light.position - position); 
-    vec3 pixelNorm = normalize(normal);
-    float diff = max(dot(pixelNorm, lightDir), 0.0f);
-    vec3 diffuse = diff * texColor * light.diffuse;
-
-    // specular light 계산
-    vec3 specColor = texture2D(material.specular, texCoord).xyz;
-    vec3 viewDir = normalize(viewPos - position);
-    vec3 reflectDir = reflect(-lightDir, pixelNorm);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0f), material.shininess);
-    vec3 specular = spec * specColor * light.specular;
-
-    vec3 result = (ambient + diffuse + specular) * attenuation;
+    LightSample lightSample = evaluateLight(position);
+    vec3 result = shadeFragment(position, normalize(normal), texCoord, lightSample, 0.0);
     fragColor = vec4(result, 1.0);
 }
\ No newline at end of file
@@ -2,8 +2,11 @@
 
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 transform;
+#include "frame_block.glsl"
+
+#include "model_transform.glsl"
+#include "compact_vertex.glsl"
 
 void main() {
-  gl_Position = transform * vec4(aPos, 1.0);
+  gl_Position = frame.viewProjection * MODEL_TRANSFORM * vec4(DecodePosition(aPos), 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,17 @@
+#version 330 core
+
+in vec2 texCoord;
+out vec4 fragColor;
+
+struct Material {
+    sampler2D diffuse;
+    sampler2D specular;
+    float shininess;
+};
+uniform Material material;
+
+void main() {
+  vec4 pixel = texture(material.diffuse, texCoord);
+  if (pixel.a < 0.01) discard;
+  fragColor = pixel;
+}
\ No newline at end of file
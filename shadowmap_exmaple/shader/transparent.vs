@@ -0,0 +1,17 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+
+#include "frame_block.glsl"
+
+#include "model_transform.glsl"
+#include "compact_vertex.glsl"
+
+out vec2 texCoord;
+
+void main() {
+  gl_Position = frame.viewProjection * MODEL_TRANSFORM * vec4(DecodePosition(aPos), 1.0);
+  texCoord = aTexCoord;
+}
\ No newline at end of file
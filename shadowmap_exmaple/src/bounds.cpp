@@ -0,0 +1,33 @@
+#include "bounds.h"
+
+BoundingBox BoundingBox::Transform(const glm::mat4& transform) const
+{
+    if (!IsValid())
+        return *this;
+
+    // 중심은 그대로 변환하고, 새 extent 는 |M| * extent
+    auto center = glm::vec3(transform * glm::vec4(GetCenter(), 1.0f));
+    auto extents = GetExtents();
+    glm::vec3 newExtents(0.0f);
+    for (int column = 0; column < 3; ++column)
+    {
+        for (int row = 0; row < 3; ++row)
+            newExtents[row] += std::abs(transform[column][row]) * extents[column];
+    }
+
+    BoundingBox box;
+    box.min = center - newExtents;
+    box.max = center + newExtents;
+    return box;
+}
+
+BoundingSphere BoundingSphere::Transform(const glm::mat4& transform) const
+{
+    float scale = std::max(glm::length(glm::vec3(transform[0])),
+        std::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+
+    BoundingSphere sphere;
+    sphere.center = glm::vec3(transform * glm::vec4(center, 1.0f));
+    sphere.radius = radius * scale;
+    return sphere;
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef __BOUNDS_H__
+#define __BOUNDS_H__
+
+#include "common.h"
+#include <cfloat>
+
+// axis aligned bounding box, 비어 있으면 min > max
+struct BoundingBox
+{
+    glm::vec3 min { glm::vec3(FLT_MAX) };
+    glm::vec3 max { glm::vec3(-FLT_MAX) };
+
+    bool IsValid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+    glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+    // 각 축 방향의 절반 크기
+    glm::vec3 GetExtents() const { return (max - min) * 0.5f; }
+    bool Contains(const glm::vec3& point, float margin = 0.0f) const
+    {
+        return point.x >= min.x - margin && point.y >= min.y - margin && point.z >= min.z - margin &&
+            point.x <= max.x + margin && point.y <= max.y + margin && point.z <= max.z + margin;
+    }
+
+    // BVH build 에서 아주 많이 불리므로 inline. 빈 box 를 더해도 그대로다
+    void Expand(const glm::vec3& point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+    void Expand(const BoundingBox& box)
+    {
+        min = glm::min(min, box.min);
+        max = glm::max(max, box.max);
+    }
+    // 변환한 8 개의 꼭지점을 감싸는 box (Arvo)
+    BoundingBox Transform(const glm::mat4& transform) const;
+};
+
+// 중심은 항상 같은 mesh 의 BoundingBox 중심과 같다
+// 그래서 culling 에서 box 와 구 중 더 작은 반지름을 골라 쓸 수 있다
+struct BoundingSphere
+{
+    glm::vec3 center { glm::vec3(0.0f) };
+    float radius { 0.0f };
+
+    // scale 이 축마다 다르면 가장 큰 scale 을 쓴다
+    BoundingSphere Transform(const glm::mat4& transform) const;
+};
+
+#endif // __BOUNDS_H__
\ No newline at end of file
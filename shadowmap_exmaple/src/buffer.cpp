@@ -1,4 +1,5 @@
 #include "buffer.h"
+#include "render_state.h"
 
 BufferUPtr Buffer::CreateWithData(
     uint32_t bufferType, uint32_t usage,
@@ -20,7 +21,7 @@ bool Buffer::Init(
     m_count = count;
 
     glGenBuffers(1, &m_buffer);
-    glBindBuffer(m_bufferType, m_buffer);
+    Bind();
     glBufferData(m_bufferType, stride * count, data, m_usage);
 
     return true;
@@ -29,10 +30,29 @@ bool Buffer::Init(
 Buffer::~Buffer()
 {
     if (m_buffer != 0)
+    {
+        RenderState::Get().OnDeleteBuffer(m_buffer);
         glDeleteBuffers(1, &m_buffer);
+    }
 }
 
 void Buffer::Bind() const
 {
-    glBindBuffer(m_bufferType, m_buffer);
+    RenderState::Get().BindBuffer(m_bufferType, m_buffer);
+}
+
+void Buffer::BindBase(uint32_t index) const
+{
+    RenderState::Get().BindBufferRange(m_bufferType, index, m_buffer, 0, 0);
+}
+
+void Buffer::BindRange(uint32_t index, size_t offset, size_t size) const
+{
+    RenderState::Get().BindBufferRange(m_bufferType, index, m_buffer, offset, size);
+}
+
+void Buffer::Update(const void* data, size_t size, size_t offset) const
+{
+    Bind();
+    glBufferSubData(m_bufferType, offset, size, data);
 }
\ No newline at end of file
@@ -0,0 +1,426 @@
+#include "bvh.h"
+#include <algorithm>
+
+static const uint32_t BIN_COUNT = 16;
+static const uint32_t MAX_LEAF_SIZE = 4;
+// node 하나를 지나가는 비용, 물체 하나를 test 하는 비용을 1 로 본다
+static const float TRAVERSAL_COST = 1.0f;
+// refit 후 cost 가 build 직후보다 이 비율 이상 나빠지면 다시 만든다
+static const float REBUILD_THRESHOLD = 1.5f;
+// 걸친 node 아래 물체가 이 이하면 자식 node 대신 물체를 SIMD 로 바로 test 한다
+static const uint32_t SIMD_RANGE_SIZE = 16;
+
+static float GetSurfaceArea(const BoundingBox& box)
+{
+    if (!box.IsValid())
+        return 0.0f;
+    auto size = box.max - box.min;
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+BvhUPtr Bvh::Create()
+{
+    auto bvh = BvhUPtr(new Bvh());
+    bvh->m_culler = FrustumCuller::Create();
+    return std::move(bvh);
+}
+
+void Bvh::Clear()
+{
+    m_nodes.clear();
+    m_objectIndices.clear();
+    m_objectBounds.clear();
+    m_culler->Clear();
+    m_needsBuild = false;
+    m_needsRefit = false;
+    m_builtCost = 0.0f;
+}
+
+uint32_t Bvh::AddObject(const BoundingBox& box)
+{
+    m_objectBounds.push_back(box);
+    m_needsBuild = true;
+    return (uint32_t)m_objectBounds.size() - 1;
+}
+
+void Bvh::UpdateObject(uint32_t object, const BoundingBox& box)
+{
+    m_objectBounds[object] = box;
+    m_needsRefit = true;
+}
+
+void Bvh::Update()
+{
+    if (m_needsBuild)
+    {
+        Build();
+        return;
+    }
+    if (!m_needsRefit)
+        return;
+
+    Refit();
+    if (ComputeSahCost() > m_builtCost * REBUILD_THRESHOLD)
+        Build();
+}
+
+void Bvh::Build()
+{
+    m_nodes.clear();
+    m_objectIndices.resize(m_objectBounds.size());
+    for (uint32_t i = 0; i < (uint32_t)m_objectIndices.size(); ++i)
+        m_objectIndices[i] = i;
+    m_needsBuild = false;
+    m_needsRefit = false;
+    if (m_objectBounds.empty())
+    {
+        m_culler->Clear();
+        m_builtCost = 0.0f;
+        return;
+    }
+
+    std::vector<glm::vec3> centroids(m_objectBounds.size());
+    for (size_t i = 0; i < m_objectBounds.size(); ++i)
+        centroids[i] = m_objectBounds[i].GetCenter();
+
+    // node 는 최대 2n - 1 개
+    m_nodes.reserve(m_objectBounds.size() * 2);
+    Node root;
+    root.leftFirst = 0;
+    root.count = (uint32_t)m_objectBounds.size();
+    root.rangeCount = root.count;
+    m_nodes.push_back(root);
+    UpdateNodeBounds(0);
+    Subdivide(0, centroids);
+    UpdateCuller();
+    m_builtCost = ComputeSahCost();
+}
+
+void Bvh::UpdateCuller()
+{
+    // 구 반지름을 크게 줘서 node 와 같은 box test 가 되게 한다
+    if (m_culler->GetCount() != m_objectIndices.size())
+    {
+        m_culler->Clear();
+        for (auto object : m_objectIndices)
+            m_culler->Add(m_objectBounds[object], FLT_MAX);
+        return;
+    }
+    for (uint32_t i = 0; i < (uint32_t)m_objectIndices.size(); ++i)
+        m_culler->Update(i, m_objectBounds[m_objectIndices[i]], FLT_MAX);
+}
+
+void Bvh::UpdateNodeBounds(uint32_t nodeIndex)
+{
+    auto& node = m_nodes[nodeIndex];
+    node.bounds = BoundingBox();
+    for (uint32_t i = 0; i < node.count; ++i)
+        node.bounds.Expand(m_objectBounds[m_objectIndices[node.leftFirst + i]]);
+}
+
+void Bvh::Subdivide(uint32_t nodeIndex, const std::vector<glm::vec3>& centroids)
+{
+    // 재귀 대신 stack 을 써서 한쪽으로 치우친 tree 에서도 stack overflow 가 나지 않게 한다
+    std::vector<uint32_t> stack = { nodeIndex };
+    while (!stack.empty())
+    {
+        uint32_t current = stack.back();
+        stack.pop_back();
+
+        uint32_t first = m_nodes[current].leftFirst;
+        uint32_t count = m_nodes[current].count;
+        if (count <= MAX_LEAF_SIZE)
+            continue;
+
+        BoundingBox centroidBounds;
+        for (uint32_t i = 0; i < count; ++i)
+            centroidBounds.Expand(centroids[m_objectIndices[first + i]]);
+
+        // 축마다 centroid 를 bin 에 나눠 담고 bin 경계 중 SAH cost 가 가장 낮은 곳을 고른다
+        float bestCost = FLT_MAX;
+        int bestAxis = -1;
+        uint32_t bestSplit = 0;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float axisMin = centroidBounds.min[axis];
+            float axisExtent = centroidBounds.max[axis] - axisMin;
+            if (axisExtent <= 0.0f)
+                continue;
+
+            BoundingBox binBounds[BIN_COUNT];
+            uint32_t binCounts[BIN_COUNT] = {};
+            float scale = BIN_COUNT / axisExtent;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                uint32_t object = m_objectIndices[first + i];
+                uint32_t bin = std::min(BIN_COUNT - 1, (uint32_t)((centroids[object][axis] - axisMin) * scale));
+                binBounds[bin].Expand(m_objectBounds[object]);
+                ++binCounts[bin];
+            }
+
+            // 왼쪽 / 오른쪽에서 누적한 면적과 개수
+            float leftArea[BIN_COUNT - 1], rightArea[BIN_COUNT - 1];
+            uint32_t leftCount[BIN_COUNT - 1], rightCount[BIN_COUNT - 1];
+            BoundingBox leftBox, rightBox;
+            uint32_t leftSum = 0, rightSum = 0;
+            for (uint32_t i = 0; i < BIN_COUNT - 1; ++i)
+            {
+                leftSum += binCounts[i];
+                leftBox.Expand(binBounds[i]);
+                leftCount[i] = leftSum;
+                leftArea[i] = GetSurfaceArea(leftBox);
+
+                rightSum += binCounts[BIN_COUNT - 1 - i];
+                rightBox.Expand(binBounds[BIN_COUNT - 1 - i]);
+                rightCount[BIN_COUNT - 2 - i] = rightSum;
+                rightArea[BIN_COUNT - 2 - i] = GetSurfaceArea(rightBox);
+            }
+            for (uint32_t i = 0; i < BIN_COUNT - 1; ++i)
+            {
+                if (leftCount[i] == 0 || rightCount[i] == 0)
+                    continue;
+                float cost = leftArea[i] * leftCount[i] + rightArea[i] * rightCount[i];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = i;
+                }
+            }
+        }
+
+        // 모든 centroid 가 한 점에 있으면 나눌 수 없다
+        if (bestAxis < 0)
+            continue;
+        float parentArea = GetSurfaceArea(m_nodes[current].bounds);
+        float splitCost = TRAVERSAL_COST + (parentArea > 0.0f ? bestCost / parentArea : 0.0f);
+        if (splitCost >= (float)count && count <= MAX_LEAF_SIZE * 4)
+            continue;
+
+        float axisMin = centroidBounds.min[bestAxis];
+        float scale = BIN_COUNT / (centroidBounds.max[bestAxis] - axisMin);
+        uint32_t* begin = m_objectIndices.data() + first;
+        uint32_t* end = begin + count;
+        uint32_t* middle = std::partition(begin, end, [&](uint32_t object) {
+            uint32_t bin = std::min(BIN_COUNT - 1, (uint32_t)((centroids[object][bestAxis] - axisMin) * scale));
+            return bin <= bestSplit;
+        });
+        uint32_t leftCount = (uint32_t)(middle - begin);
+
+        uint32_t leftIndex = (uint32_t)m_nodes.size();
+        Node left, right;
+        left.leftFirst = first;
+        left.count = leftCount;
+        left.rangeFirst = left.leftFirst;
+        left.rangeCount = left.count;
+        right.leftFirst = first + leftCount;
+        right.count = count - leftCount;
+        right.rangeFirst = right.leftFirst;
+        right.rangeCount = right.count;
+        m_nodes.push_back(left);
+        m_nodes.push_back(right);
+        UpdateNodeBounds(leftIndex);
+        UpdateNodeBounds(leftIndex + 1);
+
+        m_nodes[current].leftFirst = leftIndex;
+        m_nodes[current].count = 0;
+        stack.push_back(leftIndex);
+        stack.push_back(leftIndex + 1);
+    }
+}
+
+void Bvh::Refit()
+{
+    if (m_needsBuild)
+    {
+        Build();
+        return;
+    }
+
+    // 자식이 부모보다 뒤에 있으므로 뒤에서부터 보면 아래에서 위로 올라간다
+    for (size_t i = m_nodes.size(); i-- > 0;)
+    {
+        auto& node = m_nodes[i];
+        if (node.IsLeaf())
+        {
+            UpdateNodeBounds((uint32_t)i);
+            continue;
+        }
+        node.bounds = m_nodes[node.leftFirst].bounds;
+        node.bounds.Expand(m_nodes[node.leftFirst + 1].bounds);
+    }
+    UpdateCuller();
+    m_needsRefit = false;
+}
+
+float Bvh::ComputeSahCost() const
+{
+    if (m_nodes.empty())
+        return 0.0f;
+    float rootArea = GetSurfaceArea(m_nodes[0].bounds);
+    if (rootArea <= 0.0f)
+        return (float)m_objectBounds.size();
+
+    float cost = 0.0f;
+    for (const auto& node : m_nodes)
+    {
+        float area = GetSurfaceArea(node.bounds);
+        cost += node.IsLeaf() ? area * node.count : area * TRAVERSAL_COST;
+    }
+    return cost / rootArea;
+}
+
+void Bvh::CollectObjects(uint32_t nodeIndex, std::vector<uint32_t>& result) const
+{
+    // 완전히 안쪽인 subtree 는 더 test 하지 않고 leaf 의 물체를 모두 모은다
+    auto& stack = m_nodeStack;
+    stack.clear();
+    stack.push_back(nodeIndex);
+    while (!stack.empty())
+    {
+        const auto& node = m_nodes[stack.back()];
+        stack.pop_back();
+        if (node.IsLeaf())
+        {
+            result.insert(result.end(), m_objectIndices.begin() + node.leftFirst,
+                m_objectIndices.begin() + node.leftFirst + node.count);
+            continue;
+        }
+        stack.push_back(node.leftFirst);
+        stack.push_back(node.leftFirst + 1);
+    }
+}
+
+void Bvh::QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& result) const
+{
+    if (m_nodes.empty())
+        return;
+
+    const uint32_t allPlanes = (1u << Frustum::PLANE_COUNT) - 1;
+    // 0: 밖, 1: 걸침, 2: 완전히 안쪽. planeMask 에서 안쪽이 확정된 평면은 빠진다
+    auto classify = [&frustum](const BoundingBox& box, uint32_t& planeMask) {
+        auto center = box.GetCenter();
+        auto extents = box.GetExtents();
+        for (int p = 0; p < Frustum::PLANE_COUNT; ++p)
+        {
+            if (!(planeMask & (1u << p)))
+                continue;
+            const auto& plane = frustum.planes[p];
+            auto normal = glm::vec3(plane);
+            float distance = glm::dot(normal, center) + plane.w;
+            float radius = glm::dot(glm::abs(normal), extents);
+            if (distance + radius < 0.0f)
+                return 0;
+            if (distance - radius >= 0.0f)
+                planeMask &= ~(1u << p);
+        }
+        return planeMask == 0 ? 2 : 1;
+    };
+
+    auto& stack = m_queryStack;
+    stack.clear();
+    stack.push_back({ 0, allPlanes });
+    while (!stack.empty())
+    {
+        auto [nodeIndex, planeMask] = stack.back();
+        stack.pop_back();
+        const auto& node = m_nodes[nodeIndex];
+
+        int state = classify(node.bounds, planeMask);
+        if (state == 0)
+            continue;
+        if (state == 2)
+        {
+            CollectObjects(nodeIndex, result);
+            continue;
+        }
+        if (!node.IsLeaf() && node.rangeCount > SIMD_RANGE_SIZE)
+        {
+            stack.push_back({ node.leftFirst, planeMask });
+            stack.push_back({ node.leftFirst + 1, planeMask });
+            continue;
+        }
+
+        // leaf 이거나 작은 subtree 면 아래 물체를 남은 평면으로만 4 개씩 test 한다
+        m_culler->CullRange(frustum, planeMask, node.rangeFirst, node.rangeCount, m_objectIndices.data(), result);
+    }
+}
+
+// slab test, 만나면 들어가는 거리 (안에서 시작하면 0)
+static bool IntersectRayBox(const glm::vec3& origin, const glm::vec3& inverseDirection,
+    const BoundingBox& box, float maxDistance, float& distance)
+{
+    float tMin = 0.0f;
+    float tMax = maxDistance;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        float t0 = (box.min[axis] - origin[axis]) * inverseDirection[axis];
+        float t1 = (box.max[axis] - origin[axis]) * inverseDirection[axis];
+        if (t0 > t1)
+            std::swap(t0, t1);
+        tMin = std::max(tMin, t0);
+        tMax = std::min(tMax, t1);
+        if (tMin > tMax)
+            return false;
+    }
+    distance = tMin;
+    return true;
+}
+
+bool Bvh::Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const
+{
+    if (m_nodes.empty())
+        return false;
+
+    // 0 으로 나누면 inf 가 되어 slab test 가 그대로 동작한다
+    auto inverseDirection = glm::vec3(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    float closest = maxDistance;
+    bool found = false;
+
+    auto& stack = m_nodeStack;
+    stack.clear();
+    float rootDistance;
+    if (!IntersectRayBox(origin, inverseDirection, m_nodes[0].bounds, closest, rootDistance))
+        return false;
+    stack.push_back(0);
+    while (!stack.empty())
+    {
+        const auto& node = m_nodes[stack.back()];
+        stack.pop_back();
+
+        if (node.IsLeaf())
+        {
+            for (uint32_t i = 0; i < node.count; ++i)
+            {
+                uint32_t object = m_objectIndices[node.leftFirst + i];
+                float distance;
+                if (IntersectRayBox(origin, inverseDirection, m_objectBounds[object], closest, distance))
+                {
+                    closest = distance;
+                    hit.object = object;
+                    hit.distance = distance;
+                    found = true;
+                }
+            }
+            continue;
+        }
+
+        // 가까운 자식을 먼저 꺼내도록 나중에 넣는다
+        uint32_t children[2] = { node.leftFirst, node.leftFirst + 1 };
+        float distances[2];
+        bool hits[2];
+        for (int i = 0; i < 2; ++i)
+            hits[i] = IntersectRayBox(origin, inverseDirection, m_nodes[children[i]].bounds, closest, distances[i]);
+        if (hits[0] && hits[1])
+        {
+            bool leftFirst = distances[0] <= distances[1];
+            stack.push_back(leftFirst ? children[1] : children[0]);
+            stack.push_back(leftFirst ? children[0] : children[1]);
+        }
+        else if (hits[0])
+            stack.push_back(children[0]);
+        else if (hits[1])
+            stack.push_back(children[1]);
+    }
+    return found;
+}
\ No newline at end of file
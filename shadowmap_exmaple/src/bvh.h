@@ -0,0 +1,85 @@
+#ifndef __BVH_H__
+#define __BVH_H__
+
+#include "common.h"
+#include "bounds.h"
+#include "frustum.h"
+#include "frustum_culler.h"
+#include <vector>
+
+// scene 물체의 world space box 위에 만든 bounding volume hierarchy
+//
+// Build() 는 binned SAH 로 처음부터 다시 만들고, Refit() 은 tree 모양은 두고 bound 만 갱신한다
+// 물체가 움직이면 UpdateObject() 후 Update() 를 부르면 된다
+// refit 으로 SAH cost 가 많이 나빠지면 알아서 다시 만든다
+//
+// frustum query 는 부모 box 가 완전히 안쪽인 평면은 자식에서 다시 test 하지 않는다
+// 걸친 node 아래 물체가 적으면 더 내려가지 않고 FrustumCuller 로 4 개씩 한번에 test 한다
+CLASS_PTR(Bvh)
+class Bvh
+{
+public:
+    static BvhUPtr Create();
+
+    struct RayHit
+    {
+        uint32_t object { 0 };
+        float distance { 0.0f };
+    };
+
+    void Clear();
+    // 추가한 순서대로 object id 가 매겨진다. 다음 Update() 에서 다시 만든다
+    uint32_t AddObject(const BoundingBox& box);
+    void UpdateObject(uint32_t object, const BoundingBox& box);
+    const BoundingBox& GetObjectBounds(uint32_t object) const { return m_objectBounds[object]; }
+    size_t GetObjectCount() const { return m_objectBounds.size(); }
+    size_t GetNodeCount() const { return m_nodes.size(); }
+
+    void Build();
+    void Refit();
+    void Update();
+    // root 면적에 대한 상대 cost, 낮을수록 좋은 tree
+    float ComputeSahCost() const;
+
+    // frustum 과 겹치는 물체 id 를 result 뒤에 붙인다
+    void QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& result) const;
+    // 물체 box 와 가장 먼저 만나는 지점. direction 은 정규화되어 있어야 함
+    bool Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const;
+
+private:
+    Bvh() {}
+
+    // 자식은 항상 [leftFirst, leftFirst + 1] 에 붙어 있고 부모보다 뒤에 있다
+    // leaf 면 m_objectIndices[leftFirst, leftFirst + count) 가 물체
+    // subtree 의 물체는 m_objectIndices[rangeFirst, rangeFirst + rangeCount) 에 모여 있다
+    struct Node
+    {
+        BoundingBox bounds;
+        uint32_t leftFirst { 0 };
+        uint32_t count { 0 };
+        uint32_t rangeFirst { 0 };
+        uint32_t rangeCount { 0 };
+        bool IsLeaf() const { return count > 0; }
+    };
+
+    void UpdateNodeBounds(uint32_t nodeIndex);
+    void Subdivide(uint32_t nodeIndex, const std::vector<glm::vec3>& centroids);
+    void CollectObjects(uint32_t nodeIndex, std::vector<uint32_t>& result) const;
+    // m_objectIndices 순서대로 물체 bound 를 m_culler 에 옮긴다
+    void UpdateCuller();
+
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_objectIndices;
+    std::vector<BoundingBox> m_objectBounds;
+    // index 는 물체 id 가 아니라 m_objectIndices 의 위치
+    FrustumCullerUPtr m_culler;
+    // 매 frame query 마다 할당하지 않도록 traversal stack 을 재사용한다. 그래서 query 는 한 thread 에서만 한다
+    // QueryFrustum 안에서 CollectObjects 를 부르므로 따로 둔다
+    mutable std::vector<std::pair<uint32_t, uint32_t>> m_queryStack;
+    mutable std::vector<uint32_t> m_nodeStack;
+    bool m_needsBuild { false };
+    bool m_needsRefit { false };
+    float m_builtCost { 0.0f };
+};
+
+#endif // __BVH_H__
\ No newline at end of file
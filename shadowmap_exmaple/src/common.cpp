@@ -31,4 +31,24 @@ glm::vec3 GetAttenuationCoeff(float distance) {
     float kq = glm::dot(quad_coeff, dvec);
 
     return glm::vec3(kc, glm::max(kl, 0.0f), glm::max(kq*kq, 0.0f));
+}
+
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed)
+{
+    auto bytes = reinterpret_cast<const uint8_t*>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+uint64_t HashString(const std::string& text, uint64_t seed)
+{
+    // 길이도 섞어서 ("ab", "c") 와 ("a", "bc") 가 같은 key 가 되지 않게 한다
+    uint64_t length = text.length();
+    seed = HashBytes(&length, sizeof(length), seed);
+    return HashBytes(text.data(), text.length(), seed);
 }
\ No newline at end of file
@@ -23,4 +23,8 @@ using klassName ## WPtr = std::weak_ptr<klassName>;
 
 glm::vec3 GetAttenuationCoeff(float distance);
 
+// FNV-1a 64bit, cache key 생성용
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 0xcbf29ce484222325ull);
+uint64_t HashString(const std::string& text, uint64_t seed = 0xcbf29ce484222325ull);
+
 #endif // __COMMON_H__
\ No newline at end of file
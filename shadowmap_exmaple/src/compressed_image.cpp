@@ -0,0 +1,501 @@
+#include "compressed_image.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+
+#define STB_DXT_IMPLEMENTATION
+#include <stb/stb_dxt.h>
+
+namespace
+{
+    constexpr uint32_t MakeFourCC(char a, char b, char c, char d)
+    {
+        return (uint32_t)(uint8_t)a | ((uint32_t)(uint8_t)b << 8) |
+            ((uint32_t)(uint8_t)c << 16) | ((uint32_t)(uint8_t)d << 24);
+    }
+
+    const uint32_t DDS_MAGIC = MakeFourCC('D', 'D', 'S', ' ');
+    const uint32_t DDSD_CAPS = 0x1;
+    const uint32_t DDSD_HEIGHT = 0x2;
+    const uint32_t DDSD_WIDTH = 0x4;
+    const uint32_t DDSD_PIXELFORMAT = 0x1000;
+    const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+    const uint32_t DDSD_LINEARSIZE = 0x80000;
+    const uint32_t DDPF_FOURCC = 0x4;
+    const uint32_t DDSCAPS_COMPLEX = 0x8;
+    const uint32_t DDSCAPS_TEXTURE = 0x1000;
+    const uint32_t DDSCAPS_MIPMAP = 0x400000;
+    const uint32_t DDSCAPS2_CUBEMAP = 0x200;
+    const uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+
+    struct DDSPixelFormat
+    {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t fourCC;
+        uint32_t rgbBitCount;
+        uint32_t bitMasks[4];
+    };
+
+    struct DDSHeader
+    {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t height;
+        uint32_t width;
+        uint32_t pitchOrLinearSize;
+        uint32_t depth;
+        uint32_t mipMapCount;
+        uint32_t reserved1[11];
+        DDSPixelFormat pixelFormat;
+        uint32_t caps;
+        uint32_t caps2;
+        uint32_t caps3;
+        uint32_t caps4;
+        uint32_t reserved2;
+    };
+    static_assert(sizeof(DDSHeader) == 124, "DDS header layout");
+
+    struct DDSHeaderDX10
+    {
+        uint32_t dxgiFormat;
+        uint32_t resourceDimension;
+        uint32_t miscFlag;
+        uint32_t arraySize;
+        uint32_t miscFlags2;
+    };
+
+    const uint8_t KTX2_IDENTIFIER[12] = {
+        0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n',
+    };
+
+    struct KTX2Header
+    {
+        uint8_t identifier[12];
+        uint32_t vkFormat;
+        uint32_t typeSize;
+        uint32_t pixelWidth;
+        uint32_t pixelHeight;
+        uint32_t pixelDepth;
+        uint32_t layerCount;
+        uint32_t faceCount;
+        uint32_t levelCount;
+        uint32_t supercompressionScheme;
+        uint32_t dfdByteOffset;
+        uint32_t dfdByteLength;
+        uint32_t kvdByteOffset;
+        uint32_t kvdByteLength;
+        uint64_t sgdByteOffset;
+        uint64_t sgdByteLength;
+    };
+    static_assert(sizeof(KTX2Header) == 80, "KTX2 header layout");
+
+    struct KTX2Level
+    {
+        uint64_t byteOffset;
+        uint64_t byteLength;
+        uint64_t uncompressedByteLength;
+    };
+
+    // sRGB 인 것도 같은 format 으로 읽는다. 다른 texture 도 sRGB 변환 없이 sampling 한다
+    std::optional<CompressedImage::Format> FromDXGIFormat(uint32_t dxgiFormat)
+    {
+        using Format = CompressedImage::Format;
+        switch (dxgiFormat)
+        {
+            case 71: case 72: return Format::BC1;
+            case 77: case 78: return Format::BC3;
+            case 80: return Format::BC4;
+            case 83: return Format::BC5;
+            case 98: case 99: return Format::BC7;
+            default: return std::nullopt;
+        }
+    }
+
+    uint32_t ToDXGIFormat(CompressedImage::Format format)
+    {
+        using Format = CompressedImage::Format;
+        switch (format)
+        {
+            case Format::BC1: return 71;
+            case Format::BC3: return 77;
+            case Format::BC4: return 80;
+            case Format::BC5: return 83;
+            case Format::BC7: return 98;
+            default: return 0;
+        }
+    }
+
+    std::optional<CompressedImage::Format> FromVkFormat(uint32_t vkFormat)
+    {
+        using Format = CompressedImage::Format;
+        switch (vkFormat)
+        {
+            case 131: case 132: case 133: case 134: return Format::BC1;
+            case 137: case 138: return Format::BC3;
+            case 139: return Format::BC4;
+            case 141: return Format::BC5;
+            case 145: case 146: return Format::BC7;
+            case 147: case 148: return Format::ETC2_RGB;
+            case 151: case 152: return Format::ETC2_RGBA;
+            default: return std::nullopt;
+        }
+    }
+
+    std::vector<uint8_t> ToRGBA(const uint8_t* src, size_t pixelCount, int channelCount)
+    {
+        std::vector<uint8_t> rgba(pixelCount * 4);
+        for (size_t i = 0; i < pixelCount; ++i, src += channelCount)
+        {
+            uint8_t* dest = rgba.data() + i * 4;
+            // 1 channel 은 gray, 2 channel 은 gray + alpha
+            dest[0] = src[0];
+            dest[1] = channelCount >= 3 ? src[1] : src[0];
+            dest[2] = channelCount >= 3 ? src[2] : src[0];
+            dest[3] = channelCount == 4 ? src[3] : channelCount == 2 ? src[1] : 255;
+        }
+        return rgba;
+    }
+
+    void EncodeLevel(const std::vector<uint8_t>& rgba, int width, int height,
+        CompressedImage::Format format, uint8_t* dest)
+    {
+        using Format = CompressedImage::Format;
+        size_t blockSize = CompressedImage::GetBlockSize(format);
+        uint8_t block[16 * 4];
+        uint8_t channels[16 * 2];
+        for (int by = 0; by < height; by += 4)
+        {
+            for (int bx = 0; bx < width; bx += 4, dest += blockSize)
+            {
+                // 가장자리 block 은 마지막 pixel 을 반복한다
+                for (int y = 0; y < 4; ++y)
+                {
+                    for (int x = 0; x < 4; ++x)
+                    {
+                        size_t src = ((size_t)std::min(by + y, height - 1) * width + std::min(bx + x, width - 1)) * 4;
+                        memcpy(block + (y * 4 + x) * 4, rgba.data() + src, 4);
+                    }
+                }
+
+                switch (format)
+                {
+                    case Format::BC1:
+                        stb_compress_dxt_block(dest, block, 0, STB_DXT_HIGHQUAL);
+                        break;
+                    case Format::BC3:
+                        stb_compress_dxt_block(dest, block, 1, STB_DXT_HIGHQUAL);
+                        break;
+                    case Format::BC4:
+                        for (int i = 0; i < 16; ++i)
+                            channels[i] = block[i * 4];
+                        stb_compress_bc4_block(dest, channels);
+                        break;
+                    case Format::BC5:
+                        for (int i = 0; i < 16; ++i)
+                        {
+                            channels[i * 2 + 0] = block[i * 4 + 0];
+                            channels[i * 2 + 1] = block[i * 4 + 1];
+                        }
+                        stb_compress_bc5_block(dest, channels);
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+}
+
+CompressedImageUPtr CompressedImage::Load(const std::string& filepath, bool defaultPath)
+{
+    std::string fullPath = defaultPath ? std::string(IMAGE_PATH) : "";
+    fullPath += filepath;
+
+    auto file = MappedFile::Open(fullPath);
+    if (!file)
+    {
+        SPDLOG_ERROR("failed to load compressed image: {}", fullPath);
+        return nullptr;
+    }
+
+    auto image = CompressedImageUPtr(new CompressedImage());
+    auto extension = std::filesystem::path(fullPath).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    bool loaded = extension == ".ktx2" ?
+        image->LoadKTX2(file->GetData(), file->GetSize()) :
+        image->LoadDDS(file->GetData(), file->GetSize());
+    if (!loaded)
+    {
+        SPDLOG_ERROR("failed to load compressed image: {}", fullPath);
+        return nullptr;
+    }
+    return std::move(image);
+}
+
+bool CompressedImage::IsCompressedFile(const std::string& filepath)
+{
+    auto extension = std::filesystem::path(filepath).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == ".dds" || extension == ".ktx2";
+}
+
+size_t CompressedImage::GetBlockSize(Format format)
+{
+    switch (format)
+    {
+        case Format::BC1:
+        case Format::BC4:
+        case Format::ETC2_RGB:
+            return 8;
+        default:
+            return 16;
+    }
+}
+
+const char* CompressedImage::GetFormatName(Format format)
+{
+    switch (format)
+    {
+        case Format::BC1: return "BC1";
+        case Format::BC3: return "BC3";
+        case Format::BC4: return "BC4";
+        case Format::BC5: return "BC5";
+        case Format::BC7: return "BC7";
+        case Format::ETC2_RGB: return "ETC2 RGB";
+        case Format::ETC2_RGBA: return "ETC2 RGBA";
+    }
+    return "unknown";
+}
+
+size_t CompressedImage::GetLevelSize(Format format, int width, int height)
+{
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(format);
+}
+
+bool CompressedImage::LoadDDS(const uint8_t* data, size_t size)
+{
+    uint32_t magic = 0;
+    DDSHeader header = {};
+    if (size < sizeof(magic) + sizeof(header))
+        return false;
+    memcpy(&magic, data, sizeof(magic));
+    memcpy(&header, data + sizeof(magic), sizeof(header));
+    if (magic != DDS_MAGIC || header.size != sizeof(header))
+    {
+        SPDLOG_ERROR("not a DDS file");
+        return false;
+    }
+    if (!(header.pixelFormat.flags & DDPF_FOURCC))
+    {
+        SPDLOG_ERROR("uncompressed DDS is not supported");
+        return false;
+    }
+    if ((header.caps2 & DDSCAPS2_CUBEMAP) || header.depth > 1)
+    {
+        SPDLOG_ERROR("only 2D DDS textures are supported");
+        return false;
+    }
+
+    size_t offset = sizeof(magic) + sizeof(header);
+    std::optional<Format> format;
+    switch (header.pixelFormat.fourCC)
+    {
+        case MakeFourCC('D', 'X', 'T', '1'): format = Format::BC1; break;
+        case MakeFourCC('D', 'X', 'T', '5'): format = Format::BC3; break;
+        case MakeFourCC('A', 'T', 'I', '1'):
+        case MakeFourCC('B', 'C', '4', 'U'): format = Format::BC4; break;
+        case MakeFourCC('A', 'T', 'I', '2'):
+        case MakeFourCC('B', 'C', '5', 'U'): format = Format::BC5; break;
+        case MakeFourCC('D', 'X', '1', '0'):
+        {
+            DDSHeaderDX10 dx10 = {};
+            if (size < offset + sizeof(dx10))
+                return false;
+            memcpy(&dx10, data + offset, sizeof(dx10));
+            offset += sizeof(dx10);
+            if (dx10.resourceDimension != DDS_DIMENSION_TEXTURE2D || dx10.arraySize > 1)
+            {
+                SPDLOG_ERROR("only 2D DDS textures are supported");
+                return false;
+            }
+            format = FromDXGIFormat(dx10.dxgiFormat);
+            break;
+        }
+        default:
+            break;
+    }
+    if (!format)
+    {
+        SPDLOG_ERROR("unsupported DDS format: {:#x}", header.pixelFormat.fourCC);
+        return false;
+    }
+    m_format = *format;
+
+    // level 은 큰 것부터 빈틈 없이 이어진다
+    uint32_t levelCount = (header.flags & DDSD_MIPMAPCOUNT) ? std::max(header.mipMapCount, 1u) : 1;
+    std::vector<std::pair<size_t, size_t>> ranges;
+    for (uint32_t i = 0; i < levelCount && i < 32; ++i)
+    {
+        size_t levelSize = GetLevelSize(m_format,
+            std::max((int)(header.width >> i), 1), std::max((int)(header.height >> i), 1));
+        ranges.push_back({ offset, levelSize });
+        offset += levelSize;
+    }
+    return SetLevels((int)header.width, (int)header.height, ranges, data, size);
+}
+
+bool CompressedImage::LoadKTX2(const uint8_t* data, size_t size)
+{
+    KTX2Header header = {};
+    if (size < sizeof(header) || memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+    {
+        SPDLOG_ERROR("not a KTX2 file");
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    // Basis Universal / zstd 로 한 번 더 압축된 것은 풀어 줄 library 가 없다
+    if (header.supercompressionScheme != 0)
+    {
+        SPDLOG_ERROR("supercompressed KTX2 is not supported: scheme {}", header.supercompressionScheme);
+        return false;
+    }
+    if (header.pixelDepth > 0 || header.layerCount > 1 || header.faceCount != 1)
+    {
+        SPDLOG_ERROR("only 2D KTX2 textures are supported");
+        return false;
+    }
+    auto format = FromVkFormat(header.vkFormat);
+    if (!format)
+    {
+        SPDLOG_ERROR("unsupported KTX2 format: vkFormat {}", header.vkFormat);
+        return false;
+    }
+    m_format = *format;
+
+    // levelCount 0 은 "load 할 때 mipmap 을 만들어라" 라는 뜻이라 level 0 만 있다
+    uint32_t levelCount = std::max(header.levelCount, 1u);
+    if (levelCount > 32 || size < sizeof(header) + levelCount * sizeof(KTX2Level))
+        return false;
+    std::vector<std::pair<size_t, size_t>> ranges;
+    for (uint32_t i = 0; i < levelCount; ++i)
+    {
+        KTX2Level level = {};
+        memcpy(&level, data + sizeof(header) + i * sizeof(KTX2Level), sizeof(level));
+        if (level.byteOffset > size || level.byteLength > size)
+            return false;
+        ranges.push_back({ (size_t)level.byteOffset, (size_t)level.byteLength });
+    }
+    return SetLevels((int)header.pixelWidth, (int)header.pixelHeight, ranges, data, size);
+}
+
+bool CompressedImage::SetLevels(int width, int height, const std::vector<std::pair<size_t, size_t>>& ranges,
+    const uint8_t* data, size_t size)
+{
+    if (width <= 0 || height <= 0 || width > 16384 || height > 16384 || ranges.empty())
+    {
+        SPDLOG_ERROR("invalid compressed image size: {} x {}", width, height);
+        return false;
+    }
+    // 1x1 보다 작은 level 은 없다
+    size_t maxLevelCount = 1;
+    while ((std::max(width, height) >> maxLevelCount) > 0)
+        ++maxLevelCount;
+    size_t levelCount = std::min(ranges.size(), maxLevelCount);
+
+    m_levels.clear();
+    size_t totalSize = 0;
+    for (size_t i = 0; i < levelCount; ++i)
+    {
+        Level level;
+        level.width = std::max(width >> i, 1);
+        level.height = std::max(height >> i, 1);
+        level.offset = totalSize;
+        level.size = GetLevelSize(m_format, level.width, level.height);
+        const auto& range = ranges[i];
+        if (range.second < level.size || range.first > size || level.size > size - range.first)
+        {
+            SPDLOG_ERROR("compressed image level {} is truncated", i);
+            return false;
+        }
+        m_levels.push_back(level);
+        totalSize += level.size;
+    }
+
+    m_data.resize(totalSize);
+    for (size_t i = 0; i < m_levels.size(); ++i)
+        memcpy(m_data.data() + m_levels[i].offset, data + ranges[i].first, m_levels[i].size);
+    return true;
+}
+
+CompressedImageUPtr CompressedImage::Encode(const Image* image, Format format)
+{
+    if (format != Format::BC1 && format != Format::BC3 && format != Format::BC4 && format != Format::BC5)
+    {
+        SPDLOG_ERROR("{} encoding is not supported", GetFormatName(format));
+        return nullptr;
+    }
+
+    auto result = CompressedImageUPtr(new CompressedImage());
+    result->m_format = format;
+    for (int i = 0; i < image->GetLevelCount(); ++i)
+    {
+        Level level;
+        level.width = image->GetLevelWidth(i);
+        level.height = image->GetLevelHeight(i);
+        level.offset = result->m_data.size();
+        level.size = GetLevelSize(format, level.width, level.height);
+        result->m_data.resize(level.offset + level.size);
+        auto rgba = ToRGBA(image->GetLevelData(i), (size_t)level.width * level.height, image->GetChannelCount());
+        EncodeLevel(rgba, level.width, level.height, format, result->m_data.data() + level.offset);
+        result->m_levels.push_back(level);
+    }
+    return std::move(result);
+}
+
+bool CompressedImage::SaveDDS(const std::string& filepath) const
+{
+    uint32_t dxgiFormat = ToDXGIFormat(m_format);
+    if (!dxgiFormat)
+    {
+        SPDLOG_ERROR("{} can not be stored in a DDS file", GetFormatName(m_format));
+        return false;
+    }
+
+    DDSHeader header = {};
+    header.size = sizeof(header);
+    header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+    header.height = (uint32_t)GetHeight();
+    header.width = (uint32_t)GetWidth();
+    header.pitchOrLinearSize = (uint32_t)m_levels[0].size;
+    header.mipMapCount = (uint32_t)m_levels.size();
+    header.pixelFormat.size = sizeof(header.pixelFormat);
+    header.pixelFormat.flags = DDPF_FOURCC;
+    header.pixelFormat.fourCC = MakeFourCC('D', 'X', '1', '0');
+    header.caps = DDSCAPS_TEXTURE | (m_levels.size() > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0);
+
+    DDSHeaderDX10 dx10 = {};
+    dx10.dxgiFormat = dxgiFormat;
+    dx10.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+    dx10.arraySize = 1;
+
+    std::ofstream fout(filepath, std::ios::binary);
+    if (!fout)
+    {
+        SPDLOG_ERROR("failed to open file: {}", filepath);
+        return false;
+    }
+    fout.write(reinterpret_cast<const char*>(&DDS_MAGIC), sizeof(DDS_MAGIC));
+    fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    fout.write(reinterpret_cast<const char*>(&dx10), sizeof(dx10));
+    fout.write(reinterpret_cast<const char*>(m_data.data()), m_data.size());
+    if (!fout)
+    {
+        SPDLOG_ERROR("failed to write file: {}", filepath);
+        return false;
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#ifndef __COMPRESSED_IMAGE_H__
+#define __COMPRESSED_IMAGE_H__
+
+#include "image.h"
+#include <vector>
+
+// 4x4 block 으로 압축된 texture 와 모든 mip level
+// DDS (DX10 header 포함), KTX2 (supercompression 없는 것) 를 읽는다
+// 내용은 file 에 있는 순서 그대로 올리므로 Image::Load 처럼 아래 줄부터 저장되어 있어야 한다
+// Encode 로 만든 것은 받은 image 순서를 그대로 쓰므로 flipVertical 로 읽은 image 를 넣으면 된다
+CLASS_PTR(CompressedImage)
+class CompressedImage
+{
+public:
+    enum class Format
+    {
+        BC1,        // RGB + 1 bit alpha, 8 byte block
+        BC3,        // RGBA, 16 byte block
+        BC4,        // R, 8 byte block
+        BC5,        // RG (normal map), 16 byte block
+        BC7,        // RGBA 고품질, 16 byte block
+        ETC2_RGB,   // 8 byte block
+        ETC2_RGBA,  // 16 byte block
+    };
+
+    struct Level
+    {
+        int width { 0 };
+        int height { 0 };
+        size_t offset { 0 };
+        size_t size { 0 };
+    };
+
+    // .dds / .ktx2 확장자로 container 를 고른다. 지원하지 않는 format 이면 nullptr
+    static CompressedImageUPtr Load(const std::string& filepath, bool defaultPath = true);
+    static bool IsCompressedFile(const std::string& filepath);
+    // BC1 / BC3 / BC4 / BC5 로 압축한다 (BC1 은 alpha 를 버린다, BC4 / BC5 는 R / RG 만 쓴다)
+    // image 에 있는 level 을 모두 압축하므로 mip 까지 넣으려면 먼저 Image::GenerateMips 를 부른다
+    static CompressedImageUPtr Encode(const Image* image, Format format);
+    // DX10 header 를 붙여 쓴다. ETC2 는 DDS 로 표현할 수 없어서 실패한다
+    bool SaveDDS(const std::string& filepath) const;
+
+    static size_t GetBlockSize(Format format);
+    static const char* GetFormatName(Format format);
+
+    Format GetFormat() const { return m_format; }
+    int GetWidth() const { return m_levels[0].width; }
+    int GetHeight() const { return m_levels[0].height; }
+    const std::vector<Level>& GetLevels() const { return m_levels; }
+    const uint8_t* GetLevelData(size_t level) const { return m_data.data() + m_levels[level].offset; }
+    size_t GetDataSize() const { return m_data.size(); }
+
+private:
+    CompressedImage() {}
+    bool LoadDDS(const uint8_t* data, size_t size);
+    bool LoadKTX2(const uint8_t* data, size_t size);
+    // level 들이 file 안에 있고 크기가 맞는지 확인하고 m_data 로 복사한다
+    bool SetLevels(int width, int height, const std::vector<std::pair<size_t, size_t>>& ranges,
+        const uint8_t* data, size_t size);
+    static size_t GetLevelSize(Format format, int width, int height);
+
+    Format m_format { Format::BC1 };
+    std::vector<Level> m_levels;
+    std::vector<uint8_t> m_data;
+};
+
+#endif // __COMPRESSED_IMAGE_H__
\ No newline at end of file
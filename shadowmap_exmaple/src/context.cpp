@@ -1,6 +1,33 @@
 #include "context.h"
 #include "imgui.h"
 #include <glm/gtc/random.hpp>
+#include <cstring>
+#include <chrono>
+
+static const UniformHandle<glm::mat4> s_modelTransform("modelTransform");
+
+// lighting permutation key
+// bit 0: directional, bit 1: blinn, bit 2-3: PCF radius, bit 4: instanced
+static const uint32_t LIGHTING_KEY_DIRECTIONAL = 1 << 0;
+static const uint32_t LIGHTING_KEY_BLINN = 1 << 1;
+static const uint32_t LIGHTING_KEY_PCF_SHIFT = 2;
+static const uint32_t LIGHTING_KEY_PCF_MASK = 0x3;
+static const uint32_t LIGHTING_KEY_INSTANCED = 1 << 4;
+static const uint32_t LIGHTING_KEY_COUNT = 1 << 5;
+
+static const ShaderDefines INSTANCED_DEFINES = { { "INSTANCED", "1" } };
+
+static ShaderDefines BuildLightingDefines(uint32_t key)
+{
+    ShaderDefines defines = {
+        { "LIGHT_TYPE", key & LIGHTING_KEY_DIRECTIONAL ? "LIGHT_TYPE_DIRECTIONAL" : "LIGHT_TYPE_SPOT" },
+        { "SPECULAR_BLINN", key & LIGHTING_KEY_BLINN ? "1" : "0" },
+        { "PCF_RADIUS", std::to_string((key >> LIGHTING_KEY_PCF_SHIFT) & LIGHTING_KEY_PCF_MASK) },
+    };
+    if (key & LIGHTING_KEY_INSTANCED)
+        defines.insert(defines.end(), INSTANCED_DEFINES.begin(), INSTANCED_DEFINES.end());
+    return defines;
+}
 
 ContextUPtr Context::Create()
 {
@@ -12,62 +39,107 @@ ContextUPtr Context::Create()
 
 bool Context::Init()
 {
+    // program 들의 compile / link 를 먼저 모두 제출해 두고
+    // driver 가 compile 하는 동안 아래에서 image decode 를 진행한다
+    auto submitBegin = std::chrono::steady_clock::now();
+    m_simpleProgram = Program::CreateDeferred("/simple.vs", "/simple.fs");
+    m_program = Program::CreateDeferred("/lighting.vs", "/spot_lighting.fs");
+    m_textureProgram = Program::CreateDeferred("/texture.vs", "/texture.fs");
+    m_postProgram = Program::CreateDeferred("/texture.vs", "/gamma.fs");
+    m_skyboxProgram = Program::CreateDeferred("/skybox.vs", "/skybox.fs");
+    m_envMapProgram = Program::CreateDeferred("/env_map.vs", "/env_map.fs");
+    m_grassProgram = Program::CreateDeferred("/grass.vs", "/grass.fs");
+    m_transparentProgram = Program::CreateDeferred("/transparent.vs", "/transparent.fs");
+    m_simpleInstancedProgram = Program::CreateDeferred("/simple.vs", "/simple.fs", INSTANCED_DEFINES);
+    m_transparentInstancedProgram = Program::CreateDeferred("/transparent.vs", "/transparent.fs", INSTANCED_DEFINES);
+    m_lightingShadowVariants = ProgramVariants::Create("/lighting_shadow.vs", "/lighting_shadow.fs",
+        BuildLightingDefines);
+    // UI 에서 고를 수 있는 조합이 적으므로 전부 미리 제출해서 전환할 때 멈추지 않게 한다
+    for (uint32_t key = 0; key < LIGHTING_KEY_COUNT; ++key)
+    {
+        if (!m_lightingShadowVariants->Prepare(key))
+            return false;
+    }
+
+    Program* programs[] = {
+        m_simpleProgram.get(), m_program.get(), m_textureProgram.get(), m_postProgram.get(),
+        m_skyboxProgram.get(), m_envMapProgram.get(), m_grassProgram.get(), m_transparentProgram.get(),
+        m_simpleInstancedProgram.get(), m_transparentInstancedProgram.get(),
+    };
+    for (auto program : programs)
+    {
+        if (program == nullptr)
+            return false;
+    }
+    auto submitEnd = std::chrono::steady_clock::now();
+
+    m_msaaFramebuffer = Framebuffer::CreateMultisample(m_width, m_height, m_sampleCount);
     m_framebuffer = Framebuffer::Create(Texture::Create(m_width, m_height, GL_RGBA));
-    if (m_framebuffer == nullptr)
+    if (m_msaaFramebuffer == nullptr || m_framebuffer == nullptr)
     {
         return false;
     }
 
-    m_box = Mesh::CreateBox();
+    m_geometryPools[VERTEX_FORMAT_FULL] = GeometryPool::Create(VERTEX_FORMAT_FULL, 64 * 1024, 256 * 1024);
+    m_geometryPools[VERTEX_FORMAT_COMPACT] = GeometryPool::Create(VERTEX_FORMAT_COMPACT, 512 * 1024, 8 * 1024 * 1024);
+    if (!m_geometryPools[VERTEX_FORMAT_FULL] || !m_geometryPools[VERTEX_FORMAT_COMPACT])
+        return false;
+
+    m_box = Mesh::CreateBox(m_geometryPools[VERTEX_FORMAT_FULL]);
 
-    m_plane = Mesh::CreatePlane();
-    m_windowTexture = Texture::CreateFromImage(
-        Image::Load("/blending_transparent_window.png").get());
+    m_plane = Mesh::CreatePlane(m_geometryPools[VERTEX_FORMAT_FULL]);
+    m_textureStreamer = TextureStreamer::Create();
+    if (!m_textureStreamer)
+        return false;
+    m_textureCache = TextureCache::Create(m_textureStreamer.get());
+    m_windowTexture = m_textureCache->Load("/blending_transparent_window.png");
 
-    TexturePtr darkGrayTexture = Texture::CreateFromImage(
-        Image::CreateSingleColorImage(4, 4, glm::vec4(0.2f, 0.2f, 0.2f, 1.0f)).get());
+    TexturePtr darkGrayTexture = m_textureCache->CreateSingleColor(glm::vec4(0.2f, 0.2f, 0.2f, 1.0f));
 
-    TexturePtr grayTexture = Texture::CreateFromImage(
-        Image::CreateSingleColorImage(4, 4, glm::vec4(0.5f, 0.5f, 0.5f, 1.0f)).get());
+    TexturePtr grayTexture = m_textureCache->CreateSingleColor(glm::vec4(0.5f, 0.5f, 0.5f, 1.0f));
 
     m_planeMaterial = Material::Create();
-    m_planeMaterial->diffuse = Texture::CreateFromImage(
-        Image::Load("/marble.jpg").get());
+    m_planeMaterial->diffuse = m_textureCache->Load("/marble.jpg");
     m_planeMaterial->specular = grayTexture;
     m_planeMaterial->shininess = 128.0f;
 
     m_box1Material = Material::Create();
-    m_box1Material->diffuse = Texture::CreateFromImage(
-        Image::Load("/container.jpg").get());
+    m_box1Material->diffuse = m_textureCache->Load("/container.jpg");
     m_box1Material->specular = darkGrayTexture;
     m_box1Material->shininess = 16.0f;
 
     m_box2Material = Material::Create();
-    m_box2Material->diffuse = Texture::CreateFromImage(
-        Image::Load("/container2.png").get());
-    m_box2Material->specular = Texture::CreateFromImage(
-        Image::Load("/container2_specular.png").get());
+    m_box2Material->diffuse = m_textureCache->Load("/container2.png");
+    m_box2Material->specular = m_textureCache->Load("/container2_specular.png", true, true, false);
     m_box2Material->shininess = 64.0f;
 
-    m_simpleProgram = Program::Create("/simple.vs", "/simple.fs");
-    if (m_simpleProgram == nullptr)
-    {
-        return false;
-    }
-    SPDLOG_INFO("simpleProgram id: {}", m_simpleProgram->Get());
+    m_windowMaterial = Material::Create();
+    m_windowMaterial->diffuse = m_windowTexture;
 
-    m_program = Program::Create("/lighting.vs", "/spot_lighting.fs");
-    if (m_program == nullptr)
-    {
+    int uniformAlignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+    m_uniformAlignment = (size_t)std::max(uniformAlignment, 1);
+    m_uniformStream = StreamBuffer::Create(GL_UNIFORM_BUFFER, 64 * 1024);
+    m_instanceStream = StreamBuffer::Create(GL_ARRAY_BUFFER, 4 * 1024 * 1024);
+    if (!m_uniformStream || !m_instanceStream)
         return false;
-    }
-    SPDLOG_INFO("program id: {}", m_program->Get());
 
-    m_textureProgram = Program::Create("/texture.vs", "/texture.fs");
-    if (m_textureProgram == nullptr)
-        return false;
+    m_threadPool = ThreadPool::Create();
+    m_model = Model::Load("/backpack/backpack.obj", m_geometryPools[VERTEX_FORMAT_COMPACT],
+        m_threadPool.get(), m_textureCache.get());
+    if (!m_model)
+        SPDLOG_WARN("backpack model is not available");
 
-    m_postProgram = Program::Create("/texture.vs", "/gamma.fs");
+    InitScene();
+    m_renderQueue = RenderQueue::Create(m_instanceStream);
+
+    m_depthPyramid = DepthPyramid::Create();
+    m_occlusionCuller = OcclusionCuller::Create(1024);
+    if (!m_depthPyramid || !m_occlusionCuller)
+    {
+        SPDLOG_WARN("occlusion culling is not available");
+        m_occlusionCulling = false;
+    }
 
     auto cubeRight = Image::Load("/skybox/right.jpg", false);
     auto cubeLeft = Image::Load("/skybox/left.jpg", false);
@@ -85,12 +157,7 @@ bool Context::Init()
     images.push_back(cubeBack.get());
     m_cubeTexture = CubeTexture::CreateFromImages(images);
 
-    m_skyboxProgram = Program::Create("/skybox.vs", "/skybox.fs");
-    m_envMapProgram = Program::Create("/env_map.vs", "/env_map.fs");
-
-    m_grassTexture = Texture::CreateFromImage(
-        Image::Load("/grass.png").get());
-    m_grassProgram = Program::Create("/grass.vs", "/grass.fs");
+    m_grassTexture = m_textureCache->Load("/grass.png");
 
     
     m_grassPos.resize(10000);
@@ -101,28 +168,60 @@ bool Context::Init()
         pos.y = glm::radians(glm::linearRand(0.0f, 360.0f));
     }
 
-    m_grassInstance = VertexLayout::Create();
-    m_grassInstance->Bind();
-
-    m_plane->GetVertexBuffer()->Bind();
-    m_grassInstance->SetAttrib(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-    m_grassInstance->SetAttrib(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, normal));
-    m_grassInstance->SetAttrib(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, texCoord));
-    
-    m_grassPosBuffer = Buffer::CreateWithData(GL_ARRAY_BUFFER, GL_STATIC_DRAW, m_grassPos.data(), sizeof(glm::vec3), m_grassPos.size());
-    m_grassPosBuffer->Bind();
-    m_grassInstance->SetAttrib(3, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0);
-    glVertexAttribDivisor(3, 1);
-    m_plane->GetIndexBuffer()->Bind();
+    // x, z: 위치, y: y 축 회전
+    m_grassInstance = InstancedMesh::Create(m_plane, m_grassPos.size());
+    if (!m_grassInstance)
+        return false;
+    m_grassPosStream = m_grassInstance->AddStream<glm::vec3>(3, GL_STATIC_DRAW);
+    m_grassInstance->Update(m_grassPosStream, m_grassPos);
+    m_grassInstance->SetInstanceCount(m_grassPos.size());
+
+    // plane 한장 (한 변 1) 을 감싸는 구
+    m_grassCuller = InstanceCuller::Create(m_grassPos, 0.71f);
+    ShaderPtr grassPointVs = Shader::CreateFromFile("/grass_point.vs", GL_VERTEX_SHADER);
+    ShaderPtr grassGs = Shader::CreateFromFile("/grass.gs", GL_GEOMETRY_SHADER);
+    ShaderPtr grassFs = Shader::CreateFromFile("/grass.fs", GL_FRAGMENT_SHADER);
+    if (grassPointVs && grassGs && grassFs)
+        m_grassPointProgram = Program::Create({ grassPointVs, grassGs, grassFs });
+    if (!m_grassCuller || !m_grassPointProgram)
+    {
+        // culling 없이 모든 instance 를 그린다
+        SPDLOG_WARN("grass culling is not available");
+        m_grassCulling = false;
+    }
 
     m_shadowMap = ShadowMap::Create(1024, 1024);
 
-    m_lightingShadowProgram = Program::Create("/lighting_shadow.vs", "/lighting_shadow.fs");
-    if (nullptr == m_lightingShadowProgram)
+    // 남은 compile / link 결과를 기다린다
+    auto resolveBegin = std::chrono::steady_clock::now();
+    int readyCount = 0;
+    for (auto program : programs)
     {
-        SPDLOG_INFO("failed to create lighting shadow program: {}", m_lightingShadowProgram->Get());
-        return false;
+        if (program->IsReady())
+            ++readyCount;
+        if (!program->Resolve())
+            return false;
     }
+    if (!m_lightingShadowVariants->ResolveAll())
+        return false;
+    auto resolveEnd = std::chrono::steady_clock::now();
+    SPDLOG_INFO("simpleProgram id: {}", m_simpleProgram->Get());
+    SPDLOG_INFO("program id: {}", m_program->Get());
+
+    // 측정: submit 시간 + 나머지 초기화와 겹치지 못하고 기다린 시간
+    auto ToMilliseconds = [](auto duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    };
+    const auto& cacheStats = ProgramBinaryCache::GetStats();
+    SPDLOG_INFO("program creation: submit {:.2f} ms, overlapped init {:.2f} ms, resolve wait {:.2f} ms ({}/{} ready before resolve)",
+        ToMilliseconds(submitEnd - submitBegin),
+        ToMilliseconds(resolveBegin - submitEnd),
+        ToMilliseconds(resolveEnd - resolveBegin),
+        readyCount, (int)std::size(programs));
+    SPDLOG_INFO("lighting shadow variants: {}", m_lightingShadowVariants->GetVariantCount());
+    SPDLOG_INFO("{} start (binary cache hit: {}, miss: {}, rejected: {})",
+        cacheStats.missCount + cacheStats.rejectCount == 0 && cacheStats.hitCount > 0 ? "warm" : "cold",
+        cacheStats.hitCount, cacheStats.missCount, cacheStats.rejectCount);
 
     glClearColor(0.1f, 0.2f, 0.3f, 0.0f);
     glEnable(GL_MULTISAMPLE);
@@ -135,6 +234,15 @@ bool Context::Init()
 
 void Context::Render()
 {
+    // ImGui 가 frame 사이에 GL state 를 바꾸므로 매 frame 처음부터 다시 추적
+    auto& renderState = RenderState::Get();
+    m_renderStateStats = renderState.GetStats();
+    renderState.ResetStats();
+    renderState.Invalidate();
+    m_uniformStream->BeginFrame();
+    m_instanceStream->BeginFrame();
+    m_textureStreamer->Update();
+
     if (ImGui::Begin("UI window"))
     {
         if (ImGui::ColorEdit4("clear color", glm::value_ptr(m_clearColor)))
@@ -166,6 +274,7 @@ void Context::Render()
             ImGui::ColorEdit3("l.diffuse", glm::value_ptr(m_light.diffuse), 0.01f);
             ImGui::ColorEdit3("l.specular", glm::value_ptr(m_light.specular), 0.01f);
             ImGui::Checkbox("blinn", &m_light.blinn);
+            ImGui::SliderInt("pcf radius", &m_light.pcfRadius, 0, (int)LIGHTING_KEY_PCF_MASK);
         }
         
         ImGui::Checkbox("animation", &m_animation);
@@ -192,12 +301,111 @@ void Context::Render()
             ImGui::Image(m_shadowMap->GetShadowMap()->Get(), ImVec2(256*aspectRatio, 256), ImVec2(0, 1), ImVec2(1, 0));
         }
 
+        if (ImGui::CollapsingHeader("culling"))
+        {
+            uint32_t objectCount = (uint32_t)m_sceneObjects.size();
+            ImGui::Checkbox("frustum culling", &m_frustumCulling);
+            ImGui::Text("camera visible %3u, culled %3u", m_cameraVisibleCount, objectCount - m_cameraVisibleCount);
+            ImGui::Text("light  visible %3u, culled %3u", m_lightVisibleCount, objectCount - m_lightVisibleCount);
+            ImGui::Text("bvh nodes %zu, sah cost %.2f", m_sceneBvh->GetNodeCount(), m_sceneBvh->ComputeSahCost());
+            ImGui::Text("picked object %d", m_pickedObject);
+            ImGui::BeginDisabled(!m_depthPyramid || !m_occlusionCuller);
+            ImGui::Checkbox("occlusion culling", &m_occlusionCulling);
+            ImGui::EndDisabled();
+            ImGui::Text("occluded last test %3u (re-tested late)", m_occludedCount);
+
+            if (ImGui::Button("run culling benchmark"))
+                m_cullingBenchmark = RunCullingBenchmark({ 1000, 10000, 100000 });
+            for (const auto& result : m_cullingBenchmark)
+            {
+                ImGui::Text("%6u objects: build %.2fms, bvh %.3fms, brute force %.3fms",
+                    result.objectCount, result.buildMs, result.bvhQueryMs, result.bruteForceMs);
+            }
+        }
+
+        if (ImGui::CollapsingHeader("lod"))
+        {
+            ImGui::Checkbox("lod selection", &m_lodSelection);
+            ImGui::DragFloat("max pixel error", &m_lodPixelError, 0.05f, 0.1f, 32.0f);
+            ImGui::SliderFloat("hysteresis", &m_lodHysteresis, 0.0f, 0.9f);
+            ImGui::SliderInt("shadow lod bias", &m_shadowLodBias, 0, 4);
+            for (size_t i = 0; i < m_sceneObjects.size(); ++i)
+            {
+                const auto& object = m_sceneObjects[i];
+                if (object.mesh->GetLodCount() < 2)
+                    continue;
+                const auto& lod = object.mesh->GetLod(object.lod);
+                ImGui::Text("object %2zu lod %u / %u: %6u triangles, error %.4f", i, object.lod,
+                    object.mesh->GetLodCount(), lod.indexCount / 3, lod.error);
+            }
+        }
+
+        if (ImGui::CollapsingHeader("grass"))
+        {
+            ImGui::BeginDisabled(!m_grassCuller || !m_grassPointProgram);
+            ImGui::Checkbox("gpu culling", &m_grassCulling);
+            ImGui::EndDisabled();
+            ImGui::DragFloat("cull distance", &m_grassCullDistance, 0.1f, 0.0f, 100.0f);
+            if (m_grassCulling)
+                ImGui::Text("visible %5u / %5u", m_grassCuller->GetVisibleCount(), m_grassCuller->GetInstanceCount());
+        }
+
+        if (ImGui::CollapsingHeader("render state"))
+        {
+            for (int i = 0; i < RenderState::STATE_TYPE_COUNT; ++i)
+            {
+                ImGui::Text("%-16s issued %4u, skipped %4u",
+                    RenderState::GetStateTypeName((RenderState::StateType)i),
+                    m_renderStateStats.issued[i], m_renderStateStats.skipped[i]);
+            }
+            ImGui::Text("%-16s %zu objects, max anisotropy %.0fx", "samplers",
+                SamplerCache::Get().GetSamplerCount(), SamplerCache::Get().GetMaxAnisotropy());
+
+            const char* formatNames[VERTEX_FORMAT_COUNT] = { "full", "compact" };
+            for (uint32_t i = 0; i < VERTEX_FORMAT_COUNT; ++i)
+            {
+                const auto& pool = m_geometryPools[i];
+                ImGui::Text("%-16s vertex %6zu / %6zu, index %5zu / %5zu KB", formatNames[i],
+                    pool->GetUsedVertexCount(), pool->GetVertexCapacity(),
+                    pool->GetUsedIndexSize() / 1024, pool->GetIndexCapacity() / 1024);
+            }
+
+            const auto& textureStats = m_textureCache->GetStats();
+            ImGui::Text("%-16s hit %3d, miss %3d, live %3zu (%zu KB)", "texture cache",
+                textureStats.hitCount, textureStats.missCount, m_textureCache->GetLiveCount(),
+                m_textureCache->GetLiveMemorySize() / 1024);
+
+            const auto& streamStats = m_textureStreamer->GetStats();
+            ImGui::Text("%-16s pending %3u, done %3u, %5zu KB this frame", "texture stream",
+                streamStats.pendingCount, streamStats.completedCount, streamStats.uploadedBytes / 1024);
+            int streamBudget = (int)(m_textureStreamer->GetFrameBudget() / 1024);
+            if (ImGui::DragInt("stream budget (KB)", &streamBudget, 64.0f, 64, 64 * 1024))
+                m_textureStreamer->SetFrameBudget((size_t)streamBudget * 1024);
+
+            // render queue 의 통계는 아직 Clear 전이라 지난 frame 값
+            const char* passNames[RENDER_PASS_COUNT] = { "shadow", "opaque", "transparent" };
+            for (uint32_t i = 0; i < RENDER_PASS_COUNT; ++i)
+            {
+                const auto& queueStats = m_renderQueue->GetStats((RenderPass)i);
+                ImGui::Text("%-16s item %3u, draw %3u (instanced %3u), program %3u, material %3u, triangles %6u",
+                    passNames[i], queueStats.itemCount, queueStats.drawCount, queueStats.instancedDrawCount,
+                    queueStats.programChanges, queueStats.materialChanges, queueStats.triangleCount);
+            }
+        }
+
         std::string fps = "FPS : " + std::to_string((int)ImGui::GetIO().Framerate);
         ImGui::Text(fps.c_str());
     }
     ImGui::End();
 
-    glClear(GL_DEPTH_BUFFER_BIT);
+    m_cameraDir =
+        glm::rotate(glm::mat4(1.0f), glm::radians(m_cameraYaw), glm::vec3(0.0f, 1.0f, 0.0f)) *
+        glm::rotate(glm::mat4(1.0f), glm::radians(m_cameraPitch), glm::vec3(1.0f, 0.0f, 0.0f)) *
+        glm::vec4(0.0f, 0.0f, -1.0f, 0.0f);
+
+    auto view = glm::lookAt(m_cameraPos, m_cameraPos + m_cameraDir, m_cameraUp);
+    auto projection = GetCameraProjection();
+
     auto lightView = glm::lookAt(m_light.position, m_light.position + m_light.direction, glm::vec3(0.0f, 1.0f, 0.0f));
     auto lightProjection = m_light.directional ?
         glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, 1.0f, 30.0f) :
@@ -205,37 +413,73 @@ void Context::Render()
             glm::radians((m_light.cutoff[0] + m_light.cutoff[1]) * 2.0f),
             1.0f, 1.0f, m_light.distance);
 
+    // 모든 program 이 공유하는 frame / light 데이터를 한번에 갱신
+    UpdateUniformBlocks(view, projection, lightView, lightProjection);
+
+    // shadow / main pass 가 같이 쓰는 draw 목록을 만들고 한번에 정렬
+    auto lightingShadowProgram = m_lightingShadowVariants->Get(GetLightingPermutationKey());
+    auto lightingShadowInstancedProgram =
+        m_lightingShadowVariants->Get(GetLightingPermutationKey() | LIGHTING_KEY_INSTANCED);
+    BuildRenderQueue(lightingShadowProgram, lightingShadowInstancedProgram,
+        Frustum::FromMatrix(projection * view), Frustum::FromMatrix(lightProjection * lightView));
+    m_uniformStream->BindRange(UNIFORM_BLOCK_LIGHT, m_lightBlock);
+
+    // shadow pass 는 light 시점의 frame block 을 사용
+    m_uniformStream->BindRange(UNIFORM_BLOCK_FRAME, m_shadowFrameBlock);
+    // glClear 도 depth write mask 를 따르므로 clear 전에 depth state 를 지정
+    renderState.SetDepthState(DepthState());
     m_shadowMap->Bind();
     glClear(GL_DEPTH_BUFFER_BIT);
-    glViewport(0,0, m_shadowMap->GetShadowMap()->GetWidth(), m_shadowMap->GetShadowMap()->GetHeight());
+    renderState.SetViewport(0, 0, m_shadowMap->GetShadowMap()->GetWidth(), m_shadowMap->GetShadowMap()->GetHeight());
     m_simpleProgram->Use();
     m_simpleProgram->SetUniform("color", glm::vec4(1.0f));
-    DrawScene(lightView, lightProjection, m_simpleProgram.get());
-    Framebuffer::BindToDefault();
-    glViewport(0,0, m_width, m_height);
-    
-    m_cameraDir =
-        glm::rotate(glm::mat4(1.0f), glm::radians(m_cameraYaw), glm::vec3(0.0f, 1.0f, 0.0f)) *
-        glm::rotate(glm::mat4(1.0f), glm::radians(m_cameraPitch), glm::vec3(1.0f, 0.0f, 0.0f)) *
-        glm::vec4(0.0f, 0.0f, -1.0f, 0.0f);
+    m_simpleInstancedProgram->Use();
+    m_simpleInstancedProgram->SetUniform("color", glm::vec4(1.0f));
+    m_renderQueue->Execute(RENDER_PASS_SHADOW);
+
+    // depth 를 pyramid 로 읽어야 하므로 화면 대신 m_msaaFramebuffer 에 그리고 마지막에 풀어서 복사한다
+    m_msaaFramebuffer->Bind();
+    renderState.SetViewport(0, 0, m_width, m_height);
+
+    m_uniformStream->BindRange(UNIFORM_BLOCK_FRAME, m_cameraFrameBlock);
 
-    auto view = glm::lookAt(m_cameraPos, m_cameraPos + m_cameraDir, m_cameraUp);
-    auto projection = glm::perspective(glm::radians(45.0f),
-        static_cast<float>(m_width) / static_cast<float>(m_height), 0.1f, 100.0f);
-    
-    //m_framebuffer->Bind();
     glClearColor(m_clearColor.r, m_clearColor.g, m_clearColor.b, m_clearColor.a);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-    glEnable(GL_DEPTH_TEST);
 
 
+    // 불투명한 물체를 먼저 앞에서부터 그려서 뒤쪽 fragment 는 early-z 로 버린다
+    m_shadowMap->GetShadowMap()->Bind(3);
+    for (auto program : { lightingShadowProgram, lightingShadowInstancedProgram })
+    {
+        if (!program)
+            continue;
+        program->Use();
+        program->SetUniform("shadowMap", 3);
+    }
+    m_renderQueue->Execute(RENDER_PASS_OPAQUE);
+    RenderLateObjects(lightingShadowProgram);
+
+    // 불투명한 물체만 들어간 depth 로 pyramid 를 만들고 다음 frame 들을 위해 test 를 걸어둔다
+    if (m_occlusionCulling)
+    {
+        // multisample depth 는 texture 로 읽을 수 없으므로 sample 하나로 풀어서 읽는다
+        m_msaaFramebuffer->ResolveTo(m_framebuffer.get(), GL_DEPTH_BUFFER_BIT);
+        m_depthPyramid->Build(m_framebuffer->GetDepthStencilAttachment().get());
+        m_occlusionBoxes.clear();
+        for (uint32_t i = 0; i < (uint32_t)m_sceneObjects.size(); ++i)
+            m_occlusionBoxes.push_back(m_sceneBvh->GetObjectBounds(i));
+        m_occlusionCuller->Test(m_occlusionBoxes, projection * view, m_depthPyramid.get());
+        m_msaaFramebuffer->Bind();
+        renderState.SetViewport(0, 0, m_width, m_height);
+    }
+
     auto skyboxModelTransform =
         glm::translate(glm::mat4(1.0f), m_cameraPos) *
         glm::scale(glm::mat4(1.0f), glm::vec3(50.0f));
     m_skyboxProgram->Use();
-    m_cubeTexture->Bind();
+    m_cubeTexture->Bind(0);
     m_skyboxProgram->SetUniform("skybox", 0);
-    m_skyboxProgram->SetUniform("transform", projection * view * skyboxModelTransform);
+    m_skyboxProgram->SetUniform(s_modelTransform, skyboxModelTransform);
     m_box->Draw(m_skyboxProgram.get());
 
     // light 에 cube 그리기
@@ -246,11 +490,46 @@ void Context::Render()
         
         m_simpleProgram->Use();
         m_simpleProgram->SetUniform("color", glm::vec4(m_light.ambient + m_light.diffuse, 1.0f));
-        m_simpleProgram->SetUniform("transform", projection * view * lightModelTransform);
+        m_simpleProgram->SetUniform(s_modelTransform, lightModelTransform);
         
         m_box->Draw(m_simpleProgram.get());
     }
 
+    // 풀은 alpha 가 0 인 부분을 discard 하므로 blending 없이 그린다
+    auto grassTransform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.5f, 2.0f));
+    if (m_grassCulling)
+    {
+        // 보이는 instance 만 GPU 에서 골라낸 뒤 그 결과로 바로 그린다
+        m_grassCuller->Cull(grassTransform, Frustum::FromMatrix(projection * view), m_grassCullDistance);
+        m_grassPointProgram->Use();
+        m_grassTexture->Bind(0);
+        m_grassPointProgram->SetUniform("tex", 0);
+        m_grassPointProgram->SetUniform(s_modelTransform, grassTransform);
+        m_grassCuller->Draw();
+    }
+    else
+    {
+        m_grassProgram->Use();
+        m_grassTexture->Bind(0);
+        m_grassProgram->SetUniform("tex", 0);
+        m_grassProgram->SetUniform(s_modelTransform, grassTransform);
+        m_grassInstance->Draw(m_grassProgram.get());
+    }
+
+    // 투명한 창문은 마지막에 뒤에서부터
+    m_renderQueue->Execute(RENDER_PASS_TRANSPARENT);
+
+    // multisample 인 draw framebuffer 로는 blit 할 수 없으므로 window 는 multisample 없이 만든다 (main.cpp)
+    m_msaaFramebuffer->ResolveTo(m_framebuffer.get(), GL_COLOR_BUFFER_BIT);
+    renderState.BindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer->Get());
+    renderState.BindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    Framebuffer::BindToDefault();
+
+    // 이번 frame 에 쓴 구간은 GPU 가 다 읽을 때까지 다시 쓰지 않는다
+    m_uniformStream->EndFrame();
+    m_instanceStream->EndFrame();
+
     /* shadow 없는 기본 lighting 
     m_program->Use();
     m_program->SetUniform("viewPos", m_cameraPos);
@@ -267,29 +546,6 @@ void Context::Render()
     m_program->SetUniform("blinn", m_light.blinn);
     */
 
-    m_lightingShadowProgram->Use();
-    m_lightingShadowProgram->SetUniform("viewPos", m_cameraPos);
-    m_lightingShadowProgram->SetUniform("light.directional", m_light.directional ? 1 : 0);
-    m_lightingShadowProgram->SetUniform("light.position", m_light.position);
-    m_lightingShadowProgram->SetUniform("light.direction", m_light.direction);
-    m_lightingShadowProgram->SetUniform("light.cutoff", glm::vec2(
-        cosf(glm::radians(m_light.cutoff[0])),
-        cosf(glm::radians(m_light.cutoff[0] + m_light.cutoff[1]))));
-    m_lightingShadowProgram->SetUniform("light.attenuation", GetAttenuationCoeff(m_light.distance));
-    m_lightingShadowProgram->SetUniform("light.ambient", m_light.ambient);
-    m_lightingShadowProgram->SetUniform("light.diffuse", m_light.diffuse);
-    m_lightingShadowProgram->SetUniform("light.specular", m_light.specular);
-    m_lightingShadowProgram->SetUniform("blinn", m_light.blinn);
-    m_lightingShadowProgram->SetUniform("lightTransform", lightProjection * lightView);
-
-    glActiveTexture(GL_TEXTURE3);
-    m_shadowMap->GetShadowMap()->Bind();
-    m_lightingShadowProgram->SetUniform("shadowMap", 3);
-    glActiveTexture(GL_TEXTURE0);
-
-    
-    DrawScene(view, projection, m_lightingShadowProgram.get());
-
     // // 판 그리기    
     // auto modelTransform =
     //     glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.7f, 2.0f)) *
@@ -342,55 +598,6 @@ void Context::Render()
     // m_envMapProgram->SetUniform("skybox", 0);
     // m_box->Draw(m_envMapProgram.get());
 
-    // 투명빨간 창문 그리기
-    // glEnable(GL_BLEND);
-    // glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    // m_textureProgram->Use();
-    // m_windowTexture->Bind();
-    // m_textureProgram->SetUniform("tex", 0);
-
-    // modelTransform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.5f, 4.0f));
-    // transform = projection * view * modelTransform;
-    // m_textureProgram->SetUniform("transform", transform);
-    // m_plane->Draw(m_textureProgram.get());
-
-    // modelTransform = glm::translate(glm::mat4(1.0f), glm::vec3(0.2f, 0.5f, 5.0f));
-    // transform = projection * view * modelTransform;
-    // m_textureProgram->SetUniform("transform", transform);
-    // m_plane->Draw(m_textureProgram.get());
-
-    // modelTransform = glm::translate(glm::mat4(1.0f), glm::vec3(0.4f, 0.5f, 6.0f));
-    // transform = projection * view * modelTransform;
-    // m_textureProgram->SetUniform("transform", transform);
-    // m_plane->Draw(m_textureProgram.get());
-
-    // glDisable(GL_CULL_FACE);
-    // m_grassProgram->Use();
-    // m_grassTexture->Bind();
-    // m_grassProgram->SetUniform("tex", 0);
-    // m_grassInstance->Bind();
-
-    // modelTransform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.5f, 2.0f));
-    // transform = projection * view * modelTransform;
-    // m_grassProgram->SetUniform("transform", transform);
-
-    // glDrawElementsInstanced(GL_TRIANGLES,
-    //     m_plane->GetIndexBuffer()->GetCount(),
-    //     GL_UNSIGNED_INT, 0,
-    //     m_grassPosBuffer->GetCount());
-    
-    // instancing 없이 그리기
-    // for (size_t i=0; i<m_grassPos.size(); ++i)
-    // {
-    //     modelTransform =
-    //         glm::translate(glm::mat4(1.0f), glm::vec3(m_grassPos[i].x, 0.5f, m_grassPos[i].z + 2.0f)) *
-    //         glm::rotate(glm::mat4(1.0f), m_grassPos[i].y, glm::vec3(0.0f, 1.0f, 0.0f));
-    //     transform = projection * view * modelTransform;
-    //     m_grassProgram->SetUniform("transform", transform);
-    //     m_plane->Draw(m_grassProgram.get());
-    // }
-
     // m_framebuffer->BindToDefault();
 
     // glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
@@ -405,6 +612,42 @@ void Context::Render()
     // m_plane->Draw(m_postProgram.get());
 }
 
+void Context::UpdateUniformBlocks(
+    const glm::mat4& view, const glm::mat4& projection,
+    const glm::mat4& lightView, const glm::mat4& lightProjection)
+{
+    FrameBlock cameraFrame = {};
+    cameraFrame.view = view;
+    cameraFrame.projection = projection;
+    cameraFrame.viewProjection = projection * view;
+    cameraFrame.viewPos = m_cameraPos;
+
+    FrameBlock shadowFrame = {};
+    shadowFrame.view = lightView;
+    shadowFrame.projection = lightProjection;
+    shadowFrame.viewProjection = lightProjection * lightView;
+    shadowFrame.viewPos = m_light.position;
+
+    LightBlock light = {};
+    light.transform = lightProjection * lightView;
+    light.position = m_light.position;
+    light.directional = m_light.directional ? 1 : 0;
+    light.direction = m_light.direction;
+    light.blinn = m_light.blinn ? 1 : 0;
+    light.attenuation = GetAttenuationCoeff(m_light.distance);
+    light.cutoff = glm::vec2(
+        cosf(glm::radians(m_light.cutoff[0])),
+        cosf(glm::radians(m_light.cutoff[0] + m_light.cutoff[1])));
+    light.ambient = m_light.ambient;
+    light.diffuse = m_light.diffuse;
+    light.specular = m_light.specular;
+
+    m_cameraFrameBlock = m_uniformStream->Push(&cameraFrame, 1, m_uniformAlignment);
+    m_shadowFrameBlock = m_uniformStream->Push(&shadowFrame, 1, m_uniformAlignment);
+    m_lightBlock = m_uniformStream->Push(&light, 1, m_uniformAlignment);
+    m_uniformStream->Flush();
+}
+
 void Context::ProcessInput(GLFWwindow* window)
 {
     const float cameraSpeed = 0.05f;
@@ -440,7 +683,14 @@ void Context::Reshape(int width, int height)
 {
     m_width = width;
     m_height = height;
-    glViewport(0, 0, width, height);
+    RenderState::Get().SetViewport(0, 0, width, height);
+
+    // 최소화하면 0 이 들어온다
+    if (width > 0 && height > 0)
+    {
+        m_msaaFramebuffer = Framebuffer::CreateMultisample(width, height, m_sampleCount);
+        m_framebuffer = Framebuffer::Create(Texture::Create(width, height, GL_RGBA));
+    }
 }
 
 void Context::MouseMove(double x, double y)
@@ -471,6 +721,23 @@ void Context::MouseMove(double x, double y)
 
 void Context::MouseButton(int button, int action, double x, double y)
 {
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS && !ImGui::GetIO().WantCaptureMouse)
+    {
+        // 화면 좌표를 NDC 로 바꿔 camera 에서 나가는 ray 를 만든다
+        auto ndc = glm::vec2(
+            2.0f * static_cast<float>(x) / m_width - 1.0f,
+            1.0f - 2.0f * static_cast<float>(y) / m_height);
+        auto view = glm::lookAt(m_cameraPos, m_cameraPos + m_cameraDir, m_cameraUp);
+        auto inverseViewProjection = glm::inverse(GetCameraProjection() * view);
+        auto nearPoint = inverseViewProjection * glm::vec4(ndc, -1.0f, 1.0f);
+        auto farPoint = inverseViewProjection * glm::vec4(ndc, 1.0f, 1.0f);
+        auto origin = glm::vec3(nearPoint) / nearPoint.w;
+        auto direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+
+        Bvh::RayHit hit;
+        m_pickedObject = m_sceneBvh->Raycast(origin, direction, 100.0f, hit) ? (int)hit.object : -1;
+    }
+
     if (button == GLFW_MOUSE_BUTTON_RIGHT)
     {
         if (action == GLFW_PRESS)
@@ -485,46 +752,218 @@ void Context::MouseButton(int button, int action, double x, double y)
     }
 }
 
-void Context::DrawScene(const glm::mat4& view, const glm::mat4& projection, const Program* program)
+void Context::InitScene()
 {
-    program->Use();
-    auto modelTransform =
-        glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.5f, 0.0f)) *
-        glm::scale(glm::mat4(1.0f), glm::vec3(40.0f, 1.0f, 40.0f));
+    m_sceneBvh = Bvh::Create();
+    auto AddObject = [this](const Mesh* mesh, const Material* material, const glm::mat4& transform, bool transparent) {
+        m_sceneObjects.push_back({ mesh, material, transform, transparent, 0 });
+        m_sceneBvh->AddObject(mesh->GetBoundingBox().Transform(transform));
+    };
 
-    auto transform = projection * view * modelTransform;
-    program->SetUniform("transform", transform);
-    program->SetUniform("modelTransform", modelTransform);
-    m_planeMaterial->SetToProgram(program);
-    m_box->Draw(program);
+    AddObject(m_box.get(), m_planeMaterial.get(),
+        glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.5f, 0.0f)) *
+        glm::scale(glm::mat4(1.0f), glm::vec3(40.0f, 1.0f, 40.0f)), false);
 
-    modelTransform =
+    AddObject(m_box.get(), m_box1Material.get(),
         glm::translate(glm::mat4(1.0f), glm::vec3(-1.0f, 0.75f, -4.0f)) *
         glm::rotate(glm::mat4(1.0f), glm::radians(30.0f), glm::vec3(0.0f, 1.0f, 0.0f)) *
-        glm::scale(glm::mat4(1.0f), glm::vec3(1.5f, 1.5f, 1.5f));
-    transform = projection * view * modelTransform;
-    program->SetUniform("transform", transform);
-    program->SetUniform("modelTransform", modelTransform);
-    m_box1Material->SetToProgram(program);
-    m_box->Draw(program);
-
-    modelTransform =
+        glm::scale(glm::mat4(1.0f), glm::vec3(1.5f, 1.5f, 1.5f)), false);
+
+    AddObject(m_box.get(), m_box2Material.get(),
         glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.75f, 2.0f)) *
         glm::rotate(glm::mat4(1.0f), glm::radians(20.0f), glm::vec3(0.0f, 1.0f, 0.0f)) *
-        glm::scale(glm::mat4(1.0f), glm::vec3(1.5f, 1.5f, 1.5f));
-    transform = projection * view * modelTransform;
-    program->SetUniform("transform", transform);
-    program->SetUniform("modelTransform", modelTransform);
-    m_box2Material->SetToProgram(program);
-    m_box->Draw(program);
-
-    modelTransform =
+        glm::scale(glm::mat4(1.0f), glm::vec3(1.5f, 1.5f, 1.5f)), false);
+
+    AddObject(m_box.get(), m_box2Material.get(),
         glm::translate(glm::mat4(1.0f), glm::vec3(3.0f, 1.75f, -2.0f)) *
         glm::rotate(glm::mat4(1.0f), glm::radians(50.0f), glm::vec3(0.0f, 1.0f, 0.0f)) *
-        glm::scale(glm::mat4(1.0f), glm::vec3(1.5f, 1.5f, 1.5f));
-    transform = projection * view * modelTransform;
-    program->SetUniform("transform", transform);
-    program->SetUniform("modelTransform", modelTransform);
-    m_box2Material->SetToProgram(program);
-    m_box->Draw(program);
+        glm::scale(glm::mat4(1.0f), glm::vec3(1.5f, 1.5f, 1.5f)), false);
+
+    // blending 예제의 창문
+    AddObject(m_plane.get(), m_windowMaterial.get(),
+        glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.5f, 4.0f)), true);
+    AddObject(m_plane.get(), m_windowMaterial.get(),
+        glm::translate(glm::mat4(1.0f), glm::vec3(0.2f, 0.5f, 5.0f)), true);
+    AddObject(m_plane.get(), m_windowMaterial.get(),
+        glm::translate(glm::mat4(1.0f), glm::vec3(0.4f, 0.5f, 6.0f)), true);
+
+    if (m_model)
+    {
+        auto modelTransform =
+            glm::translate(glm::mat4(1.0f), glm::vec3(-3.5f, 1.0f, 0.0f)) *
+            glm::rotate(glm::mat4(1.0f), glm::radians(30.0f), glm::vec3(0.0f, 1.0f, 0.0f)) *
+            glm::scale(glm::mat4(1.0f), glm::vec3(0.5f));
+        for (int i = 0; i < m_model->GetMeshCount(); ++i)
+            AddObject(m_model->GetMesh(i).get(), nullptr, modelTransform, false);
+    }
+
+    m_sceneBvh->Build();
+}
+
+void Context::BuildRenderQueue(const Program* lightingProgram, const Program* lightingInstancedProgram,
+    const Frustum& cameraFrustum, const Frustum& lightFrustum)
+{
+    // 물체가 움직였으면 refit 한다
+    m_sceneBvh->Update();
+    QueryVisibleObjects(cameraFrustum, m_cameraVisible, m_cameraVisibleCount);
+    QueryVisibleObjects(lightFrustum, m_lightVisible, m_lightVisibleCount);
+
+    // 끝난 occlusion test 가 없으면 지난 결과를 그대로 쓴다
+    m_occluded.resize(m_sceneObjects.size(), 0);
+    if (!m_occlusionCulling)
+        std::fill(m_occluded.begin(), m_occluded.end(), 0);
+    else
+        m_occlusionCuller->ReadResults(m_occluded);
+    m_lateObjects.clear();
+    m_occludedCount = 0;
+
+    // sort key 용 depth, 각 pass 의 far plane 으로 정규화
+    const float cameraFar = 100.0f;
+    const float lightFar = m_light.directional ? 30.0f : m_light.distance;
+    auto lightDir = glm::normalize(m_light.direction);
+    // camera 에서 거리 1 인 곳의 world 길이 1 이 화면에서 차지하는 pixel 수
+    const float pixelsPerUnit = GetCameraProjection()[1][1] * 0.5f * (float)m_height;
+
+    m_renderQueue->Clear();
+    for (size_t i = 0; i < m_sceneObjects.size(); ++i)
+    {
+        auto& object = m_sceneObjects[i];
+        auto position = glm::vec3(object.transform[3]);
+        float cameraDepth = glm::dot(position - m_cameraPos, m_cameraDir) / cameraFar;
+        object.lod = m_lodSelection ? SelectObjectLod(object, pixelsPerUnit) : 0;
+        if (object.transparent)
+        {
+            if (m_cameraVisible[i])
+            {
+                m_renderQueue->Add(RENDER_PASS_TRANSPARENT,
+                    m_transparentProgram.get(), m_transparentInstancedProgram.get(),
+                    object.mesh, object.material, object.transform, cameraDepth);
+            }
+            continue;
+        }
+
+        // light 에서 보이면 화면 밖이어도 그림자는 드리울 수 있다
+        float lightDepth = glm::dot(position - m_light.position, lightDir) / lightFar;
+        uint32_t shadowLod = std::min(object.lod + (uint32_t)m_shadowLodBias, object.mesh->GetLodCount() - 1);
+        if (m_lightVisible[i])
+        {
+            m_renderQueue->Add(RENDER_PASS_SHADOW,
+                m_simpleProgram.get(), m_simpleInstancedProgram.get(),
+                object.mesh, nullptr, object.transform, lightDepth, shadowLod);
+        }
+        if (lightingProgram && m_cameraVisible[i] && m_occluded[i])
+        {
+            // camera 가 box 안에 있으면 box 를 그려 보는 query 가 near plane 에 잘린다
+            if (!m_sceneBvh->GetObjectBounds((uint32_t)i).Contains(m_cameraPos, 0.1f))
+            {
+                m_lateObjects.push_back((uint32_t)i);
+                ++m_occludedCount;
+                continue;
+            }
+        }
+        if (lightingProgram && m_cameraVisible[i])
+        {
+            m_renderQueue->Add(RENDER_PASS_OPAQUE,
+                lightingProgram, lightingInstancedProgram,
+                object.mesh, object.material, object.transform, cameraDepth, object.lod);
+        }
+    }
+    m_renderQueue->Sort();
+}
+
+uint32_t Context::SelectObjectLod(const SceneObject& object, float pixelsPerUnit) const
+{
+    if (object.mesh->GetLodCount() < 2)
+        return 0;
+
+    // bounding sphere 의 가장 가까운 점까지의 거리로 화면 크기를 어림한다
+    const auto& sphere = object.mesh->GetBoundingSphere();
+    auto worldSphere = sphere.Transform(object.transform);
+    float distance = glm::distance(m_cameraPos, worldSphere.center) - worldSphere.radius;
+    const float nearPlane = 0.1f;
+    float scale = sphere.radius > 0.0f ? worldSphere.radius / sphere.radius : 1.0f;
+    float localPixelsPerUnit = pixelsPerUnit * scale / std::max(distance, nearPlane);
+    return object.mesh->SelectLod(localPixelsPerUnit, m_lodPixelError, m_lodHysteresis, object.lod);
+}
+
+void Context::QueryVisibleObjects(const Frustum& frustum, std::vector<uint8_t>& visible, uint32_t& visibleCount)
+{
+    if (!m_frustumCulling)
+    {
+        visible.assign(m_sceneObjects.size(), 1);
+        visibleCount = (uint32_t)m_sceneObjects.size();
+        return;
+    }
+
+    m_visibleObjects.clear();
+    m_sceneBvh->QueryFrustum(frustum, m_visibleObjects);
+    visible.assign(m_sceneObjects.size(), 0);
+    for (auto object : m_visibleObjects)
+        visible[object] = 1;
+    visibleCount = (uint32_t)m_visibleObjects.size();
+}
+
+void Context::RenderLateObjects(const Program* lightingProgram)
+{
+    if (m_lateObjects.empty() || !lightingProgram)
+        return;
+    while (m_lateQueries.size() < m_lateObjects.size())
+    {
+        uint32_t query = 0;
+        glGenQueries(1, &query);
+        m_lateQueries.push_back(query);
+    }
+
+    // 첫 pass 의 depth 에 bounding box 를 그려서 한 fragment 라도 통과하는지 본다
+    auto& renderState = RenderState::Get();
+    DepthState depthState;
+    depthState.write = false;
+    renderState.SetDepthState(depthState);
+    BlendState blendState;
+    blendState.colorWrite = false;
+    renderState.SetBlendState(blendState);
+    m_simpleProgram->Use();
+    for (size_t i = 0; i < m_lateObjects.size(); ++i)
+    {
+        const auto& box = m_sceneBvh->GetObjectBounds(m_lateObjects[i]);
+        auto boxTransform =
+            glm::translate(glm::mat4(1.0f), box.GetCenter()) *
+            glm::scale(glm::mat4(1.0f), box.GetExtents() * 2.0f);
+        m_simpleProgram->SetUniform(s_modelTransform, boxTransform);
+        glBeginQuery(GL_ANY_SAMPLES_PASSED, m_lateQueries[i]);
+        m_box->Draw(m_simpleProgram.get());
+        glEndQuery(GL_ANY_SAMPLES_PASSED);
+    }
+
+    // query 결과는 GPU 에서 바로 쓰므로 CPU 는 기다리지 않는다
+    renderState.SetDepthState(DepthState());
+    renderState.SetBlendState(BlendState());
+    lightingProgram->Use();
+    for (size_t i = 0; i < m_lateObjects.size(); ++i)
+    {
+        const auto& object = m_sceneObjects[m_lateObjects[i]];
+        glBeginConditionalRender(m_lateQueries[i], GL_QUERY_WAIT);
+        if (object.material)
+            object.material->SetToProgram(lightingProgram);
+        lightingProgram->SetUniform(s_modelTransform, object.transform);
+        object.mesh->Draw(lightingProgram, object.lod);
+        glEndConditionalRender();
+    }
+}
+
+glm::mat4 Context::GetCameraProjection() const
+{
+    return glm::perspective(glm::radians(45.0f),
+        static_cast<float>(m_width) / static_cast<float>(m_height), 0.1f, 100.0f);
+}
+
+uint32_t Context::GetLightingPermutationKey() const
+{
+    uint32_t key = 0;
+    if (m_light.directional)
+        key |= LIGHTING_KEY_DIRECTIONAL;
+    if (m_light.blinn)
+        key |= LIGHTING_KEY_BLINN;
+    key |= ((uint32_t)m_light.pcfRadius & LIGHTING_KEY_PCF_MASK) << LIGHTING_KEY_PCF_SHIFT;
+    return key;
 }
\ No newline at end of file
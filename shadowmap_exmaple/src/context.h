@@ -4,13 +4,26 @@
 #include "common.h"
 #include "shader.h"
 #include "program.h"
+#include "program_variants.h"
+#include "program_binary_cache.h"
 #include "buffer.h"
 #include "vertex_layout.h"
 #include "texture.h"
+#include "texture_cache.h"
 #include "mesh.h"
 #include "model.h"
 #include "framebuffer.h"
 #include "shadow_map.h"
+#include "uniform_block.h"
+#include "render_state.h"
+#include "render_queue.h"
+#include "instanced_mesh.h"
+#include "stream_buffer.h"
+#include "instance_culler.h"
+#include "bvh.h"
+#include "culling_benchmark.h"
+#include "depth_pyramid.h"
+#include "occlusion_culler.h"
 
 CLASS_PTR(Context)
 class Context
@@ -23,11 +36,21 @@ public:
     void MouseMove(double x, double y);
     void MouseButton(int button, int action, double x, double y);
 
-    void DrawScene(const glm::mat4& view, const glm::mat4& proj, const Program* program);
-    
 private:
     Context() {}
     bool Init();
+    void UpdateUniformBlocks(
+        const glm::mat4& view, const glm::mat4& projection,
+        const glm::mat4& lightView, const glm::mat4& lightProjection);
+    uint32_t GetLightingPermutationKey() const;
+    void InitScene();
+    void BuildRenderQueue(const Program* lightingProgram, const Program* lightingInstancedProgram,
+        const Frustum& cameraFrustum, const Frustum& lightFrustum);
+    void QueryVisibleObjects(const Frustum& frustum, std::vector<uint8_t>& visible, uint32_t& visibleCount);
+    struct SceneObject;
+    uint32_t SelectObjectLod(const SceneObject& object, float pixelsPerUnit) const;
+    glm::mat4 GetCameraProjection() const;
+    void RenderLateObjects(const Program* lightingProgram);
     
     ProgramUPtr m_program;
     ProgramUPtr m_simpleProgram;
@@ -36,32 +59,105 @@ private:
     ProgramUPtr m_skyboxProgram;
     ProgramUPtr m_envMapProgram;
     ProgramUPtr m_grassProgram;
-    ProgramUPtr m_lightingShadowProgram;
-
+    // culling 된 grass point 를 geometry shader 로 펼쳐 그린다
+    ProgramUPtr m_grassPointProgram;
+    ProgramUPtr m_transparentProgram;
+    // render queue 의 automatic instancing 용, INSTANCED define 으로 compile
+    ProgramUPtr m_simpleInstancedProgram;
+    ProgramUPtr m_transparentInstancedProgram;
+    // lighting + shadow program 은 light 설정 조합마다 따로 compile
+    ProgramVariantsUPtr m_lightingShadowVariants;
+
+    // asset import 의 texture decode, mesh 변환용 worker
+    ThreadPoolUPtr m_threadPool;
+    TextureStreamerUPtr m_textureStreamer;
+    TextureCacheUPtr m_textureCache;
+    // vertex format 별로 scene mesh 를 모아 담는 buffer
+    GeometryPoolPtr m_geometryPools[VERTEX_FORMAT_COUNT];
     MeshUPtr m_box;
-    MeshUPtr m_plane;
-    //ModelUPtr m_model;
+    MeshPtr m_plane;
+    // model 파일이 없으면 null, scene 에 넣지 않는다
+    ModelUPtr m_model;
 
     MaterialUPtr m_planeMaterial;
     MaterialUPtr m_box1Material;
     MaterialUPtr m_box2Material;
+    MaterialUPtr m_windowMaterial;
+
+    // 매 frame render queue 에 들어가는 scene 의 물체들
+    struct SceneObject
+    {
+        const Mesh* mesh;
+        const Material* material;
+        glm::mat4 transform;
+        bool transparent;
+        // 지난 frame 에 고른 lod, hysteresis 에 쓴다
+        uint32_t lod;
+    };
+    std::vector<SceneObject> m_sceneObjects;
+    // 화면에서 오차가 m_lodPixelError pixel 을 넘지 않는 가장 거친 lod 를 고르고
+    // shadow pass 는 거기서 m_shadowLodBias 단계 더 거친 lod 를 쓴다
+    bool m_lodSelection { true };
+    float m_lodPixelError { 1.0f };
+    float m_lodHysteresis { 0.25f };
+    int m_shadowLodBias { 1 };
+    // object id 가 m_sceneObjects 의 index 와 같다
+    BvhUPtr m_sceneBvh;
+    bool m_frustumCulling { true };
+    std::vector<uint32_t> m_visibleObjects;
+    std::vector<uint8_t> m_cameraVisible;
+    std::vector<uint8_t> m_lightVisible;
+    uint32_t m_cameraVisibleCount { 0 };
+    uint32_t m_lightVisibleCount { 0 };
+    // 왼쪽 click 으로 고른 물체, 없으면 -1
+    int m_pickedObject { -1 };
+    std::vector<CullingBenchmarkResult> m_cullingBenchmark;
+
+    // 이전 frame depth 로 만든 pyramid 에 가려진다고 나온 물체는 먼저 그리지 않고
+    // 첫 pass 의 depth 에 box 를 그려 본 (occlusion query) 뒤 조건부로 그린다
+    DepthPyramidUPtr m_depthPyramid;
+    OcclusionCullerUPtr m_occlusionCuller;
+    bool m_occlusionCulling { true };
+    std::vector<uint8_t> m_occluded;
+    std::vector<BoundingBox> m_occlusionBoxes;
+    std::vector<uint32_t> m_lateObjects;
+    std::vector<uint32_t> m_lateQueries;
+    uint32_t m_occludedCount { 0 };
+    RenderQueueUPtr m_renderQueue;
     
     TexturePtr m_windowTexture;
     TextureUPtr m_texture;
     TextureUPtr m_texture2;
     CubeTextureUPtr m_cubeTexture;
-    TextureUPtr m_grassTexture;
+    TexturePtr m_grassTexture;
 
-    BufferUPtr m_grassPosBuffer;
-    VertexLayoutUPtr m_grassInstance;
+    InstancedMeshUPtr m_grassInstance;
+    InstanceStream<glm::vec3> m_grassPosStream;
+    InstanceCullerUPtr m_grassCuller;
+    bool m_grassCulling { true };
+    float m_grassCullDistance { 20.0f };
 
+    // 장면은 m_msaaFramebuffer 에 그리고 m_framebuffer 로 풀어서 depth pyramid 와 화면 복사에 쓴다
+    FramebufferUPtr m_msaaFramebuffer;
     FramebufferUPtr m_framebuffer;
+    int m_sampleCount { 16 };
     float m_gamma = { 1.0f };
     std::vector<glm::vec3> m_grassPos;
 
     // shadow map
     ShadowMapUPtr m_shadowMap;
 
+    // frame 마다 새로 쓰는 uniform block / instance data
+    StreamBufferPtr m_uniformStream;
+    StreamBufferPtr m_instanceStream;
+    size_t m_uniformAlignment { 1 };
+    StreamBuffer::Allocation m_cameraFrameBlock;
+    StreamBuffer::Allocation m_shadowFrameBlock;
+    StreamBuffer::Allocation m_lightBlock;
+
+    // 지난 frame 의 state 변경 통계
+    RenderState::Stats m_renderStateStats;
+
     // camera parameter
     glm::vec3 m_cameraPos { glm::vec3(0.0f, 2.5f, 8.0f) };
     glm::vec3 m_cameraDir { glm::vec3(0.0f, 0.0f, -1.0f) };
@@ -109,6 +205,7 @@ private:
         glm::vec3 specular { glm::vec3(1.0f, 1.0f, 1.0f) };
 
         bool blinn { true };
+        int pcfRadius { 1 };
     };
     Light m_light;
 };
@@ -0,0 +1,73 @@
+#include "culling_benchmark.h"
+#include "bvh.h"
+#include "frustum_culler.h"
+#include <glm/gtc/random.hpp>
+#include <chrono>
+
+static const int QUERY_REPEAT = 20;
+
+static double ToMilliseconds(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+std::vector<CullingBenchmarkResult> RunCullingBenchmark(const std::vector<uint32_t>& objectCounts)
+{
+    // 장면 크기를 개수에 맞춰 늘려 밀도를 비슷하게 유지한다
+    auto view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    auto projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    auto frustum = Frustum::FromMatrix(projection * view);
+
+    std::vector<CullingBenchmarkResult> results;
+    for (auto objectCount : objectCounts)
+    {
+        float halfSize = 4.0f * std::cbrt((float)objectCount);
+        auto bvh = Bvh::Create();
+        auto culler = FrustumCuller::Create();
+        for (uint32_t i = 0; i < objectCount; ++i)
+        {
+            auto center = glm::linearRand(glm::vec3(-halfSize), glm::vec3(halfSize));
+            auto extents = glm::linearRand(glm::vec3(0.1f), glm::vec3(1.0f));
+            BoundingBox box;
+            box.min = center - extents;
+            box.max = center + extents;
+            bvh->AddObject(box);
+            // 구 반지름을 크게 줘서 box 만으로 test 하게 맞춘다
+            culler->Add(box, FLT_MAX);
+        }
+
+        CullingBenchmarkResult result;
+        result.objectCount = objectCount;
+
+        auto buildBegin = std::chrono::steady_clock::now();
+        bvh->Build();
+        result.buildMs = ToMilliseconds(std::chrono::steady_clock::now() - buildBegin);
+
+        std::vector<uint32_t> visibleObjects;
+        visibleObjects.reserve(objectCount);
+        auto bvhBegin = std::chrono::steady_clock::now();
+        for (int i = 0; i < QUERY_REPEAT; ++i)
+        {
+            visibleObjects.clear();
+            bvh->QueryFrustum(frustum, visibleObjects);
+        }
+        result.bvhQueryMs = ToMilliseconds(std::chrono::steady_clock::now() - bvhBegin) / QUERY_REPEAT;
+
+        std::vector<uint8_t> visible;
+        FrustumCuller::Stats stats;
+        auto bruteForceBegin = std::chrono::steady_clock::now();
+        for (int i = 0; i < QUERY_REPEAT; ++i)
+            stats = culler->Cull(frustum, visible);
+        result.bruteForceMs = ToMilliseconds(std::chrono::steady_clock::now() - bruteForceBegin) / QUERY_REPEAT;
+
+        result.visibleCount = (uint32_t)visibleObjects.size();
+        if (stats.visibleCount != result.visibleCount)
+        {
+            SPDLOG_ERROR("culling mismatch: bvh {} / brute force {} visible", result.visibleCount, stats.visibleCount);
+        }
+        SPDLOG_INFO("culling {:>6} objects ({:>6} visible): bvh build {:.3f}ms, bvh query {:.3f}ms, brute force {:.3f}ms, sah {:.2f}",
+            objectCount, result.visibleCount, result.buildMs, result.bvhQueryMs, result.bruteForceMs, bvh->ComputeSahCost());
+        results.push_back(result);
+    }
+    return results;
+}
\ No newline at end of file
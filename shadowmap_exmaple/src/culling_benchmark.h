@@ -0,0 +1,21 @@
+#ifndef __CULLING_BENCHMARK_H__
+#define __CULLING_BENCHMARK_H__
+
+#include "common.h"
+#include <vector>
+
+struct CullingBenchmarkResult
+{
+    uint32_t objectCount { 0 };
+    uint32_t visibleCount { 0 };
+    double buildMs { 0.0 };
+    // query 한번의 평균
+    double bvhQueryMs { 0.0 };
+    double bruteForceMs { 0.0 };
+};
+
+// 물체 개수마다 임의의 box 를 흩어놓고 같은 camera frustum 으로
+// Bvh::QueryFrustum 과 FrustumCuller (전체 SIMD test) 를 비교해 log 로 남긴다
+std::vector<CullingBenchmarkResult> RunCullingBenchmark(const std::vector<uint32_t>& objectCounts);
+
+#endif // __CULLING_BENCHMARK_H__
\ No newline at end of file
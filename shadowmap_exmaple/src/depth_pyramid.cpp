@@ -0,0 +1,119 @@
+#include "depth_pyramid.h"
+#include "render_state.h"
+
+static const UniformHandle<int> s_source("source");
+
+DepthPyramidUPtr DepthPyramid::Create()
+{
+    auto pyramid = DepthPyramidUPtr(new DepthPyramid());
+    if (!pyramid->Init())
+        return nullptr;
+    return std::move(pyramid);
+}
+
+DepthPyramid::~DepthPyramid()
+{
+    if (m_framebuffer)
+    {
+        RenderState::Get().OnDeleteFramebuffer(m_framebuffer);
+        glDeleteFramebuffers(1, &m_framebuffer);
+    }
+    if (m_texture)
+    {
+        RenderState::Get().OnDeleteTexture(m_texture);
+        glDeleteTextures(1, &m_texture);
+    }
+}
+
+bool DepthPyramid::Init()
+{
+    m_copyDepthProgram = Program::Create("/fullscreen.vs", "/hiz_reduce.fs", { { "FROM_DEPTH", "1" } });
+    m_reduceProgram = Program::Create("/fullscreen.vs", "/hiz_reduce.fs");
+    if (!m_copyDepthProgram || !m_reduceProgram)
+        return false;
+
+    // core profile 은 vertex attribute 가 없어도 VAO 가 bind 되어 있어야 그릴 수 있다
+    m_emptyLayout = VertexLayout::Create();
+    glGenFramebuffers(1, &m_framebuffer);
+    return true;
+}
+
+void DepthPyramid::Allocate(int width, int height)
+{
+    auto& renderState = RenderState::Get();
+    if (m_texture)
+    {
+        renderState.OnDeleteTexture(m_texture);
+        glDeleteTextures(1, &m_texture);
+    }
+
+    m_width = width;
+    m_height = height;
+    m_levelCount = Texture::GetMipLevelCount(width, height);
+
+    glGenTextures(1, &m_texture);
+    renderState.BindTexture(GL_TEXTURE_2D, m_texture);
+    Texture::AllocateStorage(GL_TEXTURE_2D, m_levelCount, GL_RG32F, width, height, GL_RG, GL_FLOAT);
+
+    // unit 에 bind 된 sampler 가 texture parameter 보다 우선하므로 filter 도 sampler 로 준다
+    if (!m_sampler)
+    {
+        auto samplerState = SamplerState::Nearest();
+        samplerState.minFilter = GL_NEAREST_MIPMAP_NEAREST;
+        m_sampler = SamplerCache::Get().GetSampler(samplerState);
+    }
+}
+
+void DepthPyramid::Build(const Texture* depthTexture)
+{
+    if (depthTexture->GetWidth() != m_width || depthTexture->GetHeight() != m_height)
+        Allocate(depthTexture->GetWidth(), depthTexture->GetHeight());
+
+    auto& renderState = RenderState::Get();
+    renderState.BindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    DepthState depthState;
+    depthState.test = false;
+    depthState.write = false;
+    renderState.SetDepthState(depthState);
+    renderState.SetBlendState(BlendState());
+    m_emptyLayout->Bind();
+
+    for (int level = 0; level < m_levelCount; ++level)
+    {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture, level);
+        renderState.SetViewport(0, 0, std::max(m_width >> level, 1), std::max(m_height >> level, 1));
+
+        const Program* program = level == 0 ? m_copyDepthProgram.get() : m_reduceProgram.get();
+        program->Use();
+        program->SetUniform(s_source, 0);
+        if (level == 0)
+        {
+            depthTexture->Bind(0);
+        }
+        else
+        {
+            // 쓰는 level 은 보이지 않게 해서 feedback loop 를 피한다
+            SetVisibleLevels(level - 1, level - 1);
+        }
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    SetVisibleLevels(0, m_levelCount - 1);
+}
+
+void DepthPyramid::SetVisibleLevels(int baseLevel, int maxLevel) const
+{
+    // glTexParameteri 는 active unit 의 texture 에 적용된다
+    auto& renderState = RenderState::Get();
+    renderState.ActiveTexture(0);
+    renderState.BindTexture(0, GL_TEXTURE_2D, m_texture);
+    renderState.BindSampler(0, m_sampler);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, baseLevel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, maxLevel);
+}
+
+void DepthPyramid::Bind(uint32_t unit) const
+{
+    auto& renderState = RenderState::Get();
+    renderState.BindTexture(unit, GL_TEXTURE_2D, m_texture);
+    renderState.BindSampler(unit, m_sampler);
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef __DEPTH_PYRAMID_H__
+#define __DEPTH_PYRAMID_H__
+
+#include "common.h"
+#include "texture.h"
+#include "program.h"
+#include "vertex_layout.h"
+
+// depth buffer 의 mip chain. level 마다 2x2 (홀수 크기면 3 까지) texel 의
+// 가장 먼 depth 를 r, 가장 가까운 depth 를 g 에 담는다 (RG32F)
+// level 0 은 depth buffer 와 크기가 같고 마지막 level 은 1x1
+//
+// 각 level 은 fullscreen 삼각형 하나로 바로 위 level 을 읽어 만든다
+// 같은 texture 를 읽고 쓰므로 읽는 level 만 보이게 base / max level 을 맞춘다
+CLASS_PTR(DepthPyramid)
+class DepthPyramid
+{
+public:
+    static DepthPyramidUPtr Create();
+    ~DepthPyramid();
+
+    // depth texture 크기가 바뀌면 다시 할당한다. framebuffer / viewport 는 바뀐 채로 남는다
+    void Build(const Texture* depthTexture);
+
+    uint32_t Get() const { return m_texture; }
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    int GetLevelCount() const { return m_levelCount; }
+    void Bind(uint32_t unit) const;
+
+private:
+    DepthPyramid() {}
+    bool Init();
+    void Allocate(int width, int height);
+    void SetVisibleLevels(int baseLevel, int maxLevel) const;
+
+    uint32_t m_texture { 0 };
+    uint32_t m_framebuffer { 0 };
+    int m_width { 0 };
+    int m_height { 0 };
+    int m_levelCount { 0 };
+    uint32_t m_sampler { 0 };
+
+    ProgramUPtr m_copyDepthProgram;
+    ProgramUPtr m_reduceProgram;
+    VertexLayoutUPtr m_emptyLayout;
+};
+
+#endif // __DEPTH_PYRAMID_H__
\ No newline at end of file
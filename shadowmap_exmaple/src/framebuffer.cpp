@@ -1,4 +1,6 @@
 #include "framebuffer.h"
+#include "render_state.h"
+#include <algorithm>
 
 FramebufferUPtr Framebuffer::Create(const TexturePtr colorAttachment)
 {
@@ -8,39 +10,92 @@ FramebufferUPtr Framebuffer::Create(const TexturePtr colorAttachment)
     return std::move(framebuffer);
 }
 
+FramebufferUPtr Framebuffer::CreateMultisample(int width, int height, int sampleCount)
+{
+    auto framebuffer = FramebufferUPtr(new Framebuffer());
+    if (!framebuffer->InitMultisample(width, height, sampleCount))
+        return nullptr;
+    return std::move(framebuffer);
+}
+
 void Framebuffer::BindToDefault()
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    RenderState::Get().BindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 Framebuffer::~Framebuffer()
 {
     if (m_framebuffer != 0)
+    {
+        RenderState::Get().OnDeleteFramebuffer(m_framebuffer);
         glDeleteFramebuffers(1, &m_framebuffer);
-    if (m_depthStencilBuffer != 0)
-        glDeleteRenderbuffers(1, &m_depthStencilBuffer);
+    }
+    if (m_colorRenderbuffer != 0)
+        glDeleteRenderbuffers(1, &m_colorRenderbuffer);
+    if (m_depthStencilRenderbuffer != 0)
+        glDeleteRenderbuffers(1, &m_depthStencilRenderbuffer);
 }
 
 void Framebuffer::Bind() const
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    RenderState::Get().BindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+}
+
+void Framebuffer::ResolveTo(const Framebuffer* target, uint32_t mask) const
+{
+    auto& renderState = RenderState::Get();
+    renderState.BindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+    renderState.BindFramebuffer(GL_DRAW_FRAMEBUFFER, target->Get());
+    // multisample 에서 풀 때는 크기가 같아야 하고 depth / stencil 은 GL_NEAREST 만 된다
+    glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, mask, GL_NEAREST);
 }
 
 bool Framebuffer::InitWithColorAttachment(const TexturePtr colorAttachment)
 {
     m_colorAttachment = colorAttachment;
+    m_width = m_colorAttachment->GetWidth();
+    m_height = m_colorAttachment->GetHeight();
 
     glGenFramebuffers(1, &m_framebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    Bind();
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_colorAttachment->Get(), 0);
 
-    glGenRenderbuffers(1, &m_depthStencilBuffer);
-    glBindRenderbuffer(GL_RENDERBUFFER, m_depthStencilBuffer);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_colorAttachment->GetWidth(), m_colorAttachment->GetHeight());    
+    m_depthStencilAttachment = Texture::Create(m_colorAttachment->GetWidth(), m_colorAttachment->GetHeight(),
+        GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8);
+    m_depthStencilAttachment->SetSampler(SamplerState::Nearest());
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_depthStencilAttachment->Get(), 0);
+
+    return CheckStatus();
+}
+
+bool Framebuffer::InitMultisample(int width, int height, int sampleCount)
+{
+    int maxSamples = 1;
+    glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+    m_width = width;
+    m_height = height;
+    m_sampleCount = std::max(std::min(sampleCount, maxSamples), 1);
+
+    glGenFramebuffers(1, &m_framebuffer);
+    Bind();
+
+    // depth 는 ResolveTo 로 Create 한 framebuffer 의 depth texture 에 복사되므로 같은 format 으로 만든다
+    glGenRenderbuffers(1, &m_colorRenderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_colorRenderbuffer);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, m_sampleCount, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorRenderbuffer);
+
+    glGenRenderbuffers(1, &m_depthStencilRenderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depthStencilRenderbuffer);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, m_sampleCount, GL_DEPTH24_STENCIL8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthStencilRenderbuffer);
     glBindRenderbuffer(GL_RENDERBUFFER, 0);
 
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthStencilBuffer);
+    return CheckStatus();
+}
 
+bool Framebuffer::CheckStatus()
+{
     auto result = glCheckFramebufferStatus(GL_FRAMEBUFFER);
     if (result != GL_FRAMEBUFFER_COMPLETE)
     {
@@ -8,20 +8,37 @@ class Framebuffer
 {
 public:
     static FramebufferUPtr Create(TexturePtr colorAttachment);
+    // shader 에서 읽지 않고 ResolveTo 로만 꺼내 쓰는 multisample framebuffer. attachment 는 renderbuffer 다
+    // sampleCount 는 GL_MAX_SAMPLES 로 잘린다
+    static FramebufferUPtr CreateMultisample(int width, int height, int sampleCount);
     static void BindToDefault();
     ~Framebuffer();
 
     const uint32_t Get() const { return m_framebuffer; }
     void Bind() const;
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    int GetSampleCount() const { return m_sampleCount; }
+    // 같은 크기의 target 으로 blit 해서 sample 을 하나로 합친다. depth / stencil 은 format 이 같아야 한다
+    void ResolveTo(const Framebuffer* target, uint32_t mask) const;
     const TexturePtr GetColorAttachment() const { return m_colorAttachment; }
+    // depth 를 shader 에서 읽을 수 있도록 renderbuffer 대신 texture 를 쓴다
+    const TexturePtr GetDepthStencilAttachment() const { return m_depthStencilAttachment; }
 
 private:
     Framebuffer() {}
     bool InitWithColorAttachment(const TexturePtr colorAttachment);
+    bool InitMultisample(int width, int height, int sampleCount);
+    bool CheckStatus();
     
     uint32_t m_framebuffer { 0 };
-    uint32_t m_depthStencilBuffer { 0 };
     TexturePtr m_colorAttachment;
+    TexturePtr m_depthStencilAttachment;
+    uint32_t m_colorRenderbuffer { 0 };
+    uint32_t m_depthStencilRenderbuffer { 0 };
+    int m_width { 0 };
+    int m_height { 0 };
+    int m_sampleCount { 1 };
 };
 
 #endif // __FRAMEBUFFER_H__
\ No newline at end of file
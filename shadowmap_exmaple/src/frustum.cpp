@@ -0,0 +1,33 @@
+#include "frustum.h"
+
+// Gribb / Hartmann: clip space 의 -w <= x, y, z <= w 를 world space 평면으로
+Frustum Frustum::FromMatrix(const glm::mat4& viewProjection)
+{
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i],
+            viewProjection[2][i], viewProjection[3][i]);
+    }
+
+    Frustum frustum;
+    frustum.planes[PLANE_LEFT] = rows[3] + rows[0];
+    frustum.planes[PLANE_RIGHT] = rows[3] - rows[0];
+    frustum.planes[PLANE_BOTTOM] = rows[3] + rows[1];
+    frustum.planes[PLANE_TOP] = rows[3] - rows[1];
+    frustum.planes[PLANE_NEAR] = rows[3] + rows[2];
+    frustum.planes[PLANE_FAR] = rows[3] - rows[2];
+    for (auto& plane : frustum.planes)
+        plane /= glm::length(glm::vec3(plane));
+    return frustum;
+}
+
+bool Frustum::IntersectsSphere(const glm::vec3& center, float radius) const
+{
+    for (const auto& plane : planes)
+    {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+            return false;
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#ifndef __FRUSTUM_H__
+#define __FRUSTUM_H__
+
+#include "common.h"
+
+// view-projection matrix 에서 뽑은 6 개의 평면
+// plane.xyz 는 안쪽을 향하는 단위 normal, dot(plane.xyz, p) + plane.w >= 0 이면 안쪽
+struct Frustum
+{
+    enum PlaneIndex
+    {
+        PLANE_LEFT,
+        PLANE_RIGHT,
+        PLANE_BOTTOM,
+        PLANE_TOP,
+        PLANE_NEAR,
+        PLANE_FAR,
+        PLANE_COUNT,
+    };
+
+    glm::vec4 planes[PLANE_COUNT];
+
+    static Frustum FromMatrix(const glm::mat4& viewProjection);
+    bool IntersectsSphere(const glm::vec3& center, float radius) const;
+};
+
+#endif // __FRUSTUM_H__
\ No newline at end of file
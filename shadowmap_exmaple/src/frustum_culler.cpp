@@ -0,0 +1,176 @@
+#include "frustum_culler.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_CULLER_SSE 1
+#include <emmintrin.h>
+#else
+#define FRUSTUM_CULLER_SSE 0
+#endif
+
+static const size_t SIMD_WIDTH = 4;
+
+#if FRUSTUM_CULLER_SSE
+struct FrustumCuller::SimdPlane
+{
+    __m128 x, y, z, w;
+    __m128 absX, absY, absZ;
+};
+
+static void SplatPlanes(const glm::vec4* planes, int planeCount, FrustumCuller::SimdPlane* simdPlanes)
+{
+    for (int p = 0; p < planeCount; ++p)
+    {
+        const auto& plane = planes[p];
+        auto& simdPlane = simdPlanes[p];
+        simdPlane.x = _mm_set1_ps(plane.x);
+        simdPlane.y = _mm_set1_ps(plane.y);
+        simdPlane.z = _mm_set1_ps(plane.z);
+        simdPlane.w = _mm_set1_ps(plane.w);
+        simdPlane.absX = _mm_set1_ps(std::abs(plane.x));
+        simdPlane.absY = _mm_set1_ps(std::abs(plane.y));
+        simdPlane.absZ = _mm_set1_ps(std::abs(plane.z));
+    }
+}
+
+int FrustumCuller::GetOutsideMask(const SimdPlane* planes, int planeCount, size_t index) const
+{
+    __m128 centerX = _mm_loadu_ps(&m_centerX[index]);
+    __m128 centerY = _mm_loadu_ps(&m_centerY[index]);
+    __m128 centerZ = _mm_loadu_ps(&m_centerZ[index]);
+    __m128 extentX = _mm_loadu_ps(&m_extentX[index]);
+    __m128 extentY = _mm_loadu_ps(&m_extentY[index]);
+    __m128 extentZ = _mm_loadu_ps(&m_extentZ[index]);
+    __m128 radius = _mm_loadu_ps(&m_radius[index]);
+
+    const __m128 zero = _mm_setzero_ps();
+    __m128 outside = zero;
+    for (int p = 0; p < planeCount; ++p)
+    {
+        const auto& plane = planes[p];
+        __m128 distance = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(plane.x, centerX), _mm_mul_ps(plane.y, centerY)),
+            _mm_add_ps(_mm_mul_ps(plane.z, centerZ), plane.w));
+        __m128 boxRadius = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(plane.absX, extentX), _mm_mul_ps(plane.absY, extentY)),
+            _mm_mul_ps(plane.absZ, extentZ));
+        __m128 reach = _mm_add_ps(distance, _mm_min_ps(boxRadius, radius));
+        outside = _mm_or_ps(outside, _mm_cmplt_ps(reach, zero));
+    }
+    return _mm_movemask_ps(outside);
+}
+#endif
+
+bool FrustumCuller::IsOutside(const glm::vec4* planes, int planeCount, size_t index) const
+{
+    auto center = glm::vec3(m_centerX[index], m_centerY[index], m_centerZ[index]);
+    auto extents = glm::vec3(m_extentX[index], m_extentY[index], m_extentZ[index]);
+    for (int p = 0; p < planeCount; ++p)
+    {
+        auto normal = glm::vec3(planes[p]);
+        float boxRadius = glm::dot(glm::abs(normal), extents);
+        if (glm::dot(normal, center) + planes[p].w + std::min(boxRadius, m_radius[index]) < 0.0f)
+            return true;
+    }
+    return false;
+}
+
+FrustumCullerUPtr FrustumCuller::Create()
+{
+    return FrustumCullerUPtr(new FrustumCuller());
+}
+
+void FrustumCuller::Clear()
+{
+    for (auto array : { &m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ, &m_radius })
+        array->clear();
+    m_count = 0;
+}
+
+uint32_t FrustumCuller::Add(const BoundingBox& box, float radius)
+{
+    uint32_t index = (uint32_t)m_count++;
+    size_t paddedCount = m_count + SIMD_WIDTH - 1;
+    for (auto array : { &m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ, &m_radius })
+        array->resize(paddedCount, 0.0f);
+    Update(index, box, radius);
+    return index;
+}
+
+void FrustumCuller::Update(uint32_t index, const BoundingBox& box, float radius)
+{
+    auto center = box.GetCenter();
+    auto extents = box.GetExtents();
+    m_centerX[index] = center.x;
+    m_centerY[index] = center.y;
+    m_centerZ[index] = center.z;
+    m_extentX[index] = extents.x;
+    m_extentY[index] = extents.y;
+    m_extentZ[index] = extents.z;
+    m_radius[index] = radius;
+}
+
+FrustumCuller::Stats FrustumCuller::Cull(const Frustum& frustum, std::vector<uint8_t>& visible) const
+{
+    visible.resize(m_count);
+    size_t i = 0;
+
+#if FRUSTUM_CULLER_SSE
+    SimdPlane simdPlanes[Frustum::PLANE_COUNT];
+    SplatPlanes(frustum.planes, Frustum::PLANE_COUNT, simdPlanes);
+    for (; i < m_count; i += SIMD_WIDTH)
+    {
+        int mask = GetOutsideMask(simdPlanes, Frustum::PLANE_COUNT, i);
+        size_t laneCount = std::min(SIMD_WIDTH, m_count - i);
+        for (size_t lane = 0; lane < laneCount; ++lane)
+            visible[i + lane] = (mask & (1 << lane)) ? 0 : 1;
+    }
+#endif
+
+    for (; i < m_count; ++i)
+        visible[i] = IsOutside(frustum.planes, Frustum::PLANE_COUNT, i) ? 0 : 1;
+
+    Stats stats;
+    for (size_t index = 0; index < m_count; ++index)
+        stats.visibleCount += visible[index];
+    stats.culledCount = (uint32_t)m_count - stats.visibleCount;
+    return stats;
+}
+
+void FrustumCuller::CullRange(const Frustum& frustum, uint32_t planeMask, uint32_t first, uint32_t count,
+    const uint32_t* ids, std::vector<uint32_t>& result) const
+{
+    glm::vec4 planes[Frustum::PLANE_COUNT];
+    int planeCount = 0;
+    for (int p = 0; p < Frustum::PLANE_COUNT; ++p)
+    {
+        if (planeMask & (1u << p))
+            planes[planeCount++] = frustum.planes[p];
+    }
+    auto Append = [&](uint32_t index) {
+        result.push_back(ids ? ids[index] : index);
+    };
+
+    uint32_t i = first;
+    uint32_t end = first + count;
+#if FRUSTUM_CULLER_SSE
+    SimdPlane simdPlanes[Frustum::PLANE_COUNT];
+    SplatPlanes(planes, planeCount, simdPlanes);
+    for (; i < end; i += SIMD_WIDTH)
+    {
+        // 범위 밖 lane 은 이웃 node 의 물체이거나 padding 이므로 버린다
+        int mask = GetOutsideMask(simdPlanes, planeCount, i);
+        uint32_t laneCount = std::min((uint32_t)SIMD_WIDTH, end - i);
+        for (uint32_t lane = 0; lane < laneCount; ++lane)
+        {
+            if (!(mask & (1 << lane)))
+                Append(i + lane);
+        }
+    }
+#endif
+
+    for (; i < end; ++i)
+    {
+        if (!IsOutside(planes, planeCount, i))
+            Append(i);
+    }
+}
\ No newline at end of file
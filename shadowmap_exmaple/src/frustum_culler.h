@@ -0,0 +1,59 @@
+#ifndef __FRUSTUM_CULLER_H__
+#define __FRUSTUM_CULLER_H__
+
+#include "common.h"
+#include "bounds.h"
+#include "frustum.h"
+#include <vector>
+
+// world space bounding volume 을 SoA 로 모아두고 frustum 과 한번에 비교한다
+// SSE 가 있으면 4 개씩, 없으면 하나씩 같은 계산을 한다
+//
+// 평면 하나에 대해 box 의 반지름은 dot(|n|, extents), 구의 반지름은 radius
+// 둘 다 같은 중심을 기준으로 하므로 더 작은 쪽을 써도 보수적인 test 가 된다
+CLASS_PTR(FrustumCuller)
+class FrustumCuller
+{
+public:
+    static FrustumCullerUPtr Create();
+
+    struct Stats
+    {
+        uint32_t visibleCount { 0 };
+        uint32_t culledCount { 0 };
+    };
+
+    void Clear();
+    // world space box 와 그 중심을 기준으로 한 반지름. 추가한 순서대로 index 가 매겨진다
+    uint32_t Add(const BoundingBox& box, float radius);
+    void Update(uint32_t index, const BoundingBox& box, float radius);
+    size_t GetCount() const { return m_count; }
+
+    // visible[i] 가 0 이면 i 번째 물체는 frustum 밖
+    Stats Cull(const Frustum& frustum, std::vector<uint8_t>& visible) const;
+    // [first, first + count) 만 planeMask 에 있는 평면으로 test 해서 보이는 것의 ids[i] 를 result 뒤에 붙인다
+    // Bvh 가 걸친 node 아래의 물체를 확인할 때 쓴다. ids 가 nullptr 이면 index 를 그대로 붙인다
+    void CullRange(const Frustum& frustum, uint32_t planeMask, uint32_t first, uint32_t count,
+        const uint32_t* ids, std::vector<uint32_t>& result) const;
+
+    // SSE 로 평면 하나를 4 lane 에 펼친 것. SSE 가 없으면 정의하지 않는다
+    struct SimdPlane;
+
+private:
+    FrustumCuller() {}
+    // index 부터 4 개 중 planes 의 어느 하나라도 밖에 있는 것의 bit mask
+    int GetOutsideMask(const SimdPlane* planes, int planeCount, size_t index) const;
+    bool IsOutside(const glm::vec4* planes, int planeCount, size_t index) const;
+
+    // 어느 index 에서 4 개를 읽어도 넘치지 않도록 뒤에 3 개를 더 둔다
+    std::vector<float> m_centerX;
+    std::vector<float> m_centerY;
+    std::vector<float> m_centerZ;
+    std::vector<float> m_extentX;
+    std::vector<float> m_extentY;
+    std::vector<float> m_extentZ;
+    std::vector<float> m_radius;
+    size_t m_count { 0 };
+};
+
+#endif // __FRUSTUM_CULLER_H__
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "geometry_pool.h"
+#include <algorithm>
+
+// glDrawElements 의 index offset 은 index 크기의 배수여야 한다
+static const size_t INDEX_ALIGNMENT = sizeof(uint32_t);
+
+GeometryPoolUPtr GeometryPool::Create(VertexFormat vertexFormat, size_t vertexCapacity, size_t indexCapacity)
+{
+    auto pool = GeometryPoolUPtr(new GeometryPool());
+    if (!pool->Init(vertexFormat, vertexCapacity, indexCapacity))
+        return nullptr;
+    return std::move(pool);
+}
+
+bool GeometryPool::Init(VertexFormat vertexFormat, size_t vertexCapacity, size_t indexCapacity)
+{
+    if (vertexCapacity == 0 || indexCapacity == 0)
+    {
+        SPDLOG_ERROR("geometry pool needs vertex and index capacity");
+        return false;
+    }
+
+    m_vertexFormat = vertexFormat;
+    m_vertexCapacity = vertexCapacity;
+    m_indexCapacity = indexCapacity;
+    m_freeVertices.push_back({ 0, vertexCapacity });
+    m_freeIndices.push_back({ 0, indexCapacity });
+
+    // index buffer 는 VAO 에 묶이므로 VAO 를 먼저 bind 한 상태에서 만든다
+    m_vertexLayout = VertexLayout::Create();
+    size_t stride = GetVertexFormatStride(vertexFormat);
+    m_vertexBuffer = Buffer::CreateWithData(GL_ARRAY_BUFFER, GL_STATIC_DRAW, nullptr, stride, vertexCapacity);
+    m_indexBuffer = Buffer::CreateWithData(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW, nullptr, 1, indexCapacity);
+    if (!m_vertexBuffer || !m_indexBuffer)
+        return false;
+
+    for (const auto& attrib : GetVertexAttribFormats(vertexFormat))
+        m_vertexLayout->SetAttribFormat(attrib.location, attrib.count, attrib.type, attrib.normalized, attrib.offset);
+    m_vertexLayout->SetVertexBuffer(0, m_vertexBuffer->Get(), 0, stride);
+    m_indexBuffer->Bind();
+    return true;
+}
+
+bool GeometryPool::AllocateRange(std::vector<Range>& freeRanges, size_t size, size_t alignment, size_t& offset)
+{
+    for (size_t i = 0; i < freeRanges.size(); ++i)
+    {
+        auto& range = freeRanges[i];
+        size_t alignedOffset = (range.offset + alignment - 1) / alignment * alignment;
+        size_t padding = alignedOffset - range.offset;
+        if (range.size < size + padding)
+            continue;
+
+        offset = alignedOffset;
+        // 정렬로 생긴 앞쪽 틈은 free list 에 남긴다
+        Range tail = { alignedOffset + size, range.size - size - padding };
+        if (padding > 0)
+        {
+            range.size = padding;
+            if (tail.size > 0)
+                freeRanges.insert(freeRanges.begin() + i + 1, tail);
+        }
+        else if (tail.size > 0)
+            range = tail;
+        else
+            freeRanges.erase(freeRanges.begin() + i);
+        return true;
+    }
+    return false;
+}
+
+void GeometryPool::FreeRange(std::vector<Range>& freeRanges, size_t offset, size_t size)
+{
+    auto iter = std::lower_bound(freeRanges.begin(), freeRanges.end(), offset,
+        [](const Range& range, size_t value) { return range.offset < value; });
+    iter = freeRanges.insert(iter, { offset, size });
+
+    // 뒤 구간, 앞 구간 순서로 붙어 있으면 합친다
+    auto next = iter + 1;
+    if (next != freeRanges.end() && iter->offset + iter->size == next->offset)
+    {
+        iter->size += next->size;
+        freeRanges.erase(next);
+    }
+    if (iter != freeRanges.begin())
+    {
+        auto prev = iter - 1;
+        if (prev->offset + prev->size == iter->offset)
+        {
+            prev->size += iter->size;
+            freeRanges.erase(iter);
+        }
+    }
+}
+
+GeometryPool::Allocation GeometryPool::Allocate(const void* vertices, size_t vertexCount,
+    const void* indices, size_t indexSize)
+{
+    Allocation allocation;
+    if (vertexCount == 0 || indexSize == 0)
+        return allocation;
+    size_t vertexOffset = 0;
+    size_t indexOffset = 0;
+    if (!AllocateRange(m_freeVertices, vertexCount, 1, vertexOffset))
+        return allocation;
+    if (!AllocateRange(m_freeIndices, indexSize, INDEX_ALIGNMENT, indexOffset))
+    {
+        FreeRange(m_freeVertices, vertexOffset, vertexCount);
+        return allocation;
+    }
+
+    allocation.baseVertex = (uint32_t)vertexOffset;
+    allocation.vertexCount = (uint32_t)vertexCount;
+    allocation.indexOffset = indexOffset;
+    allocation.indexSize = indexSize;
+    allocation.valid = true;
+    m_usedVertexCount += vertexCount;
+    m_usedIndexSize += indexSize;
+
+    // 다른 VAO 의 index buffer binding 을 건드리지 않게 pool 의 VAO 에서 올린다
+    size_t stride = GetVertexFormatStride(m_vertexFormat);
+    m_vertexLayout->Bind();
+    m_vertexBuffer->Update(vertices, vertexCount * stride, vertexOffset * stride);
+    m_indexBuffer->Update(indices, indexSize, indexOffset);
+    return allocation;
+}
+
+void GeometryPool::Free(const Allocation& allocation)
+{
+    if (!allocation.IsValid())
+        return;
+    FreeRange(m_freeVertices, allocation.baseVertex, allocation.vertexCount);
+    FreeRange(m_freeIndices, allocation.indexOffset, allocation.indexSize);
+    m_usedVertexCount -= allocation.vertexCount;
+    m_usedIndexSize -= allocation.indexSize;
+}
\ No newline at end of file
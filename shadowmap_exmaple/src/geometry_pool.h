@@ -0,0 +1,73 @@
+#ifndef __GEOMETRY_POOL_H__
+#define __GEOMETRY_POOL_H__
+
+#include "common.h"
+#include "buffer.h"
+#include "vertex_layout.h"
+#include "vertex_format.h"
+#include <vector>
+
+// 같은 vertex format 의 mesh 들을 큰 vertex buffer 하나, index buffer 하나에 나눠 담는다
+// VAO 도 하나를 같이 쓰므로 mesh 가 바뀌어도 VAO / buffer binding 이 그대로이고
+// 각 mesh 는 glDrawElementsBaseVertex 의 base vertex 와 index offset 으로 구분한다
+//
+// 빈 구간은 offset 순으로 정렬된 free list 로 관리하고 (first fit) 반납할 때 이웃과 합친다
+// 크기는 처음에 정한 그대로, 자리가 없으면 Allocate 가 실패한다
+CLASS_PTR(GeometryPool)
+class GeometryPool
+{
+public:
+    // indexCapacity 는 byte 단위 (mesh 마다 16 / 32bit index 를 섞어 쓴다)
+    static GeometryPoolUPtr Create(VertexFormat vertexFormat, size_t vertexCapacity, size_t indexCapacity);
+
+    struct Allocation
+    {
+        uint32_t baseVertex { 0 };
+        uint32_t vertexCount { 0 };
+        // index buffer 안의 byte 위치와 크기
+        size_t indexOffset { 0 };
+        size_t indexSize { 0 };
+        bool valid { false };
+        bool IsValid() const { return valid; }
+    };
+
+    // vertices 는 vertex format 의 stride 로 vertexCount 개
+    Allocation Allocate(const void* vertices, size_t vertexCount, const void* indices, size_t indexSize);
+    void Free(const Allocation& allocation);
+
+    VertexFormat GetVertexFormat() const { return m_vertexFormat; }
+    const VertexLayout* GetVertexLayout() const { return m_vertexLayout.get(); }
+    BufferPtr GetVertexBuffer() const { return m_vertexBuffer; }
+    BufferPtr GetIndexBuffer() const { return m_indexBuffer; }
+    size_t GetVertexCapacity() const { return m_vertexCapacity; }
+    size_t GetIndexCapacity() const { return m_indexCapacity; }
+    size_t GetUsedVertexCount() const { return m_usedVertexCount; }
+    size_t GetUsedIndexSize() const { return m_usedIndexSize; }
+
+private:
+    GeometryPool() {}
+    bool Init(VertexFormat vertexFormat, size_t vertexCapacity, size_t indexCapacity);
+
+    struct Range
+    {
+        size_t offset;
+        size_t size;
+    };
+    static bool AllocateRange(std::vector<Range>& freeRanges, size_t size, size_t alignment, size_t& offset);
+    static void FreeRange(std::vector<Range>& freeRanges, size_t offset, size_t size);
+
+    VertexFormat m_vertexFormat { VERTEX_FORMAT_FULL };
+    VertexLayoutUPtr m_vertexLayout;
+    BufferPtr m_vertexBuffer;
+    BufferPtr m_indexBuffer;
+
+    size_t m_vertexCapacity { 0 };
+    size_t m_indexCapacity { 0 };
+    size_t m_usedVertexCount { 0 };
+    size_t m_usedIndexSize { 0 };
+    // vertex 는 vertex 개수 단위, index 는 byte 단위
+    std::vector<Range> m_freeVertices;
+    std::vector<Range> m_freeIndices;
+};
+
+#endif // __GEOMETRY_POOL_H__
\ No newline at end of file
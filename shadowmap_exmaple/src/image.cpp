@@ -2,6 +2,8 @@
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
+#include <algorithm>
+#include <vector>
 
 ImageUPtr Image::Load(const std::string& filepath, bool flipVertical, bool defaultPath)
 {
@@ -45,16 +47,34 @@ Image::~Image()
 
 bool Image::LoadWithStb(const std::string& filepath, bool flipVertical)
 {
-   
-    stbi_set_flip_vertically_on_load(flipVertical);
+    // stbi_set_flip_vertically_on_load 는 전역 상태라 여러 thread 에서 동시에 읽으면 섞인다
+    // stb 는 뒤집지 않고 읽고 필요하면 직접 뒤집는다
     m_data = stbi_load(filepath.c_str(), &m_width, &m_height, &m_channelCount, 0);
     if (!m_data) {
         SPDLOG_ERROR("failed to load image: {}", filepath);
         return false;
     }
+    if (flipVertical)
+    {
+        FlipVertical();
+    }
     return true;
 }
 
+void Image::FlipVertical()
+{
+    size_t rowSize = (size_t)m_width * m_channelCount;
+    std::vector<uint8_t> row(rowSize);
+    for (int y = 0; y < m_height / 2; ++y)
+    {
+        uint8_t* top = m_data + y * rowSize;
+        uint8_t* bottom = m_data + (m_height - 1 - y) * rowSize;
+        memcpy(row.data(), top, rowSize);
+        memcpy(top, bottom, rowSize);
+        memcpy(bottom, row.data(), rowSize);
+    }
+}
+
 ImageUPtr Image::Create(int width, int height, int channelCount)
 {
     ImageUPtr image(new Image());
@@ -96,4 +116,30 @@ void Image::SetCheckImage(int gridX, int gridY)
             }
         }
     }
+}
+
+void Image::GenerateMips(MipFilter filter, bool srgb)
+{
+    m_mipLevels.clear();
+    m_mipData.clear();
+
+    // 각 level 은 위 level 의 float 값에서 만들어서 8 bit 로 자른 오차가 쌓이지 않는다
+    auto level = MipGenerator::ToFloat(m_data, (size_t)m_width * m_height, m_channelCount, srgb);
+    int width = m_width;
+    int height = m_height;
+    while (width > 1 || height > 1)
+    {
+        level = MipGenerator::Downsample(level, width, height, m_channelCount, filter);
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+
+        MipLevel mipLevel;
+        mipLevel.width = width;
+        mipLevel.height = height;
+        mipLevel.offset = m_mipData.size();
+        m_mipData.resize(mipLevel.offset + (size_t)width * height * m_channelCount);
+        MipGenerator::ToBytes(level.data(), (size_t)width * height, m_channelCount, srgb,
+            m_mipData.data() + mipLevel.offset);
+        m_mipLevels.push_back(mipLevel);
+    }
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #define __IMAGE_H__
 
 #include "common.h"
+#include "mip_generator.h"
+#include <vector>
 
 CLASS_PTR(Image);
 
@@ -19,15 +21,39 @@ public:
 
     void SetCheckImage(int gridX, int gridY);
 
+    // level 1 부터 1x1 까지 CPU 에서 만든다. srgb 면 RGB 를 linear 로 바꿔 평균낸다
+    void GenerateMips(MipFilter filter = MipFilter::Kaiser, bool srgb = true);
+    // level 0 은 image 자신. GenerateMips 전에는 1
+    int GetLevelCount() const { return 1 + (int)m_mipLevels.size(); }
+    int GetLevelWidth(int level) const { return level == 0 ? m_width : m_mipLevels[level - 1].width; }
+    int GetLevelHeight(int level) const { return level == 0 ? m_height : m_mipLevels[level - 1].height; }
+    const uint8_t* GetLevelData(int level) const
+    {
+        return level == 0 ? m_data : m_mipData.data() + m_mipLevels[level - 1].offset;
+    }
+
 private:
+    friend class MipCache;
+
+    struct MipLevel
+    {
+        int width { 0 };
+        int height { 0 };
+        // m_mipData 안의 위치
+        size_t offset { 0 };
+    };
+
     Image() {}
     bool LoadWithStb(const std::string& filepath, bool flipVertical);
+    void FlipVertical();
     bool Allocate(int width, int height, int channelCount);
 
     int m_width { 0 };
     int m_height { 0 };
     int m_channelCount { 0 };
     uint8_t* m_data { nullptr };
+    std::vector<MipLevel> m_mipLevels;
+    std::vector<uint8_t> m_mipData;
 };
 
 #endif // __IMAGE_H__
\ No newline at end of file
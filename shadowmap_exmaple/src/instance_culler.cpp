@@ -0,0 +1,137 @@
+#include "instance_culler.h"
+#include "render_state.h"
+
+static const UniformHandle<glm::mat4> s_modelTransform("modelTransform");
+static const UniformHandle<float> s_cullDistance("cullDistance");
+static const UniformHandle<float> s_cullRadius("cullRadius");
+static const UniformHandle<glm::vec4> s_cullPlanes[Frustum::PLANE_COUNT] = {
+    UniformHandle<glm::vec4>("cullPlanes[0]"),
+    UniformHandle<glm::vec4>("cullPlanes[1]"),
+    UniformHandle<glm::vec4>("cullPlanes[2]"),
+    UniformHandle<glm::vec4>("cullPlanes[3]"),
+    UniformHandle<glm::vec4>("cullPlanes[4]"),
+    UniformHandle<glm::vec4>("cullPlanes[5]"),
+};
+
+InstanceCullerUPtr InstanceCuller::Create(const std::vector<glm::vec3>& instances, float boundingRadius)
+{
+    auto culler = InstanceCullerUPtr(new InstanceCuller());
+    if (!culler->Init(instances, boundingRadius))
+        return nullptr;
+    return std::move(culler);
+}
+
+InstanceCuller::~InstanceCuller()
+{
+    if (m_feedback)
+        glDeleteTransformFeedbacks(1, &m_feedback);
+    glDeleteQueries(QUERY_COUNT, m_queries);
+}
+
+bool InstanceCuller::Init(const std::vector<glm::vec3>& instances, float boundingRadius)
+{
+    if (instances.empty())
+    {
+        SPDLOG_ERROR("instance culler needs at least one instance");
+        return false;
+    }
+
+    ShaderPtr vs = Shader::CreateFromFile("/grass_cull.vs", GL_VERTEX_SHADER);
+    ShaderPtr gs = Shader::CreateFromFile("/grass_cull.gs", GL_GEOMETRY_SHADER);
+    if (!vs || !gs)
+        return false;
+    m_cullProgram = Program::Create({ vs, gs }, { "outOffset" });
+    if (!m_cullProgram)
+        return false;
+
+    m_instanceCount = (uint32_t)instances.size();
+    m_boundingRadius = boundingRadius;
+
+    m_instanceLayout = VertexLayout::Create();
+    m_instanceBuffer = Buffer::CreateWithData(GL_ARRAY_BUFFER, GL_STATIC_DRAW,
+        instances.data(), sizeof(glm::vec3), instances.size());
+    m_instanceLayout->SetAttrib(0, 3, GL_FLOAT, false, sizeof(glm::vec3), 0);
+
+    // GPU 가 쓰고 GPU 가 읽는다
+    m_visibleLayout = VertexLayout::Create();
+    m_visibleBuffer = Buffer::CreateWithData(GL_ARRAY_BUFFER, GL_STREAM_COPY,
+        nullptr, sizeof(glm::vec3), instances.size());
+    m_visibleLayout->SetAttrib(0, 3, GL_FLOAT, false, sizeof(glm::vec3), 0);
+
+    if (GLAD_GL_VERSION_4_0 || GLAD_GL_ARB_transform_feedback2)
+    {
+        glGenTransformFeedbacks(1, &m_feedback);
+        glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, m_feedback);
+        // indexed binding 은 transform feedback object 에 저장된다
+        RenderState::Get().BindBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, 0, (uint32_t)m_visibleBuffer->Get(), 0, 0);
+        glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
+    }
+    glGenQueries(QUERY_COUNT, m_queries);
+    return true;
+}
+
+void InstanceCuller::Cull(const glm::mat4& modelTransform, const Frustum& frustum, float maxDistance)
+{
+    // 이전 query 가 아직 안 끝났으면 결과를 기다리지 않고 건너뛴다
+    ReadQueries(false);
+
+    m_cullProgram->Use();
+    m_cullProgram->SetUniform(s_modelTransform, modelTransform);
+    m_cullProgram->SetUniform(s_cullDistance, maxDistance);
+    m_cullProgram->SetUniform(s_cullRadius, m_boundingRadius);
+    for (int i = 0; i < Frustum::PLANE_COUNT; ++i)
+        m_cullProgram->SetUniform(s_cullPlanes[i], frustum.planes[i]);
+
+    m_instanceLayout->Bind();
+    if (m_feedback)
+        glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, m_feedback);
+    else
+        RenderState::Get().BindBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, 0, (uint32_t)m_visibleBuffer->Get(), 0, 0);
+
+    uint32_t query = m_queries[m_queryIndex];
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, query);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, (GLsizei)m_instanceCount);
+    glEndTransformFeedback();
+    glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+    glDisable(GL_RASTERIZER_DISCARD);
+    m_queryPending[m_queryIndex] = true;
+    m_queryIndex = (m_queryIndex + 1) % QUERY_COUNT;
+
+    if (m_feedback)
+        glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
+    else
+        ReadQueries(true);
+}
+
+// 오래된 query 부터 결과를 읽는다. wait 가 false 면 끝나지 않은 곳에서 멈춘다
+void InstanceCuller::ReadQueries(bool wait)
+{
+    for (uint32_t i = 0; i < QUERY_COUNT; ++i)
+    {
+        uint32_t index = (m_queryIndex + i) % QUERY_COUNT;
+        if (!m_queryPending[index])
+            continue;
+        if (!wait)
+        {
+            GLuint available = GL_FALSE;
+            glGetQueryObjectuiv(m_queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                return;
+        }
+        GLuint count = 0;
+        glGetQueryObjectuiv(m_queries[index], GL_QUERY_RESULT, &count);
+        m_visibleCount = count;
+        m_queryPending[index] = false;
+    }
+}
+
+void InstanceCuller::Draw() const
+{
+    m_visibleLayout->Bind();
+    if (m_feedback)
+        glDrawTransformFeedback(GL_POINTS, m_feedback);
+    else if (m_visibleCount > 0)
+        glDrawArrays(GL_POINTS, 0, (GLsizei)m_visibleCount);
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#ifndef __INSTANCE_CULLER_H__
+#define __INSTANCE_CULLER_H__
+
+#include "common.h"
+#include "buffer.h"
+#include "vertex_layout.h"
+#include "program.h"
+#include "frustum.h"
+
+// grass 처럼 작은 instance 가 많은 경우를 위한 GPU culling
+// instance (vec3: x, y 회전, z) 를 point 로 그리면서 frustum / 거리 test 를 통과한 것만
+// transform feedback 으로 다른 buffer 에 모은다. CPU 는 instance 를 하나도 보지 않는다
+//
+// 모은 결과는 point 로 그리고 geometry shader (grass.gs) 가 quad 로 펼친다
+// GL 4.0 / ARB_transform_feedback2 가 있으면 glDrawTransformFeedback 으로 개수를 GPU 에서 바로 쓰고
+// 없으면 primitives written query 를 기다려 개수를 읽는다
+CLASS_PTR(InstanceCuller)
+class InstanceCuller
+{
+public:
+    // boundingRadius: instance 하나를 감싸는 구의 반지름 (modelTransform 적용 후 기준)
+    static InstanceCullerUPtr Create(const std::vector<glm::vec3>& instances, float boundingRadius);
+    ~InstanceCuller();
+
+    // 현재 bind 된 frame block 의 viewPos 로 거리 test 를 한다
+    void Cull(const glm::mat4& modelTransform, const Frustum& frustum, float maxDistance);
+    // 살아남은 instance 를 GL_POINTS 로 그린다. program 은 grass.gs 처럼 point 를 펼쳐야 함
+    void Draw() const;
+
+    uint32_t GetInstanceCount() const { return m_instanceCount; }
+    // 통계용, 몇 frame 전의 결과일 수 있다
+    uint32_t GetVisibleCount() const { return m_visibleCount; }
+
+private:
+    InstanceCuller() {}
+    bool Init(const std::vector<glm::vec3>& instances, float boundingRadius);
+    void ReadQueries(bool wait);
+
+    static const uint32_t QUERY_COUNT = 3;
+
+    ProgramUPtr m_cullProgram;
+    BufferUPtr m_instanceBuffer;
+    VertexLayoutUPtr m_instanceLayout;
+    BufferUPtr m_visibleBuffer;
+    VertexLayoutUPtr m_visibleLayout;
+    // transform feedback object, ARB_transform_feedback2 가 없으면 0
+    uint32_t m_feedback { 0 };
+
+    uint32_t m_queries[QUERY_COUNT] {};
+    bool m_queryPending[QUERY_COUNT] {};
+    uint32_t m_queryIndex { 0 };
+
+    uint32_t m_instanceCount { 0 };
+    uint32_t m_visibleCount { 0 };
+    float m_boundingRadius { 0.0f };
+};
+
+#endif // __INSTANCE_CULLER_H__
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "instanced_mesh.h"
+
+InstancedMeshUPtr InstancedMesh::Create(MeshPtr mesh, size_t maxInstanceCount)
+{
+    auto instancedMesh = InstancedMeshUPtr(new InstancedMesh());
+    if (!instancedMesh->Init({ mesh }, maxInstanceCount))
+        return nullptr;
+    return std::move(instancedMesh);
+}
+
+InstancedMeshUPtr InstancedMesh::CreateFromModel(const Model* model, size_t maxInstanceCount)
+{
+    std::vector<MeshPtr> meshes;
+    for (int i = 0; i < model->GetMeshCount(); ++i)
+        meshes.push_back(model->GetMesh(i));
+
+    auto instancedMesh = InstancedMeshUPtr(new InstancedMesh());
+    if (!instancedMesh->Init(meshes, maxInstanceCount))
+        return nullptr;
+    return std::move(instancedMesh);
+}
+
+bool InstancedMesh::Init(const std::vector<MeshPtr>& meshes, size_t maxInstanceCount)
+{
+    if (meshes.empty() || maxInstanceCount == 0)
+    {
+        SPDLOG_ERROR("instanced mesh needs at least one mesh and instance");
+        return false;
+    }
+
+    m_meshes = meshes;
+    m_maxInstanceCount = maxInstanceCount;
+    for (auto& mesh : m_meshes)
+    {
+        auto vertexLayout = VertexLayout::Create();
+        mesh->AttachToVertexLayout(vertexLayout.get());
+        m_vertexLayouts.push_back(std::move(vertexLayout));
+    }
+    return true;
+}
+
+uint32_t InstancedMesh::AddStream(uint32_t location, uint32_t columns, int components,
+    uint32_t type, bool normalized, size_t stride, uint32_t usage)
+{
+    Stream stream;
+    stream.location = location;
+    stream.buffer = Buffer::CreateWithData(GL_ARRAY_BUFFER, usage, nullptr, stride, m_maxInstanceCount);
+
+    // column 하나가 vec4 까지이므로 mat4 같은 type 은 location 을 여러개 쓴다
+    size_t columnSize = stride / columns;
+    for (auto& vertexLayout : m_vertexLayouts)
+    {
+        vertexLayout->Bind();
+        stream.buffer->Bind();
+        for (uint32_t column = 0; column < columns; ++column)
+        {
+            vertexLayout->SetAttrib(location + column, components, type, normalized, stride, column * columnSize);
+            vertexLayout->SetAttribDivisor(location + column, 1);
+        }
+    }
+
+    m_streams.push_back(std::move(stream));
+    return (uint32_t)m_streams.size() - 1;
+}
+
+void InstancedMesh::Update(uint32_t streamIndex, size_t firstInstance, const void* data, size_t count)
+{
+    if (streamIndex >= m_streams.size() || firstInstance + count > m_maxInstanceCount)
+    {
+        SPDLOG_ERROR("instance update out of range: stream {}, [{}, {}) / {}",
+            streamIndex, firstInstance, firstInstance + count, m_maxInstanceCount);
+        return;
+    }
+    if (count == 0)
+        return;
+
+    auto& buffer = m_streams[streamIndex].buffer;
+    buffer->Update(data, count * buffer->GetStride(), firstInstance * buffer->GetStride());
+}
+
+void InstancedMesh::SetInstanceCount(size_t instanceCount)
+{
+    m_instanceCount = std::min(instanceCount, m_maxInstanceCount);
+}
+
+void InstancedMesh::Draw(const Program* program) const
+{
+    if (m_instanceCount == 0)
+        return;
+
+    for (size_t i = 0; i < m_meshes.size(); ++i)
+    {
+        const auto& mesh = m_meshes[i];
+        m_vertexLayouts[i]->Bind();
+        if (mesh->GetMaterial())
+            mesh->GetMaterial()->SetToProgram(program);
+        mesh->SetVertexUniforms(program);
+        glDrawElementsInstancedBaseVertex(mesh->GetPrimitiveType(), (GLsizei)mesh->GetLod(0).indexCount,
+            mesh->GetIndexType(), (void*)mesh->GetLodByteOffset(0), (GLsizei)m_instanceCount, mesh->GetBaseVertex());
+    }
+}
\ No newline at end of file
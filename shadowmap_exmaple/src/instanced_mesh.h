@@ -0,0 +1,122 @@
+#ifndef __INSTANCED_MESH_H__
+#define __INSTANCED_MESH_H__
+
+#include "common.h"
+#include "mesh.h"
+#include "model.h"
+
+// affine transform 의 위 3 row, mat4 보다 16 byte 작다
+// shader 에서 transpose(mat4(row0, row1, row2, vec4(0, 0, 0, 1))) 로 복원
+struct PackedTransform
+{
+    glm::vec4 rows[3];
+
+    static PackedTransform FromMatrix(const glm::mat4& transform)
+    {
+        auto transposed = glm::transpose(transform);
+        return { { transposed[0], transposed[1], transposed[2] } };
+    }
+};
+
+// normalized unsigned byte RGBA, shader 에서는 vec4 로 읽힌다
+struct PackedColor
+{
+    uint8_t r, g, b, a;
+};
+
+// instance attribute type 별 vertex attribute 설정
+// column 이 여러개인 type 은 연속된 location 을 차지한다
+template <typename T>
+struct InstanceAttribTraits;
+
+#define INSTANCE_ATTRIB_TRAITS(klassName, columnCount, componentCount, glType, isNormalized) \
+template <> struct InstanceAttribTraits<klassName> { \
+    static const uint32_t columns = columnCount; \
+    static const int components = componentCount; \
+    static const uint32_t type = glType; \
+    static const bool normalized = isNormalized; \
+};
+
+INSTANCE_ATTRIB_TRAITS(float, 1, 1, GL_FLOAT, false)
+INSTANCE_ATTRIB_TRAITS(glm::vec2, 1, 2, GL_FLOAT, false)
+INSTANCE_ATTRIB_TRAITS(glm::vec3, 1, 3, GL_FLOAT, false)
+INSTANCE_ATTRIB_TRAITS(glm::vec4, 1, 4, GL_FLOAT, false)
+INSTANCE_ATTRIB_TRAITS(glm::mat4, 4, 4, GL_FLOAT, false)
+INSTANCE_ATTRIB_TRAITS(PackedTransform, 3, 4, GL_FLOAT, false)
+INSTANCE_ATTRIB_TRAITS(PackedColor, 1, 4, GL_UNSIGNED_BYTE, true)
+
+#undef INSTANCE_ATTRIB_TRAITS
+
+// InstancedMesh::AddStream 이 돌려주는 handle, Update 할 때 type 을 확인하는 용도
+template <typename T>
+class InstanceStream
+{
+public:
+    InstanceStream() {}
+    uint32_t GetIndex() const { return m_index; }
+
+private:
+    friend class InstancedMesh;
+    explicit InstanceStream(uint32_t index) : m_index(index) {}
+    uint32_t m_index { 0 };
+};
+
+// Mesh (또는 Model 의 모든 mesh) 를 instance attribute stream 과 함께 그린다
+// mesh 마다 vertex / index buffer 를 공유하는 VAO 를 따로 만들고
+// 모든 VAO 가 같은 instance buffer 를 가리킨다
+CLASS_PTR(InstancedMesh)
+class InstancedMesh
+{
+public:
+    static InstancedMeshUPtr Create(MeshPtr mesh, size_t maxInstanceCount);
+    static InstancedMeshUPtr CreateFromModel(const Model* model, size_t maxInstanceCount);
+
+    template <typename T>
+    InstanceStream<T> AddStream(uint32_t location, uint32_t usage = GL_DYNAMIC_DRAW)
+    {
+        using Traits = InstanceAttribTraits<T>;
+        return InstanceStream<T>(AddStream(location, Traits::columns, Traits::components,
+            Traits::type, Traits::normalized, sizeof(T), usage));
+    }
+
+    // [firstInstance, firstInstance + count) 구간만 다시 올린다
+    template <typename T>
+    void Update(const InstanceStream<T>& stream, size_t firstInstance, const T* data, size_t count)
+    {
+        Update(stream.GetIndex(), firstInstance, data, count);
+    }
+
+    template <typename T>
+    void Update(const InstanceStream<T>& stream, const std::vector<T>& data)
+    {
+        Update(stream.GetIndex(), 0, data.data(), data.size());
+    }
+
+    void SetInstanceCount(size_t instanceCount);
+    size_t GetInstanceCount() const { return m_instanceCount; }
+    size_t GetMaxInstanceCount() const { return m_maxInstanceCount; }
+
+    // mesh 에 material 이 있으면 같이 설정한다
+    void Draw(const Program* program) const;
+
+private:
+    InstancedMesh() {}
+    bool Init(const std::vector<MeshPtr>& meshes, size_t maxInstanceCount);
+    uint32_t AddStream(uint32_t location, uint32_t columns, int components,
+        uint32_t type, bool normalized, size_t stride, uint32_t usage);
+    void Update(uint32_t streamIndex, size_t firstInstance, const void* data, size_t count);
+
+    struct Stream
+    {
+        BufferUPtr buffer;
+        uint32_t location;
+    };
+
+    std::vector<MeshPtr> m_meshes;
+    std::vector<VertexLayoutUPtr> m_vertexLayouts;
+    std::vector<Stream> m_streams;
+    size_t m_maxInstanceCount { 0 };
+    size_t m_instanceCount { 0 };
+};
+
+#endif // __INSTANCED_MESH_H__
\ No newline at end of file
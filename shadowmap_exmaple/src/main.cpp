@@ -1,5 +1,6 @@
 #include "common.h"
 #include "context.h"
+#include "compressed_image.h"
 
 void OnFramebufferSizeChange(GLFWwindow* window, int width, int height) {
     SPDLOG_INFO("framebuffer size changed: ({} x {})", width, height);
@@ -47,8 +48,54 @@ void OnScrollCallback(GLFWwindow* window, double x, double y) {
     ImGui_ImplGlfw_ScrollCallback(window, x, y);
 }
 
+// 창을 띄우지 않고 원본 image 를 DDS 로 미리 압축해 둔다
+// --encode-texture <input> <output.dds> [bc1|bc3|bc4|bc5]
+int EncodeTexture(int argc, const char** argv)
+{
+    if (argc < 4)
+    {
+        SPDLOG_ERROR("usage: {} --encode-texture <input> <output.dds> [bc1|bc3|bc4|bc5]", argv[0]);
+        return -1;
+    }
+
+    // Image::Load 처럼 뒤집어서 읽어 두면 load 할 때 그대로 올릴 수 있다
+    auto image = Image::Load(argv[2], true, false);
+    if (!image)
+        return -1;
+
+    // format 을 주지 않으면 alpha 가 있는지로 고른다
+    auto format = image->GetChannelCount() == 4 ? CompressedImage::Format::BC3 : CompressedImage::Format::BC1;
+    if (argc >= 5)
+    {
+        std::string formatName = argv[4];
+        if (formatName == "bc1") format = CompressedImage::Format::BC1;
+        else if (formatName == "bc3") format = CompressedImage::Format::BC3;
+        else if (formatName == "bc4") format = CompressedImage::Format::BC4;
+        else if (formatName == "bc5") format = CompressedImage::Format::BC5;
+        else
+        {
+            SPDLOG_ERROR("unknown texture format: {}", formatName);
+            return -1;
+        }
+    }
+
+    // BC4 / BC5 는 normal map 같은 color 가 아닌 data 라 linear 로 평균낸다
+    bool srgb = format == CompressedImage::Format::BC1 || format == CompressedImage::Format::BC3;
+    image->GenerateMips(MipFilter::Kaiser, srgb);
+    auto compressed = CompressedImage::Encode(image.get(), format);
+    if (!compressed || !compressed->SaveDDS(argv[3]))
+        return -1;
+    SPDLOG_INFO("{} -> {}: {} {} x {}, {} levels, {} KB", argv[2], argv[3],
+        CompressedImage::GetFormatName(format), compressed->GetWidth(), compressed->GetHeight(),
+        compressed->GetLevels().size(), compressed->GetDataSize() / 1024);
+    return 0;
+}
+
 int main(int argc, const char** argv)
 {
+    if (argc >= 2 && std::string(argv[1]) == "--encode-texture")
+        return EncodeTexture(argc, argv);
+
     SPDLOG_INFO("Start program");
     // window 환경변수 출력
     SPDLOG_INFO("Window Name: {}", WINDOW_NAME);
@@ -68,7 +115,9 @@ int main(int argc, const char** argv)
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_SAMPLES, 16);
+    // anti-aliasing 은 Context 의 multisample framebuffer 에서 한다
+    // window 가 multisample 이면 glBlitFramebuffer 로 복사할 수 없다
+    glfwWindowHint(GLFW_SAMPLES, 0);
 
     // GLFW window 생성
     SPDLOG_INFO("Create GLFW window");
@@ -0,0 +1,96 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFileUPtr MappedFile::Open(const std::string& filepath)
+{
+    auto file = MappedFileUPtr(new MappedFile());
+    if (!file->Init(filepath))
+        return nullptr;
+    return std::move(file);
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Init(const std::string& filepath)
+{
+    HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    m_file = file;
+
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0)
+        return false;
+
+    m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_mapping)
+    {
+        SPDLOG_WARN("failed to map file: {}", filepath);
+        return false;
+    }
+    m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_data)
+    {
+        SPDLOG_WARN("failed to map file: {}", filepath);
+        return false;
+    }
+    m_size = (size_t)size.QuadPart;
+    return true;
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data)
+        UnmapViewOfFile(m_data);
+    if (m_mapping)
+        CloseHandle(m_mapping);
+    if (m_file)
+        CloseHandle(m_file);
+}
+
+#else
+
+bool MappedFile::Init(const std::string& filepath)
+{
+    int file = open(filepath.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat status = {};
+    if (fstat(file, &status) != 0 || status.st_size <= 0)
+    {
+        close(file);
+        return false;
+    }
+
+    // mapping 이 file 을 붙잡고 있으므로 descriptor 는 바로 닫아도 된다
+    void* data = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED)
+    {
+        SPDLOG_WARN("failed to map file: {}", filepath);
+        return false;
+    }
+    m_data = static_cast<const uint8_t*>(data);
+    m_size = (size_t)status.st_size;
+    return true;
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data)
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,32 @@
+#ifndef __MAPPED_FILE_H__
+#define __MAPPED_FILE_H__
+
+#include "common.h"
+
+// 읽기 전용 memory mapped file
+// 내용은 OS 가 page 단위로 필요할 때 읽어 오므로 std::vector 로 복사하지 않고 바로 쓴다
+CLASS_PTR(MappedFile)
+class MappedFile
+{
+public:
+    // 없거나 비어 있는 file 이면 nullptr
+    static MappedFileUPtr Open(const std::string& filepath);
+    ~MappedFile();
+
+    const uint8_t* GetData() const { return m_data; }
+    size_t GetSize() const { return m_size; }
+
+private:
+    MappedFile() {}
+    bool Init(const std::string& filepath);
+
+    const uint8_t* m_data { nullptr };
+    size_t m_size { 0 };
+#ifdef _WIN32
+    // windows.h 를 header 에 넣지 않으려고 HANDLE 을 void* 로 들고 있는다
+    void* m_file { nullptr };
+    void* m_mapping { nullptr };
+#endif
+};
+
+#endif // __MAPPED_FILE_H__
\ No newline at end of file
@@ -1,41 +1,255 @@
 #include "mesh.h"
+#include <cstring>
+
+static const UniformHandle<int> s_materialDiffuse("material.diffuse");
+static const UniformHandle<int> s_materialSpecular("material.specular");
+static const UniformHandle<float> s_materialShininess("material.shininess");
+static const UniformHandle<glm::vec4> s_vertexDequantize("vertexDequantize");
 
 MeshUPtr Mesh::Create(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, uint32_t primitiveType)
+{
+    return CreateWithLods(vertices, { { indices, 0.0f } }, primitiveType);
+}
+
+MeshUPtr Mesh::CreateWithLods(const std::vector<Vertex>& vertices, const std::vector<MeshLodData>& lods,
+    uint32_t primitiveType, VertexFormat vertexFormat)
+{
+    DataStorage storage;
+    return CreateFromData(BuildData(vertices, lods, primitiveType, vertexFormat, storage));
+}
+
+MeshUPtr Mesh::CreateInPool(GeometryPoolPtr geometryPool, const std::vector<Vertex>& vertices,
+    const std::vector<MeshLodData>& lods, uint32_t primitiveType)
+{
+    DataStorage storage;
+    auto data = BuildData(vertices, lods, primitiveType, geometryPool->GetVertexFormat(), storage);
+    return CreateFromData(data, geometryPool);
+}
+
+MeshUPtr Mesh::CreateFromData(const Data& data, GeometryPoolPtr geometryPool)
 {
     auto mesh = MeshUPtr(new Mesh());
-    mesh->Init(vertices, indices, primitiveType);
+    if (!mesh->Init(data, geometryPool))
+        return nullptr;
     return std::move(mesh);
 }
 
-void Mesh::Init(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, uint32_t primitiveType)
+Mesh::~Mesh()
 {
-    m_primitiveType = primitiveType;
-    m_vertexLayout = VertexLayout::Create();
+    if (m_geometryPool)
+        m_geometryPool->Free(m_poolAllocation);
+}
+
+// 범위를 넘는 값은 inf, 너무 작은 값은 0 으로 보낸다
+static uint16_t FloatToHalf(float value)
+{
+    uint32_t bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int32_t exponent = (int32_t)((bits >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+    if (exponent <= 0)
+        return (uint16_t)sign;
+    if (exponent >= 31)
+        return (uint16_t)(sign | 0x7c00);
+
+    uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+    // 반올림, 자리올림이 exponent 로 넘어가도 맞는 값이 된다
+    if (mantissa & 0x1000)
+        ++half;
+    return (uint16_t)half;
+}
+
+// 단위 벡터를 팔면체에 투영해 xy 두 값으로 만든다. 아래쪽 반은 바깥 삼각형으로 접는다
+static void EncodeOctahedral(const glm::vec3& normal, int16_t encoded[2])
+{
+    float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    glm::vec2 octahedral(0.0f);
+    if (length > 0.0f)
+    {
+        octahedral = glm::vec2(normal.x, normal.y) / length;
+        if (normal.z < 0.0f)
+        {
+            octahedral = glm::vec2(
+                (1.0f - std::abs(octahedral.y)) * (octahedral.x >= 0.0f ? 1.0f : -1.0f),
+                (1.0f - std::abs(octahedral.x)) * (octahedral.y >= 0.0f ? 1.0f : -1.0f));
+        }
+    }
+    for (int i = 0; i < 2; ++i)
+        encoded[i] = (int16_t)std::round(glm::clamp(octahedral[i], -1.0f, 1.0f) * 32767.0f);
+}
 
+// 복원에 쓸 (bounding box 최소점, 배율) 을 돌려준다
+static glm::vec4 BuildCompactVertices(const std::vector<Vertex>& vertices, const BoundingBox& boundingBox,
+    std::vector<CompactVertex>& compactVertices)
+{
+    // 세 축을 같은 배율로 줄여야 model transform 의 normal 변환이 그대로 맞는다
+    auto size = boundingBox.IsValid() ? boundingBox.max - boundingBox.min : glm::vec3(0.0f);
+    float scale = std::max(size.x, std::max(size.y, size.z));
+    if (scale <= 0.0f)
+        scale = 1.0f;
+    auto origin = boundingBox.IsValid() ? boundingBox.min : glm::vec3(0.0f);
+
+    compactVertices.resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        const auto& vertex = vertices[i];
+        auto& compact = compactVertices[i];
+        auto position = (vertex.position - origin) / scale;
+        for (int k = 0; k < 3; ++k)
+            compact.position[k] = (uint16_t)std::round(glm::clamp(position[k], 0.0f, 1.0f) * 65535.0f);
+        compact.position[3] = 0;
+        EncodeOctahedral(vertex.normal, compact.normal);
+        compact.texCoord[0] = FloatToHalf(vertex.texCoord.x);
+        compact.texCoord[1] = FloatToHalf(vertex.texCoord.y);
+    }
+    return glm::vec4(origin, scale);
+}
+
+Mesh::Data Mesh::BuildData(const std::vector<Vertex>& vertices, const std::vector<MeshLodData>& lods,
+    uint32_t primitiveType, VertexFormat vertexFormat, DataStorage& storage)
+{
+    Data data;
+    data.primitiveType = primitiveType;
+    data.vertexFormat = vertexFormat;
+
+    // 구의 중심을 box 중심에 맞춰 culling 에서 둘을 같이 쓸 수 있게 한다
+    for (const auto& vertex : vertices)
+        data.boundingBox.Expand(vertex.position);
+    data.boundingSphere.center = data.boundingBox.IsValid() ? data.boundingBox.GetCenter() : glm::vec3(0.0f);
+    for (const auto& vertex : vertices)
+    {
+        data.boundingSphere.radius = std::max(data.boundingSphere.radius,
+            glm::distance(vertex.position, data.boundingSphere.center));
+    }
+
+    data.vertices = vertices.data();
+    data.vertexCount = (uint32_t)vertices.size();
+    if (vertexFormat == VERTEX_FORMAT_COMPACT)
+    {
+        data.vertexDequantize = BuildCompactVertices(vertices, data.boundingBox, storage.compactVertices);
+        data.vertices = storage.compactVertices.data();
+    }
+
+    storage.indices.clear();
+    storage.lods.clear();
+    for (const auto& lod : lods)
+    {
+        storage.lods.push_back({ (uint32_t)storage.indices.size(), (uint32_t)lod.indices.size(), lod.error });
+        storage.indices.insert(storage.indices.end(), lod.indices.begin(), lod.indices.end());
+    }
+    data.lods = storage.lods.data();
+    data.lodCount = (uint32_t)storage.lods.size();
+    data.indices = storage.indices.data();
+    data.indexCount = (uint32_t)storage.indices.size();
+    data.indexType = GL_UNSIGNED_INT;
+    if (vertices.size() <= 0x10000)
+    {
+        data.indexType = GL_UNSIGNED_SHORT;
+        storage.shortIndices.assign(storage.indices.begin(), storage.indices.end());
+        data.indices = storage.shortIndices.data();
+    }
+    return data;
+}
+
+bool Mesh::Init(const Data& data, GeometryPoolPtr geometryPool)
+{
+    if (data.lodCount == 0)
+    {
+        SPDLOG_ERROR("mesh needs at least one lod");
+        return false;
+    }
+    if (geometryPool && geometryPool->GetVertexFormat() != data.vertexFormat)
+    {
+        SPDLOG_ERROR("vertex format does not match geometry pool");
+        return false;
+    }
+
+    m_primitiveType = data.primitiveType;
+    m_vertexFormat = data.vertexFormat;
+    m_indexType = data.indexType;
+    m_vertexDequantize = data.vertexDequantize;
+    m_boundingBox = data.boundingBox;
+    m_boundingSphere = data.boundingSphere;
+    m_lods.assign(data.lods, data.lods + data.lodCount);
+
+    size_t stride = GetVertexFormatStride(m_vertexFormat);
+    size_t indexStride = m_indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    m_vertexDataSize = data.vertexCount * stride;
+    m_indexDataSize = data.indexCount * indexStride;
+
+    if (geometryPool)
+    {
+        m_poolAllocation = geometryPool->Allocate(data.vertices, data.vertexCount, data.indices, m_indexDataSize);
+        if (m_poolAllocation.IsValid())
+        {
+            m_geometryPool = geometryPool;
+            return true;
+        }
+        SPDLOG_WARN("geometry pool is full ({} vertices, {} bytes of index), mesh uses its own buffers",
+            data.vertexCount, m_indexDataSize);
+    }
+
+    m_vertexLayout = VertexLayout::Create();
     m_vertexBuffer = Buffer::CreateWithData(
         GL_ARRAY_BUFFER, GL_STATIC_DRAW,
-        vertices.data(), sizeof(Vertex), vertices.size());
-
+        data.vertices, stride, data.vertexCount);
     m_indexBuffer = Buffer::CreateWithData(
         GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW,
-        indices.data(), sizeof(uint32_t), indices.size());
+        data.indices, indexStride, data.indexCount);
+    if (!m_vertexBuffer || !m_indexBuffer)
+        return false;
+    AttachToVertexLayout(m_vertexLayout.get());
+    return true;
+}
+
+void Mesh::AttachToVertexLayout(const VertexLayout* vertexLayout) const
+{
+    vertexLayout->Bind();
+    GetVertexBuffer()->Bind();
+    size_t stride = GetVertexFormatStride(m_vertexFormat);
+    for (const auto& attrib : GetVertexAttribFormats(m_vertexFormat))
+        vertexLayout->SetAttrib(attrib.location, attrib.count, attrib.type, attrib.normalized, stride, attrib.offset);
+    GetIndexBuffer()->Bind();
+}
+
+uint32_t Mesh::SelectLod(float pixelsPerUnit, float maxPixelError, float hysteresis, uint32_t currentLod) const
+{
+    uint32_t selected = 0;
+    for (uint32_t lod = 1; lod < GetLodCount(); ++lod)
+    {
+        float limit = lod > currentLod ? maxPixelError * (1.0f - hysteresis) : maxPixelError;
+        if (m_lods[lod].error * pixelsPerUnit > limit)
+            break;
+        selected = lod;
+    }
+    return selected;
+}
 
-    m_vertexLayout->SetAttrib(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-    m_vertexLayout->SetAttrib(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, normal));
-    m_vertexLayout->SetAttrib(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, texCoord));
+size_t Mesh::GetLodByteOffset(uint32_t lod) const
+{
+    size_t indexSize = m_indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    return m_poolAllocation.indexOffset + GetLod(lod).indexOffset * indexSize;
+}
+
+void Mesh::SetVertexUniforms(const Program* program) const
+{
+    program->SetUniform(s_vertexDequantize, m_vertexDequantize);
 }
 
-void Mesh::Draw(const Program* program) const
+void Mesh::Draw(const Program* program, uint32_t lod) const
 {
-    m_vertexLayout->Bind();
+    GetVertexLayout()->Bind();
     if (m_material)
     {
         m_material->SetToProgram(program);
     }
-    glDrawElements(m_primitiveType, m_indexBuffer->GetCount(), GL_UNSIGNED_INT, 0);
+    SetVertexUniforms(program);
+    glDrawElementsBaseVertex(m_primitiveType, GetLod(lod).indexCount, m_indexType,
+        (void*)GetLodByteOffset(lod), GetBaseVertex());
 }
 
-MeshUPtr Mesh::CreateBox() {
+MeshUPtr Mesh::CreateBox(GeometryPoolPtr geometryPool) {
     std::vector<Vertex> vertices = {
         Vertex { glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec2(0.0f, 0.0f) },
         Vertex { glm::vec3( 0.5f, -0.5f, -0.5f), glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec2(1.0f, 0.0f) },
@@ -77,10 +291,12 @@ MeshUPtr Mesh::CreateBox() {
         20, 22, 21, 22, 20, 23,
     };
     
+    if (geometryPool)
+        return CreateInPool(geometryPool, vertices, { { indices, 0.0f } }, GL_TRIANGLES);
     return Create(vertices, indices, GL_TRIANGLES);
 }
 
-MeshUPtr Mesh::CreatePlane() {
+MeshUPtr Mesh::CreatePlane(GeometryPoolPtr geometryPool) {
   std::vector<Vertex> vertices = {
     Vertex { glm::vec3(-0.5f, -0.5f, 0.0f), glm::vec3( 0.0f,  0.0f, 1.0f), glm::vec2(0.0f, 0.0f) },
     Vertex { glm::vec3( 0.5f, -0.5f, 0.0f), glm::vec3( 0.0f,  0.0f, 1.0f), glm::vec2(1.0f, 0.0f) },
@@ -92,6 +308,8 @@ MeshUPtr Mesh::CreatePlane() {
     0,  1,  2,  2,  3,  0,
   };
 
+  if (geometryPool)
+    return CreateInPool(geometryPool, vertices, { { indices, 0.0f } }, GL_TRIANGLES);
   return Create(vertices, indices, GL_TRIANGLES);
 }
 
@@ -100,20 +318,17 @@ void Material::SetToProgram(const Program* program) const
     int textureCount = 0;
     if (diffuse)
     {
-        glActiveTexture(GL_TEXTURE0 + textureCount);
-        diffuse->Bind();
-        program->SetUniform("material.diffuse", textureCount);
+        diffuse->Bind(textureCount);
+        program->SetUniform(s_materialDiffuse, textureCount);
         ++textureCount;
     }
 
     if (specular)
     {
-        glActiveTexture(GL_TEXTURE0 + textureCount);
-        specular->Bind();
-        program->SetUniform("material.specular", textureCount);
+        specular->Bind(textureCount);
+        program->SetUniform(s_materialSpecular, textureCount);
         ++textureCount;
     }
 
-    glActiveTexture(GL_TEXTURE0);
-    program->SetUniform("material.shininess", shininess);
+    program->SetUniform(s_materialShininess, shininess);
 }
\ No newline at end of file
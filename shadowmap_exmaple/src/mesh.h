@@ -6,12 +6,15 @@
 #include "vertex_layout.h"
 #include "texture.h"
 #include "program.h"
+#include "bounds.h"
+#include "vertex_format.h"
+#include "geometry_pool.h"
 
-struct Vertex
+// LOD 하나의 index 와 원본에서 벗어난 정도 (local space 거리)
+struct MeshLodData
 {
-    glm::vec3 position;
-    glm::vec3 normal;
-    glm::vec2 texCoord;
+    std::vector<uint32_t> indices;
+    float error { 0.0f };
 };
 
 CLASS_PTR(Material);
@@ -34,41 +37,129 @@ CLASS_PTR(Mesh)
 class Mesh
 {
 public:
+    // index buffer 안의 구간. lod 0 이 원본, 숫자가 클수록 거칠다
+    struct Lod
+    {
+        uint32_t indexOffset;
+        uint32_t indexCount;
+        float error;
+    };
+
+    // GPU 에 올릴 모양으로 변환을 마친 mesh. vertices / indices 는 vertex format, index type 그대로의 byte 열
+    // 포인터가 가리키는 곳은 CreateFromData 가 끝날 때까지만 살아 있으면 된다 (mesh cache 의 mapping 등)
+    struct Data
+    {
+        uint32_t primitiveType { GL_TRIANGLES };
+        VertexFormat vertexFormat { VERTEX_FORMAT_FULL };
+        uint32_t indexType { GL_UNSIGNED_INT };
+        glm::vec4 vertexDequantize { glm::vec4(0.0f) };
+        BoundingBox boundingBox;
+        BoundingSphere boundingSphere;
+        const void* vertices { nullptr };
+        uint32_t vertexCount { 0 };
+        const void* indices { nullptr };
+        // 모든 LOD 의 index 를 이어 붙인 개수
+        uint32_t indexCount { 0 };
+        const Lod* lods { nullptr };
+        uint32_t lodCount { 0 };
+    };
+    // BuildData 가 변환한 vertex / index 를 담아 두는 곳
+    struct DataStorage
+    {
+        std::vector<CompactVertex> compactVertices;
+        std::vector<uint32_t> indices;
+        std::vector<uint16_t> shortIndices;
+        std::vector<Lod> lods;
+    };
+    // full format 이면 data.vertices 는 vertices 를 그대로 가리킨다
+    static Data BuildData(const std::vector<Vertex>& vertices, const std::vector<MeshLodData>& lods,
+        uint32_t primitiveType, VertexFormat vertexFormat, DataStorage& storage);
+    // geometryPool 이 있으면 pool 에 올린다. data 의 vertex format 은 pool 과 같아야 한다
+    static MeshUPtr CreateFromData(const Data& data, GeometryPoolPtr geometryPool = nullptr);
+
     static MeshUPtr Create(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, uint32_t primitiveType = GL_TRIANGLES);
-    static MeshUPtr CreateBox();
-    static MeshUPtr CreatePlane();
+    // 모든 LOD 가 vertex buffer 를 같이 쓰고, index 는 한 buffer 에 LOD 순서대로 이어 붙인다
+    static MeshUPtr CreateWithLods(const std::vector<Vertex>& vertices, const std::vector<MeshLodData>& lods,
+        uint32_t primitiveType = GL_TRIANGLES, VertexFormat vertexFormat = VERTEX_FORMAT_FULL);
+    // pool 의 vertex format 으로 pool 의 buffer 에 올린다. 자리가 없으면 mesh 의 buffer 를 따로 만든다
+    static MeshUPtr CreateInPool(GeometryPoolPtr geometryPool, const std::vector<Vertex>& vertices,
+        const std::vector<MeshLodData>& lods, uint32_t primitiveType = GL_TRIANGLES);
+    static MeshUPtr CreateBox(GeometryPoolPtr geometryPool = nullptr);
+    static MeshUPtr CreatePlane(GeometryPoolPtr geometryPool = nullptr);
+    ~Mesh();
 
+    // pool 에 들어간 mesh 는 pool 의 VAO / buffer 를 돌려준다
     const VertexLayout* GetVertexLayout() const
     {
-        return m_vertexLayout.get();
+        return m_geometryPool ? m_geometryPool->GetVertexLayout() : m_vertexLayout.get();
     }
     
     BufferPtr GetVertexBuffer() const
     {
-        return m_vertexBuffer;
+        return m_geometryPool ? m_geometryPool->GetVertexBuffer() : m_vertexBuffer;
     }
 
     BufferPtr GetIndexBuffer() const
     {
-        return m_indexBuffer;
+        return m_geometryPool ? m_geometryPool->GetIndexBuffer() : m_indexBuffer;
     }
 
+    // glDrawElementsBaseVertex 의 base vertex, pool 밖의 mesh 는 0
+    int32_t GetBaseVertex() const { return (int32_t)m_poolAllocation.baseVertex; }
+    // 이 mesh 가 buffer 에서 차지하는 byte 수
+    size_t GetVertexDataSize() const { return m_vertexDataSize; }
+    size_t GetIndexDataSize() const { return m_indexDataSize; }
+
     void SetMaterial(MaterialPtr material) { m_material = material; }
     MaterialPtr GetMaterial() const { return m_material; }
 
-    void Draw(const Program* program) const;
+    uint32_t GetPrimitiveType() const { return m_primitiveType; }
+    VertexFormat GetVertexFormat() const { return m_vertexFormat; }
+    // vertex 가 65536 개 이하이면 GL_UNSIGNED_SHORT
+    uint32_t GetIndexType() const { return m_indexType; }
+    // compact_vertex.glsl 의 vertexDequantize, full format 이면 0
+    const glm::vec4& GetVertexDequantize() const { return m_vertexDequantize; }
+    // local space, 생성할 때 vertex 로부터 계산
+    const BoundingBox& GetBoundingBox() const { return m_boundingBox; }
+    const BoundingSphere& GetBoundingSphere() const { return m_boundingSphere; }
+    // 다른 vertex layout (instancing 용 등) 에 이 mesh 의 vertex / index buffer 를 연결
+    void AttachToVertexLayout(const VertexLayout* vertexLayout) const;
+
+    uint32_t GetLodCount() const { return (uint32_t)m_lods.size(); }
+    const Lod& GetLod(uint32_t lod) const { return m_lods[std::min(lod, GetLodCount() - 1)]; }
+    // 화면에서 오차가 maxPixelError 이하인 가장 거친 lod
+    // pixelsPerUnit: local space 길이 1 이 화면에서 차지하는 pixel 수
+    // 지금보다 거친 lod 로는 오차가 (1 - hysteresis) 배 아래로 내려갈 때만 바꿔서 경계에서 깜빡이지 않게 한다
+    uint32_t SelectLod(float pixelsPerUnit, float maxPixelError, float hysteresis, uint32_t currentLod) const;
+    // glDrawElements 의 indices 인자로 넘길 lod 시작 위치 (byte)
+    size_t GetLodByteOffset(uint32_t lod) const;
+    // 그리기 전에 vertex format 에 맞는 복원 uniform 을 설정한다
+    void SetVertexUniforms(const Program* program) const;
+
+    void Draw(const Program* program, uint32_t lod = 0) const;
 
 private:
     Mesh() {}
-    void Init(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, uint32_t primitiveType);
+    bool Init(const Data& data, GeometryPoolPtr geometryPool);
 
     uint32_t m_primitiveType { GL_TRIANGLES };
+    VertexFormat m_vertexFormat { VERTEX_FORMAT_FULL };
+    uint32_t m_indexType { GL_UNSIGNED_INT };
+    glm::vec4 m_vertexDequantize { glm::vec4(0.0f) };
     
     VertexLayoutUPtr m_vertexLayout;
     BufferPtr m_vertexBuffer;
     BufferPtr m_indexBuffer;
+    GeometryPoolPtr m_geometryPool;
+    GeometryPool::Allocation m_poolAllocation;
+    size_t m_vertexDataSize { 0 };
+    size_t m_indexDataSize { 0 };
+    std::vector<Lod> m_lods;
 
     MaterialPtr m_material;
+
+    BoundingBox m_boundingBox;
+    BoundingSphere m_boundingSphere;
 };
 
 #endif // __MESH_H__
\ No newline at end of file
@@ -0,0 +1,345 @@
+#include "mesh_cache.h"
+#include <assimp/version.h>
+#include <cstring>
+#include <filesystem>
+
+namespace
+{
+    const uint32_t CACHE_MAGIC = 0x4b4f4f43; // "COOK"
+    // file 배치가 바뀌면 올린다
+    const uint32_t CACHE_VERSION = 2;
+    // vertex / index / lod block 의 시작 위치. mapping 안을 바로 가리켜도 정렬이 맞는다
+    const uint64_t BLOCK_ALIGNMENT = 16;
+
+    // [header][vertex, index, lod block ...][material 목차][mesh 목차][dependency 목차][문자열]
+    struct CacheHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint32_t materialCount;
+        uint32_t meshCount;
+        uint64_t tableOffset;
+        uint32_t dependencyCount;
+        uint32_t padding;
+    };
+
+    // 문자열 위치는 문자열 영역의 시작 기준
+    struct MaterialRecord
+    {
+        uint32_t diffuseOffset;
+        uint32_t diffuseLength;
+        uint32_t specularOffset;
+        uint32_t specularLength;
+    };
+
+    struct DependencyRecord
+    {
+        uint32_t pathOffset;
+        uint32_t pathLength;
+        uint64_t hash;
+    };
+
+    uint64_t AlignOffset(uint64_t offset)
+    {
+        return (offset + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT * BLOCK_ALIGNMENT;
+    }
+
+    size_t GetIndexSize(uint32_t indexType)
+    {
+        return indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    }
+}
+
+static_assert(sizeof(Mesh::Lod) == 12, "mesh lod is stored as is in the mesh cache");
+
+uint64_t HashFile(const std::string& filepath)
+{
+    auto file = MappedFile::Open(filepath);
+    return file ? HashBytes(file->GetData(), file->GetSize()) : 0;
+}
+
+uint64_t MeshCache::MakeKey(const MappedFile& source, VertexFormat vertexFormat)
+{
+    uint32_t versions[] = {
+        CACHE_VERSION, IMPORTER_VERSION, (uint32_t)vertexFormat,
+        aiGetVersionMajor(), aiGetVersionMinor(), aiGetVersionRevision(),
+    };
+    uint64_t key = HashBytes(versions, sizeof(versions));
+    return HashBytes(source.GetData(), source.GetSize(), key);
+}
+
+std::string MeshCache::GetFilePath(uint64_t key)
+{
+    return fmt::format("{}/{:016x}.mesh", MESH_CACHE_PATH, key);
+}
+
+MeshCacheUPtr MeshCache::Open(uint64_t key)
+{
+    auto cache = MeshCacheUPtr(new MeshCache());
+    if (!cache->Init(key))
+        return nullptr;
+    return std::move(cache);
+}
+
+bool MeshCache::Init(uint64_t key)
+{
+    static_assert(sizeof(MeshRecord) == 112, "mesh record layout changed, bump CACHE_VERSION");
+    auto filepath = GetFilePath(key);
+    m_file = MappedFile::Open(filepath);
+    if (!m_file)
+        return false;
+
+    const uint8_t* data = m_file->GetData();
+    uint64_t size = m_file->GetSize();
+    // offset, 크기가 file 안에 들어가는지
+    auto InFile = [&](uint64_t offset, uint64_t length) {
+        return offset <= size && length <= size - offset;
+    };
+
+    auto Reject = [&]() {
+        SPDLOG_WARN("broken mesh cache: {}", filepath);
+        m_file.reset();
+        std::error_code error;
+        std::filesystem::remove(filepath, error);
+        return false;
+    };
+
+    CacheHeader header = {};
+    if (size < sizeof(header))
+        return Reject();
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION || header.key != key)
+        return Reject();
+
+    uint64_t materialTableSize = (uint64_t)header.materialCount * sizeof(MaterialRecord);
+    uint64_t meshTableSize = (uint64_t)header.meshCount * sizeof(MeshRecord);
+    uint64_t dependencyTableSize = (uint64_t)header.dependencyCount * sizeof(DependencyRecord);
+    if (!InFile(header.tableOffset, materialTableSize + meshTableSize + dependencyTableSize))
+        return Reject();
+    uint64_t dependencyTableOffset = header.tableOffset + materialTableSize + meshTableSize;
+    uint64_t stringOffset = dependencyTableOffset + dependencyTableSize;
+
+    auto ReadString = [&](uint32_t offset, uint32_t length, std::string& text) {
+        if (!InFile(stringOffset + offset, length))
+            return false;
+        text.assign(reinterpret_cast<const char*>(data + stringOffset + offset), length);
+        return true;
+    };
+    m_materials.resize(header.materialCount);
+    for (uint32_t i = 0; i < header.materialCount; ++i)
+    {
+        MaterialRecord record = {};
+        memcpy(&record, data + header.tableOffset + i * sizeof(MaterialRecord), sizeof(record));
+        if (!ReadString(record.diffuseOffset, record.diffuseLength, m_materials[i].diffuse) ||
+            !ReadString(record.specularOffset, record.specularLength, m_materials[i].specular))
+            return Reject();
+    }
+
+    // .mtl 처럼 key 에 들어가지 않은 file 이 바뀌었으면 깨진 것은 아니지만 다시 import 해야 한다
+    for (uint32_t i = 0; i < header.dependencyCount; ++i)
+    {
+        DependencyRecord record = {};
+        memcpy(&record, data + dependencyTableOffset + i * sizeof(DependencyRecord), sizeof(record));
+        std::string dependencyPath;
+        if (!ReadString(record.pathOffset, record.pathLength, dependencyPath))
+            return Reject();
+        if (HashFile(dependencyPath) != record.hash)
+        {
+            SPDLOG_INFO("mesh cache is out of date: {} changed", dependencyPath);
+            m_file.reset();
+            return false;
+        }
+    }
+
+    m_meshes.resize(header.meshCount);
+    m_materialIndices.resize(header.meshCount);
+    for (uint32_t i = 0; i < header.meshCount; ++i)
+    {
+        MeshRecord record = {};
+        memcpy(&record, data + header.tableOffset + materialTableSize + i * sizeof(MeshRecord), sizeof(record));
+        if (record.vertexFormat >= VERTEX_FORMAT_COUNT ||
+            (record.indexType != GL_UNSIGNED_SHORT && record.indexType != GL_UNSIGNED_INT) ||
+            record.lodCount == 0 ||
+            record.vertexOffset % BLOCK_ALIGNMENT || record.indexOffset % BLOCK_ALIGNMENT ||
+            record.lodOffset % BLOCK_ALIGNMENT)
+            return Reject();
+
+        auto vertexFormat = (VertexFormat)record.vertexFormat;
+        uint64_t vertexSize = (uint64_t)record.vertexCount * GetVertexFormatStride(vertexFormat);
+        uint64_t indexSize = (uint64_t)record.indexCount * GetIndexSize(record.indexType);
+        uint64_t lodSize = (uint64_t)record.lodCount * sizeof(Mesh::Lod);
+        if (!InFile(record.vertexOffset, vertexSize) || !InFile(record.indexOffset, indexSize) ||
+            !InFile(record.lodOffset, lodSize))
+            return Reject();
+
+        auto lods = reinterpret_cast<const Mesh::Lod*>(data + record.lodOffset);
+        for (uint32_t lod = 0; lod < record.lodCount; ++lod)
+        {
+            if ((uint64_t)lods[lod].indexOffset + lods[lod].indexCount > record.indexCount)
+                return Reject();
+        }
+
+        auto& mesh = m_meshes[i];
+        mesh.primitiveType = record.primitiveType;
+        mesh.vertexFormat = vertexFormat;
+        mesh.indexType = record.indexType;
+        mesh.vertexDequantize = record.vertexDequantize;
+        mesh.boundingBox.min = record.boxMin;
+        mesh.boundingBox.max = record.boxMax;
+        mesh.boundingSphere.center = record.sphereCenter;
+        mesh.boundingSphere.radius = record.sphereRadius;
+        mesh.vertices = data + record.vertexOffset;
+        mesh.vertexCount = record.vertexCount;
+        mesh.indices = data + record.indexOffset;
+        mesh.indexCount = record.indexCount;
+        mesh.lods = lods;
+        mesh.lodCount = record.lodCount;
+        m_materialIndices[i] = record.materialIndex < (int32_t)header.materialCount ? record.materialIndex : -1;
+    }
+    return true;
+}
+
+MeshCacheWriterUPtr MeshCacheWriter::Create(uint64_t key)
+{
+    auto writer = MeshCacheWriterUPtr(new MeshCacheWriter());
+    if (!writer->Init(key))
+        return nullptr;
+    return std::move(writer);
+}
+
+bool MeshCacheWriter::Init(uint64_t key)
+{
+    std::error_code error;
+    std::filesystem::create_directories(MESH_CACHE_PATH, error);
+
+    m_key = key;
+    m_tempPath = MeshCache::GetFilePath(key) + ".tmp";
+    m_fout.open(m_tempPath, std::ios::binary | std::ios::trunc);
+    if (!m_fout.is_open())
+    {
+        SPDLOG_WARN("failed to write mesh cache: {}", m_tempPath);
+        return false;
+    }
+
+    // header 는 목차 위치를 알게 되는 Finish 에서 다시 쓴다
+    CacheHeader header = {};
+    m_fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_offset = sizeof(header);
+    return true;
+}
+
+MeshCacheWriter::~MeshCacheWriter()
+{
+    if (m_finished)
+        return;
+    m_fout.close();
+    std::error_code error;
+    std::filesystem::remove(m_tempPath, error);
+}
+
+uint64_t MeshCacheWriter::WriteBlock(const void* data, size_t size)
+{
+    static const char zeros[BLOCK_ALIGNMENT] = {};
+    uint64_t offset = AlignOffset(m_offset);
+    m_fout.write(zeros, offset - m_offset);
+    m_fout.write(reinterpret_cast<const char*>(data), size);
+    m_offset = offset + size;
+    return offset;
+}
+
+void MeshCacheWriter::AddMaterial(const MeshCache::Material& material)
+{
+    m_materials.push_back(material);
+}
+
+void MeshCacheWriter::AddDependency(const std::string& filepath)
+{
+    for (const auto& dependency : m_dependencies)
+    {
+        if (dependency.first == filepath)
+            return;
+    }
+    m_dependencies.push_back({ filepath, HashFile(filepath) });
+}
+
+void MeshCacheWriter::AddMesh(const Mesh::Data& data, int32_t materialIndex)
+{
+    MeshCache::MeshRecord record = {};
+    record.primitiveType = data.primitiveType;
+    record.vertexFormat = data.vertexFormat;
+    record.indexType = data.indexType;
+    record.materialIndex = materialIndex;
+    record.vertexDequantize = data.vertexDequantize;
+    record.boxMin = data.boundingBox.min;
+    record.boxMax = data.boundingBox.max;
+    record.sphereCenter = data.boundingSphere.center;
+    record.sphereRadius = data.boundingSphere.radius;
+    record.vertexCount = data.vertexCount;
+    record.indexCount = data.indexCount;
+    record.lodCount = data.lodCount;
+
+    record.vertexOffset = WriteBlock(data.vertices, data.vertexCount * GetVertexFormatStride(data.vertexFormat));
+    record.indexOffset = WriteBlock(data.indices, data.indexCount * GetIndexSize(data.indexType));
+    record.lodOffset = WriteBlock(data.lods, data.lodCount * sizeof(Mesh::Lod));
+    m_meshRecords.push_back(record);
+}
+
+bool MeshCacheWriter::Finish()
+{
+    std::string strings;
+    std::vector<MaterialRecord> materialRecords;
+    auto AddString = [&](const std::string& text, uint32_t& offset, uint32_t& length) {
+        offset = (uint32_t)strings.size();
+        length = (uint32_t)text.size();
+        strings += text;
+    };
+    for (const auto& material : m_materials)
+    {
+        MaterialRecord record = {};
+        AddString(material.diffuse, record.diffuseOffset, record.diffuseLength);
+        AddString(material.specular, record.specularOffset, record.specularLength);
+        materialRecords.push_back(record);
+    }
+    std::vector<DependencyRecord> dependencyRecords;
+    for (const auto& dependency : m_dependencies)
+    {
+        DependencyRecord record = {};
+        AddString(dependency.first, record.pathOffset, record.pathLength);
+        record.hash = dependency.second;
+        dependencyRecords.push_back(record);
+    }
+
+    CacheHeader header = {};
+    header.magic = CACHE_MAGIC;
+    header.version = CACHE_VERSION;
+    header.key = m_key;
+    header.materialCount = (uint32_t)materialRecords.size();
+    header.meshCount = (uint32_t)m_meshRecords.size();
+    header.dependencyCount = (uint32_t)dependencyRecords.size();
+    header.tableOffset = WriteBlock(materialRecords.data(), materialRecords.size() * sizeof(MaterialRecord));
+    m_fout.write(reinterpret_cast<const char*>(m_meshRecords.data()),
+        m_meshRecords.size() * sizeof(MeshCache::MeshRecord));
+    m_fout.write(reinterpret_cast<const char*>(dependencyRecords.data()),
+        dependencyRecords.size() * sizeof(DependencyRecord));
+    m_fout.write(strings.data(), strings.size());
+    m_fout.seekp(0);
+    m_fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_fout.close();
+    if (m_fout.fail())
+    {
+        SPDLOG_WARN("failed to write mesh cache: {}", m_tempPath);
+        return false;
+    }
+
+    auto filepath = MeshCache::GetFilePath(m_key);
+    std::error_code error;
+    std::filesystem::rename(m_tempPath, filepath, error);
+    if (error)
+    {
+        SPDLOG_WARN("failed to write mesh cache: {} ({})", filepath, error.message());
+        return false;
+    }
+    m_finished = true;
+    return true;
+}
\ No newline at end of file
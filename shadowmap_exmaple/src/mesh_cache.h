@@ -0,0 +1,105 @@
+#ifndef __MESH_CACHE_H__
+#define __MESH_CACHE_H__
+
+#include "common.h"
+#include "mesh.h"
+#include "mapped_file.h"
+#include <fstream>
+
+// assimp import, 최적화, LOD, 양자화까지 마친 model 을 GPU 에 올릴 모양 그대로 저장한 cooked file
+// 읽을 때는 file 을 mmap 하고 Mesh::Data 가 mapping 안을 가리키게 해서 복사 없이 buffer 에 올린다
+// key 는 원본 file 내용, importer version, vertex format 으로 만들기 때문에 하나라도 바뀌면 miss 가 난다
+// import 중에 같이 읽은 file (.obj 의 .mtl 등) 은 내용 hash 를 file 에 적어 두고 Open 할 때 맞춰 본다
+CLASS_PTR(MeshCache)
+class MeshCache
+{
+public:
+    // Model 의 import 처리 (최적화, LOD, 양자화 등) 를 바꾸면 올려서 이전 cache 를 버린다
+    static const uint32_t IMPORTER_VERSION = 1;
+
+    // texture 경로는 model file 이 있는 directory 기준
+    struct Material
+    {
+        std::string diffuse;
+        std::string specular;
+    };
+
+    static uint64_t MakeKey(const MappedFile& source, VertexFormat vertexFormat);
+    static std::string GetFilePath(uint64_t key);
+    // 없거나, 깨졌거나, key 가 다르거나, dependency 내용이 바뀌었으면 nullptr
+    static MeshCacheUPtr Open(uint64_t key);
+
+    const std::vector<Material>& GetMaterials() const { return m_materials; }
+    size_t GetMeshCount() const { return m_meshes.size(); }
+    // 포인터는 MeshCache 가 살아 있는 동안만 유효하다
+    const Mesh::Data& GetMeshData(size_t index) const { return m_meshes[index]; }
+    // 없으면 -1
+    int32_t GetMaterialIndex(size_t index) const { return m_materialIndices[index]; }
+
+private:
+    friend class MeshCacheWriter;
+    // file 안의 mesh 목차 한 줄, offset 은 file 처음 기준
+    struct MeshRecord
+    {
+        uint32_t primitiveType;
+        uint32_t vertexFormat;
+        uint32_t indexType;
+        int32_t materialIndex;
+        glm::vec4 vertexDequantize;
+        glm::vec3 boxMin;
+        glm::vec3 boxMax;
+        glm::vec3 sphereCenter;
+        float sphereRadius;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t lodCount;
+        uint32_t padding;
+        uint64_t vertexOffset;
+        uint64_t indexOffset;
+        uint64_t lodOffset;
+    };
+
+    MeshCache() {}
+    bool Init(uint64_t key);
+
+    MappedFileUPtr m_file;
+    std::vector<Material> m_materials;
+    std::vector<Mesh::Data> m_meshes;
+    std::vector<int32_t> m_materialIndices;
+};
+
+// 없거나 비어 있으면 0
+uint64_t HashFile(const std::string& filepath);
+
+// import 하면서 mesh 하나씩 data 를 바로 file 에 쓰고 Finish 에서 목차를 붙인다
+// 임시 file 에 쓰고 다 끝나면 이름을 바꾸므로 중간에 죽어도 깨진 cache 가 남지 않는다
+CLASS_PTR(MeshCacheWriter)
+class MeshCacheWriter
+{
+public:
+    static MeshCacheWriterUPtr Create(uint64_t key);
+    ~MeshCacheWriter();
+
+    void AddMaterial(const MeshCache::Material& material);
+    // 지금 내용의 hash 를 적는다. model file 자체는 key 에 들어가므로 넣지 않아도 된다
+    void AddDependency(const std::string& filepath);
+    void AddMesh(const Mesh::Data& data, int32_t materialIndex);
+    bool Finish();
+
+private:
+    MeshCacheWriter() {}
+    bool Init(uint64_t key);
+    uint64_t WriteBlock(const void* data, size_t size);
+
+    uint64_t m_key { 0 };
+    std::string m_tempPath;
+    std::ofstream m_fout;
+    // 지금까지 쓴 byte 수
+    uint64_t m_offset { 0 };
+    std::vector<MeshCache::Material> m_materials;
+    std::vector<std::pair<std::string, uint64_t>> m_dependencies;
+    std::vector<MeshCache::MeshRecord> m_meshRecords;
+    bool m_finished { false };
+};
+
+#endif // __MESH_CACHE_H__
\ No newline at end of file
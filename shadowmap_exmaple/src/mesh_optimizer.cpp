@@ -0,0 +1,304 @@
+#include "mesh_optimizer.h"
+#include <algorithm>
+#include <cmath>
+
+// Forsyth 점수 계산에 쓰는 cache 크기와 상수
+static const int SCORE_CACHE_SIZE = 32;
+static const float CACHE_DECAY_POWER = 1.5f;
+static const float LAST_TRIANGLE_SCORE = 0.75f;
+static const float VALENCE_BOOST_SCALE = 2.0f;
+static const float VALENCE_BOOST_POWER = 0.5f;
+// overdraw 의 cluster 경계와 결과 비교에 쓰는 FIFO 크기
+static const uint32_t SIMULATED_CACHE_SIZE = 16;
+
+VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+{
+    VertexCacheStats stats;
+    if (indices.empty())
+        return stats;
+
+    // 각 vertex 가 들어온 시점의 miss 번호로 FIFO 안에 남아 있는지 판단한다
+    std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+    std::vector<uint8_t> used(vertexCount, 0);
+    uint32_t timestamp = cacheSize + 1;
+    uint32_t misses = 0;
+    uint32_t usedCount = 0;
+    for (auto index : indices)
+    {
+        if (!used[index])
+        {
+            used[index] = 1;
+            ++usedCount;
+        }
+        if (timestamp - cacheTimestamps[index] > cacheSize)
+        {
+            cacheTimestamps[index] = timestamp++;
+            ++misses;
+        }
+    }
+
+    stats.acmr = (float)misses / (float)(indices.size() / 3);
+    stats.atvr = (float)misses / (float)std::max(usedCount, 1u);
+    return stats;
+}
+
+static float ComputeVertexScore(int cachePosition, uint32_t remainingTriangles)
+{
+    if (remainingTriangles == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // 방금 쓴 triangle 의 vertex 는 일부러 조금 낮춰서 한 방향으로 쓸고 가게 한다
+        if (cachePosition < 3)
+            score = LAST_TRIANGLE_SCORE;
+        else
+        {
+            float scaler = 1.0f / (SCORE_CACHE_SIZE - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+        }
+    }
+    // 남은 triangle 이 적은 vertex 를 먼저 끝내서 외톨이 triangle 이 생기지 않게 한다
+    score += VALENCE_BOOST_SCALE * std::pow((float)remainingTriangles, -VALENCE_BOOST_POWER);
+    return score;
+}
+
+void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount)
+{
+    const uint32_t triangleCount = (uint32_t)(indices.size() / 3);
+    if (triangleCount == 0)
+        return;
+
+    // vertex 별 인접 triangle 목록 (CSR)
+    std::vector<uint32_t> triangleOffsets(vertexCount + 1, 0);
+    for (auto index : indices)
+        ++triangleOffsets[index + 1];
+    for (size_t i = 0; i < vertexCount; ++i)
+        triangleOffsets[i + 1] += triangleOffsets[i];
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (size_t i = 0; i < vertexCount; ++i)
+        remaining[i] = triangleOffsets[i + 1] - triangleOffsets[i];
+    std::vector<uint32_t> vertexTriangles(indices.size());
+    {
+        std::vector<uint32_t> cursor(triangleOffsets.begin(), triangleOffsets.end() - 1);
+        for (uint32_t t = 0; t < triangleCount; ++t)
+        {
+            for (int k = 0; k < 3; ++k)
+                vertexTriangles[cursor[indices[t * 3 + k]]++] = t;
+        }
+    }
+
+    std::vector<int> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i)
+        vertexScores[i] = ComputeVertexScore(-1, remaining[i]);
+    std::vector<float> triangleScores(triangleCount);
+    for (uint32_t t = 0; t < triangleCount; ++t)
+    {
+        triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] +
+            vertexScores[indices[t * 3 + 2]];
+    }
+    std::vector<uint8_t> emitted(triangleCount, 0);
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    // 새로 들어온 3개를 앞에 두고 밀려난 vertex 까지 담을 수 있게 3 칸 더
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> nextCache;
+    cache.reserve(SCORE_CACHE_SIZE + 3);
+    nextCache.reserve(SCORE_CACHE_SIZE + 3);
+
+    uint32_t scanCursor = 0;
+    int bestTriangle = -1;
+    float bestScore = -1.0f;
+    for (uint32_t t = 0; t < triangleCount; ++t)
+    {
+        if (triangleScores[t] > bestScore)
+        {
+            bestScore = triangleScores[t];
+            bestTriangle = (int)t;
+        }
+    }
+
+    while (bestTriangle >= 0)
+    {
+        const uint32_t* triangle = &indices[bestTriangle * 3];
+        emitted[bestTriangle] = 1;
+        result.insert(result.end(), triangle, triangle + 3);
+
+        // 방금 쓴 vertex 를 cache 앞으로
+        nextCache.assign(triangle, triangle + 3);
+        for (auto vertex : cache)
+        {
+            if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+                nextCache.push_back(vertex);
+        }
+        for (int k = 0; k < 3; ++k)
+        {
+            uint32_t vertex = triangle[k];
+            uint32_t* begin = &vertexTriangles[triangleOffsets[vertex]];
+            uint32_t* end = begin + remaining[vertex];
+            auto iter = std::find(begin, end, (uint32_t)bestTriangle);
+            std::swap(*iter, *(end - 1));
+            --remaining[vertex];
+        }
+
+        // cache 안 vertex 들의 점수와 그 triangle 점수를 갱신하면서 다음 후보를 고른다
+        for (size_t i = 0; i < nextCache.size(); ++i)
+        {
+            uint32_t vertex = nextCache[i];
+            cachePositions[vertex] = i < SCORE_CACHE_SIZE ? (int)i : -1;
+            float score = ComputeVertexScore(cachePositions[vertex], remaining[vertex]);
+            float delta = score - vertexScores[vertex];
+            vertexScores[vertex] = score;
+            for (uint32_t j = 0; j < remaining[vertex]; ++j)
+                triangleScores[vertexTriangles[triangleOffsets[vertex] + j]] += delta;
+        }
+        if (nextCache.size() > SCORE_CACHE_SIZE)
+            nextCache.resize(SCORE_CACHE_SIZE);
+        std::swap(cache, nextCache);
+
+        bestTriangle = -1;
+        bestScore = -1.0f;
+        for (auto vertex : cache)
+        {
+            for (uint32_t j = 0; j < remaining[vertex]; ++j)
+            {
+                uint32_t t = vertexTriangles[triangleOffsets[vertex] + j];
+                if (triangleScores[t] > bestScore)
+                {
+                    bestScore = triangleScores[t];
+                    bestTriangle = (int)t;
+                }
+            }
+        }
+
+        // cache 주변에 남은 triangle 이 없으면 아직 안 쓴 triangle 중 아무거나
+        if (bestTriangle < 0)
+        {
+            while (scanCursor < triangleCount && emitted[scanCursor])
+                ++scanCursor;
+            if (scanCursor < triangleCount)
+                bestTriangle = (int)scanCursor;
+        }
+    }
+
+    indices.swap(result);
+}
+
+void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold)
+{
+    const uint32_t triangleCount = (uint32_t)(indices.size() / 3);
+    if (triangleCount < 2)
+        return;
+
+    // 세 vertex 가 모두 miss 인 곳 (cache 가 새로 시작하는 곳) 에서 자르면 cache 효율을 거의 잃지 않는다
+    std::vector<uint32_t> clusterStarts;
+    {
+        std::vector<uint32_t> cacheTimestamps(vertices.size(), 0);
+        uint32_t timestamp = SIMULATED_CACHE_SIZE + 1;
+        for (uint32_t t = 0; t < triangleCount; ++t)
+        {
+            int misses = 0;
+            for (int k = 0; k < 3; ++k)
+            {
+                uint32_t index = indices[t * 3 + k];
+                if (timestamp - cacheTimestamps[index] > SIMULATED_CACHE_SIZE)
+                {
+                    cacheTimestamps[index] = timestamp++;
+                    ++misses;
+                }
+            }
+            if (t == 0 || misses == 3)
+                clusterStarts.push_back(t);
+        }
+    }
+    const uint32_t clusterCount = (uint32_t)clusterStarts.size();
+    if (clusterCount < 2)
+        return;
+    clusterStarts.push_back(triangleCount);
+
+    // mesh 중심에서 바깥을 향하는 cluster 일수록 다른 cluster 를 가릴 가능성이 높다
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3(0.0f));
+    std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3(0.0f));
+    std::vector<float> clusterAreas(clusterCount, 0.0f);
+    for (uint32_t c = 0; c < clusterCount; ++c)
+    {
+        for (uint32_t t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t)
+        {
+            const auto& p0 = vertices[indices[t * 3]].position;
+            const auto& p1 = vertices[indices[t * 3 + 1]].position;
+            const auto& p2 = vertices[indices[t * 3 + 2]].position;
+            auto normal = glm::cross(p1 - p0, p2 - p0);
+            float area = glm::length(normal) * 0.5f;
+            auto centroid = (p0 + p1 + p2) / 3.0f;
+            clusterCentroids[c] += centroid * area;
+            clusterNormals[c] += normal;
+            clusterAreas[c] += area;
+            meshCentroid += centroid * area;
+            meshArea += area;
+        }
+    }
+    if (meshArea <= 0.0f)
+        return;
+    meshCentroid /= meshArea;
+
+    std::vector<float> occlusionPotential(clusterCount, 0.0f);
+    for (uint32_t c = 0; c < clusterCount; ++c)
+    {
+        float normalLength = glm::length(clusterNormals[c]);
+        if (clusterAreas[c] <= 0.0f || normalLength <= 0.0f)
+            continue;
+        auto centroid = clusterCentroids[c] / clusterAreas[c];
+        occlusionPotential[c] = glm::dot(centroid - meshCentroid, clusterNormals[c] / normalLength);
+    }
+
+    std::vector<uint32_t> clusterOrder(clusterCount);
+    for (uint32_t c = 0; c < clusterCount; ++c)
+        clusterOrder[c] = c;
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](uint32_t a, uint32_t b) {
+        return occlusionPotential[a] > occlusionPotential[b];
+    });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (auto c : clusterOrder)
+        result.insert(result.end(), &indices[clusterStarts[c] * 3], &indices[clusterStarts[c + 1] * 3]);
+
+    auto before = AnalyzeVertexCache(indices, vertices.size(), SIMULATED_CACHE_SIZE);
+    auto after = AnalyzeVertexCache(result, vertices.size(), SIMULATED_CACHE_SIZE);
+    if (after.acmr <= before.acmr * threshold)
+        indices.swap(result);
+}
+
+void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+    const uint32_t unused = 0xffffffffu;
+    std::vector<uint32_t> remap(vertices.size(), unused);
+    std::vector<Vertex> result;
+    result.reserve(vertices.size());
+    for (auto& index : indices)
+    {
+        if (remap[index] == unused)
+        {
+            remap[index] = (uint32_t)result.size();
+            result.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(result);
+}
+
+void OptimizeMesh(const std::string& name, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+    auto before = AnalyzeVertexCache(indices, vertices.size());
+    OptimizeVertexCache(indices, vertices.size());
+    OptimizeOverdraw(indices, vertices);
+    OptimizeVertexFetch(vertices, indices);
+    auto after = AnalyzeVertexCache(indices, vertices.size());
+    SPDLOG_INFO("mesh {}: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+        name, before.acmr, after.acmr, before.atvr, after.atvr);
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#ifndef __MESH_OPTIMIZER_H__
+#define __MESH_OPTIMIZER_H__
+
+#include "common.h"
+#include "mesh.h"
+#include <vector>
+
+// FIFO post-transform cache 를 흉내내서 센 값
+// acmr: triangle 당 vertex shader 실행 수 (0.5 ~ 3)
+// atvr: 실제 쓰인 vertex 당 실행 수 (1 이 최선)
+struct VertexCacheStats
+{
+    float acmr { 0.0f };
+    float atvr { 0.0f };
+};
+
+VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = 16);
+
+// Tom Forsyth 의 linear-speed vertex cache optimisation 으로 triangle 순서를 바꾼다
+void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+// cache 가 비워지는 곳에서 triangle 을 cluster 로 나누고 바깥을 향한 cluster 를 먼저 그린다 (Sander et al. 2007)
+// ACMR 이 threshold 배보다 나빠지면 원래 순서를 유지한다
+void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold = 1.05f);
+
+// index 에 처음 나오는 순서대로 vertex 를 다시 배치한다. 쓰이지 않는 vertex 는 버린다
+void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+// 위 세 단계를 순서대로 하고 전후 ACMR / ATVR 을 log 로 남긴다
+void OptimizeMesh(const std::string& name, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+#endif // __MESH_OPTIMIZER_H__
\ No newline at end of file
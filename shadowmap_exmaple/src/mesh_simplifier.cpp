@@ -0,0 +1,303 @@
+#include "mesh_simplifier.h"
+#include <algorithm>
+#include <queue>
+#include <unordered_map>
+
+// 이보다 적게 줄어들면 다음 LOD 를 만들지 않는다
+static const float MIN_LOD_REDUCTION = 0.9f;
+static const uint32_t MIN_LOD_TRIANGLES = 8;
+
+// 평면까지 거리 제곱의 합을 나타내는 대칭 4x4 행렬 (위 삼각형 10개)
+// weight 는 더한 평면의 면적 합, 오차를 평균 거리로 바꿀 때 쓴다
+struct Quadric
+{
+    double a2 { 0.0 }, ab { 0.0 }, ac { 0.0 }, ad { 0.0 };
+    double b2 { 0.0 }, bc { 0.0 }, bd { 0.0 };
+    double c2 { 0.0 }, cd { 0.0 };
+    double d2 { 0.0 };
+    double weight { 0.0 };
+
+    void AddPlane(const glm::vec3& normal, float distance, float planeWeight)
+    {
+        double a = normal.x, b = normal.y, c = normal.z, d = distance, w = planeWeight;
+        a2 += w * a * a; ab += w * a * b; ac += w * a * c; ad += w * a * d;
+        b2 += w * b * b; bc += w * b * c; bd += w * b * d;
+        c2 += w * c * c; cd += w * c * d;
+        d2 += w * d * d;
+        weight += w;
+    }
+
+    void Add(const Quadric& other)
+    {
+        a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+        b2 += other.b2; bc += other.bc; bd += other.bd;
+        c2 += other.c2; cd += other.cd;
+        d2 += other.d2;
+        weight += other.weight;
+    }
+
+    double Evaluate(const glm::vec3& point) const
+    {
+        double x = point.x, y = point.y, z = point.z;
+        double result =
+            a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x +
+            b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y +
+            c2 * z * z + 2.0 * cd * z +
+            d2;
+        return std::max(result, 0.0);
+    }
+};
+
+struct Collapse
+{
+    float error;
+    uint32_t from;
+    uint32_t to;
+    uint32_t fromVersion;
+    uint32_t toVersion;
+
+    bool operator>(const Collapse& other) const { return error > other.error; }
+};
+
+// 위치가 같은 vertex 를 하나의 group 으로 묶는다
+static std::vector<uint32_t> BuildPositionGroups(const std::vector<Vertex>& vertices)
+{
+    struct PositionHash
+    {
+        size_t operator()(const glm::vec3& position) const { return (size_t)HashBytes(&position, sizeof(position)); }
+    };
+    std::unordered_map<glm::vec3, uint32_t, PositionHash> firstVertex;
+    firstVertex.reserve(vertices.size());
+
+    std::vector<uint32_t> groups(vertices.size());
+    for (uint32_t i = 0; i < (uint32_t)vertices.size(); ++i)
+    {
+        // -0 과 0 이 같은 hash 가 되도록
+        auto position = vertices[i].position + glm::vec3(0.0f);
+        groups[i] = firstVertex.emplace(position, i).first->second;
+    }
+    return groups;
+}
+
+static glm::vec3 GetTriangleNormal(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2)
+{
+    return glm::cross(p1 - p0, p2 - p0);
+}
+
+std::vector<uint32_t> SimplifyMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+    size_t targetIndexCount, float& resultError)
+{
+    resultError = 0.0f;
+    const uint32_t vertexCount = (uint32_t)vertices.size();
+    const uint32_t triangleCount = (uint32_t)(indices.size() / 3);
+    std::vector<uint32_t> triangles(indices.begin(), indices.begin() + triangleCount * 3);
+    if (triangleCount * 3 <= targetIndexCount)
+        return triangles;
+
+    auto groups = BuildPositionGroups(vertices);
+
+    // group 에 vertex 가 둘 이상이면 seam
+    std::vector<uint32_t> groupSizes(vertexCount, 0);
+    for (auto group : groups)
+        ++groupSizes[group];
+    std::vector<uint8_t> locked(vertexCount, 0);
+    for (uint32_t i = 0; i < vertexCount; ++i)
+        locked[i] = groupSizes[groups[i]] > 1;
+
+    // 위치 기준으로 triangle 하나에만 (또는 셋 이상에) 쓰인 edge 의 끝은 고정
+    std::unordered_map<uint64_t, uint32_t> edgeUses;
+    edgeUses.reserve(triangleCount * 3);
+    auto EdgeKey = [&](uint32_t a, uint32_t b) {
+        uint64_t ga = groups[a], gb = groups[b];
+        return ga < gb ? (ga << 32) | gb : (gb << 32) | ga;
+    };
+    for (uint32_t t = 0; t < triangleCount; ++t)
+    {
+        for (int e = 0; e < 3; ++e)
+            ++edgeUses[EdgeKey(triangles[t * 3 + e], triangles[t * 3 + (e + 1) % 3])];
+    }
+    for (uint32_t t = 0; t < triangleCount; ++t)
+    {
+        for (int e = 0; e < 3; ++e)
+        {
+            uint32_t a = triangles[t * 3 + e];
+            uint32_t b = triangles[t * 3 + (e + 1) % 3];
+            if (edgeUses[EdgeKey(a, b)] != 2)
+                locked[a] = locked[b] = 1;
+        }
+    }
+
+    // group 별 quadric, triangle 면적으로 가중
+    std::vector<Quadric> quadrics(vertexCount);
+    std::vector<std::vector<uint32_t>> vertexTriangles(vertexCount);
+    for (uint32_t t = 0; t < triangleCount; ++t)
+    {
+        const uint32_t* triangle = &triangles[t * 3];
+        for (int k = 0; k < 3; ++k)
+            vertexTriangles[triangle[k]].push_back(t);
+
+        const auto& p0 = vertices[triangle[0]].position;
+        auto normal = GetTriangleNormal(p0, vertices[triangle[1]].position, vertices[triangle[2]].position);
+        float doubleArea = glm::length(normal);
+        if (doubleArea <= 0.0f)
+            continue;
+        normal /= doubleArea;
+        for (int k = 0; k < 3; ++k)
+            quadrics[groups[triangle[k]]].AddPlane(normal, -glm::dot(normal, p0), doubleArea * 0.5f);
+    }
+
+    auto HasGroup = [&](const uint32_t* triangle, uint32_t group) {
+        return groups[triangle[0]] == group || groups[triangle[1]] == group || groups[triangle[2]] == group;
+    };
+
+    std::vector<uint32_t> versions(vertexCount, 0);
+    std::vector<uint8_t> removed(vertexCount, 0);
+    std::vector<uint8_t> deleted(triangleCount, 0);
+    uint32_t liveTriangles = triangleCount;
+
+    // from 을 to 의 위치로 옮겼을 때 두 quadric 의 평균 거리
+    auto ComputeError = [&](uint32_t from, uint32_t to) {
+        Quadric quadric = quadrics[groups[from]];
+        quadric.Add(quadrics[groups[to]]);
+        if (quadric.weight <= 0.0)
+            return 0.0f;
+        return (float)std::sqrt(quadric.Evaluate(vertices[to].position) / quadric.weight);
+    };
+
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap;
+    auto PushCollapse = [&](uint32_t from, uint32_t to) {
+        if (locked[from] || removed[from] || removed[to] || groups[from] == groups[to])
+            return;
+        heap.push({ ComputeError(from, to), from, to, versions[groups[from]], versions[groups[to]] });
+    };
+    for (uint32_t t = 0; t < triangleCount; ++t)
+    {
+        for (int e = 0; e < 3; ++e)
+        {
+            uint32_t a = triangles[t * 3 + e];
+            uint32_t b = triangles[t * 3 + (e + 1) % 3];
+            PushCollapse(a, b);
+            PushCollapse(b, a);
+        }
+    }
+
+    // 접으면 남는 triangle 중 뒤집히는 것이 있는지
+    auto FlipsTriangle = [&](uint32_t from, uint32_t to) {
+        const auto& target = vertices[to].position;
+        for (auto t : vertexTriangles[from])
+        {
+            if (deleted[t])
+                continue;
+            const uint32_t* triangle = &triangles[t * 3];
+            if (HasGroup(triangle, groups[to]))
+                continue;
+
+            glm::vec3 before[3], after[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                before[k] = vertices[triangle[k]].position;
+                after[k] = triangle[k] == from ? target : before[k];
+            }
+            auto oldNormal = GetTriangleNormal(before[0], before[1], before[2]);
+            auto newNormal = GetTriangleNormal(after[0], after[1], after[2]);
+            if (glm::dot(oldNormal, newNormal) <= 0.0f)
+                return true;
+        }
+        return false;
+    };
+
+    std::vector<uint32_t> neighbors;
+    while (liveTriangles * 3 > targetIndexCount && !heap.empty())
+    {
+        auto collapse = heap.top();
+        heap.pop();
+        uint32_t from = collapse.from;
+        uint32_t to = collapse.to;
+        if (removed[from] || removed[to] ||
+            versions[groups[from]] != collapse.fromVersion || versions[groups[to]] != collapse.toVersion)
+            continue;
+        if (FlipsTriangle(from, to))
+            continue;
+
+        // from 을 쓰던 triangle 을 to 로 옮기고 퇴화한 것은 지운다
+        for (auto t : vertexTriangles[from])
+        {
+            if (deleted[t])
+                continue;
+            uint32_t* triangle = &triangles[t * 3];
+            // to 와 위치가 같은 다른 vertex (seam) 를 쓰는 triangle 도 퇴화한다
+            if (HasGroup(triangle, groups[to]))
+            {
+                deleted[t] = 1;
+                --liveTriangles;
+                continue;
+            }
+            for (int k = 0; k < 3; ++k)
+            {
+                if (triangle[k] == from)
+                    triangle[k] = to;
+            }
+            vertexTriangles[to].push_back(t);
+        }
+        vertexTriangles[from].clear();
+        removed[from] = 1;
+        quadrics[groups[to]].Add(quadrics[groups[from]]);
+        ++versions[groups[to]];
+        resultError = std::max(resultError, collapse.error);
+
+        // to 주변 edge 의 비용이 바뀌었다
+        neighbors.clear();
+        for (auto t : vertexTriangles[to])
+        {
+            if (deleted[t])
+                continue;
+            for (int k = 0; k < 3; ++k)
+            {
+                if (triangles[t * 3 + k] != to)
+                    neighbors.push_back(triangles[t * 3 + k]);
+            }
+        }
+        std::sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+        for (auto neighbor : neighbors)
+        {
+            PushCollapse(neighbor, to);
+            PushCollapse(to, neighbor);
+        }
+    }
+
+    std::vector<uint32_t> result;
+    result.reserve(liveTriangles * 3);
+    for (uint32_t t = 0; t < triangleCount; ++t)
+    {
+        if (!deleted[t])
+            result.insert(result.end(), &triangles[t * 3], &triangles[t * 3] + 3);
+    }
+    return result;
+}
+
+std::vector<MeshLodData> BuildLodChain(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+    uint32_t maxLodCount, float reduction)
+{
+    std::vector<MeshLodData> lods;
+    lods.push_back({ indices, 0.0f });
+
+    // 매번 원본에서 줄여야 각 LOD 의 오차가 원본 기준이 된다
+    size_t targetIndexCount = indices.size();
+    while (lods.size() < maxLodCount)
+    {
+        const auto& previous = lods.back().indices;
+        targetIndexCount = (size_t)(targetIndexCount / 3 * reduction) * 3;
+        if (targetIndexCount < MIN_LOD_TRIANGLES * 3)
+            break;
+
+        MeshLodData lod;
+        lod.indices = SimplifyMesh(vertices, indices, targetIndexCount, lod.error);
+        if (lod.indices.empty() || lod.indices.size() > previous.size() * MIN_LOD_REDUCTION)
+            break;
+        // LOD 가 올라갈수록 오차가 줄지 않게 한다 (선택할 때 순서대로 비교)
+        lod.error = std::max(lod.error, lods.back().error);
+        lods.push_back(std::move(lod));
+    }
+    return lods;
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#ifndef __MESH_SIMPLIFIER_H__
+#define __MESH_SIMPLIFIER_H__
+
+#include "common.h"
+#include "mesh.h"
+#include <vector>
+
+// quadric error metric (Garland-Heckbert) 으로 edge 를 접어 triangle 수를 줄인다
+// vertex 는 새로 만들지 않고 edge 의 한쪽 끝으로 접으므로 결과 index 는 원본 vertex buffer 를 그대로 쓴다
+// 열린 경계와 texture / normal seam (위치는 같고 attribute 가 다른 vertex) 은 움직이지 않는다
+//
+// targetIndexCount 까지 줄이거나 더 접을 수 있는 edge 가 없으면 멈춘다
+// resultError 에는 접은 edge 중 가장 큰 오차 (local space 거리) 를 돌려준다
+std::vector<uint32_t> SimplifyMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+    size_t targetIndexCount, float& resultError);
+
+// 원본을 LOD 0 으로 두고 triangle 수를 reduction 배씩 줄인 LOD 를 maxLodCount 개까지 만든다
+// 더 줄어들지 않으면 (seam 이 많은 mesh 등) 거기서 멈춘다
+std::vector<MeshLodData> BuildLodChain(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+    uint32_t maxLodCount = 5, float reduction = 0.5f);
+
+#endif // __MESH_SIMPLIFIER_H__
\ No newline at end of file
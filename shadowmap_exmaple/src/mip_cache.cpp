@@ -0,0 +1,149 @@
+#include "mip_cache.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace
+{
+    const uint32_t CACHE_MAGIC = 0x5350494d; // "MIPS"
+
+    struct CacheHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        int32_t width;
+        int32_t height;
+        int32_t channelCount;
+        int32_t levelCount;
+    };
+}
+
+ImageUPtr MipCache::Load(const std::string& filepath, bool flipVertical, bool defaultPath,
+    MipFilter filter, bool srgb)
+{
+    std::string fullPath = defaultPath ? std::string(IMAGE_PATH) : "";
+    fullPath += filepath;
+
+    auto source = MappedFile::Open(fullPath);
+    if (!source)
+    {
+        SPDLOG_ERROR("failed to load image: {}", fullPath);
+        return nullptr;
+    }
+    uint32_t options[] = { GENERATOR_VERSION, (uint32_t)flipVertical, (uint32_t)filter, (uint32_t)srgb };
+    uint64_t key = HashBytes(source->GetData(), source->GetSize(), HashBytes(options, sizeof(options)));
+    source.reset();
+
+    auto cachePath = GetFilePath(fullPath);
+    if (auto image = Read(cachePath, key))
+        return image;
+
+    auto image = Image::Load(fullPath, flipVertical, false);
+    if (!image)
+        return nullptr;
+    image->GenerateMips(filter, srgb);
+    if (Write(cachePath, key, image.get()))
+        SPDLOG_INFO("mip cache written: {}", cachePath);
+    return image;
+}
+
+ImageUPtr MipCache::Read(const std::string& cachePath, uint64_t key)
+{
+    auto file = MappedFile::Open(cachePath);
+    if (!file)
+        return nullptr;
+
+    CacheHeader header = {};
+    if (file->GetSize() < sizeof(header))
+        return nullptr;
+    memcpy(&header, file->GetData(), sizeof(header));
+    if (header.magic != CACHE_MAGIC || header.version != GENERATOR_VERSION || header.key != key)
+        return nullptr;
+    if (header.width <= 0 || header.height <= 0 || header.width > 16384 || header.height > 16384 ||
+        header.channelCount < 1 || header.channelCount > 4)
+    {
+        SPDLOG_WARN("broken mip cache: {}", cachePath);
+        return nullptr;
+    }
+
+    // level 크기는 GenerateMips 와 같은 규칙으로 다시 계산해서 file 크기와 맞춰 본다
+    std::vector<Image::MipLevel> mipLevels;
+    size_t mipDataSize = 0;
+    int width = header.width;
+    int height = header.height;
+    while (width > 1 || height > 1)
+    {
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+        Image::MipLevel mipLevel;
+        mipLevel.width = width;
+        mipLevel.height = height;
+        mipLevel.offset = mipDataSize;
+        mipDataSize += (size_t)width * height * header.channelCount;
+        mipLevels.push_back(mipLevel);
+    }
+    size_t baseSize = (size_t)header.width * header.height * header.channelCount;
+    if (header.levelCount != (int32_t)mipLevels.size() + 1 ||
+        file->GetSize() != sizeof(header) + baseSize + mipDataSize)
+    {
+        SPDLOG_WARN("broken mip cache: {}", cachePath);
+        return nullptr;
+    }
+
+    auto image = Image::Create(header.width, header.height, header.channelCount);
+    if (!image)
+        return nullptr;
+    const uint8_t* data = file->GetData() + sizeof(header);
+    memcpy(image->m_data, data, baseSize);
+    image->m_mipLevels = std::move(mipLevels);
+    image->m_mipData.assign(data + baseSize, data + baseSize + mipDataSize);
+    return image;
+}
+
+bool MipCache::Write(const std::string& cachePath, uint64_t key, const Image* image)
+{
+    CacheHeader header = {};
+    header.magic = CACHE_MAGIC;
+    header.version = GENERATOR_VERSION;
+    header.key = key;
+    header.width = image->GetWidth();
+    header.height = image->GetHeight();
+    header.channelCount = image->GetChannelCount();
+    header.levelCount = image->GetLevelCount();
+
+    // 같은 file 을 두 worker 가 동시에 만들어도 섞이지 않게 temp 이름을 thread 마다 다르게 한다
+    auto tempPath = fmt::format("{}.{:x}.tmp", cachePath, std::hash<std::thread::id>()(std::this_thread::get_id()));
+    {
+        std::ofstream fout(tempPath, std::ios::binary | std::ios::trunc);
+        if (!fout.is_open())
+        {
+            SPDLOG_WARN("failed to write mip cache: {}", tempPath);
+            return false;
+        }
+        fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        fout.write(reinterpret_cast<const char*>(image->m_data),
+            (size_t)header.width * header.height * header.channelCount);
+        fout.write(reinterpret_cast<const char*>(image->m_mipData.data()), image->m_mipData.size());
+        if (fout.fail())
+        {
+            fout.close();
+            std::error_code error;
+            std::filesystem::remove(tempPath, error);
+            SPDLOG_WARN("failed to write mip cache: {}", tempPath);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, cachePath, error);
+    if (error)
+    {
+        std::filesystem::remove(tempPath, error);
+        SPDLOG_WARN("failed to write mip cache: {}", cachePath);
+        return false;
+    }
+    return true;
+}
\ No newline at end of file
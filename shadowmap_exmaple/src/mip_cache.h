@@ -0,0 +1,28 @@
+#ifndef __MIP_CACHE_H__
+#define __MIP_CACHE_H__
+
+#include "image.h"
+
+// image file 옆의 "<file>.mips" 에 decode 한 pixel 과 CPU 에서 만든 mip level 을 모두 저장한다
+// 다음 load 부터는 PNG / JPG decode 와 mip 생성을 건너뛰고 file 을 그대로 읽는다
+// key 는 원본 file 내용과 flip / filter / sRGB 옵션으로 만들어서 하나라도 바뀌면 다시 만든다
+// 상태가 없어서 여러 worker thread 에서 동시에 불러도 된다
+class MipCache
+{
+public:
+    // MipGenerator 의 결과가 바뀌면 올려서 이전 cache 를 버린다
+    static const uint32_t GENERATOR_VERSION = 1;
+
+    // Image::Load 와 같은 인자. cache 가 없으면 decode 하고 mip 을 만들어 저장한다
+    // 저장에 실패해도 (읽기 전용 directory 등) image 는 돌려준다
+    static ImageUPtr Load(const std::string& filepath, bool flipVertical = true, bool defaultPath = true,
+        MipFilter filter = MipFilter::Kaiser, bool srgb = true);
+    static std::string GetFilePath(const std::string& imagePath) { return imagePath + ".mips"; }
+
+private:
+    // 없거나, 깨졌거나, key 가 다르면 nullptr
+    static ImageUPtr Read(const std::string& cachePath, uint64_t key);
+    static bool Write(const std::string& cachePath, uint64_t key, const Image* image);
+};
+
+#endif // __MIP_CACHE_H__
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include "mip_generator.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+
+namespace
+{
+    struct Kernel
+    {
+        // 2x + first 부터 weights.size() 개의 source pixel 을 읽는다
+        int first;
+        std::vector<float> weights;
+    };
+
+    float BesselI0(float x)
+    {
+        float sum = 1.0f;
+        float term = 1.0f;
+        for (int k = 1; k < 16; ++k)
+        {
+            term *= (x * 0.5f / k) * (x * 0.5f / k);
+            sum += term;
+        }
+        return sum;
+    }
+
+    Kernel MakeKaiserKernel()
+    {
+        const float radius = 1.5f;
+        const float beta = 4.0f;
+        Kernel kernel { -2, {} };
+        float sum = 0.0f;
+        for (int i = 0; i < 6; ++i)
+        {
+            // destination pixel 단위의 거리: -1.25, -0.75, ... 1.25
+            float t = (i + kernel.first + 0.5f - 1.0f) * 0.5f;
+            float x = glm::pi<float>() * t;
+            float sinc = std::abs(t) < 1e-6f ? 1.0f : std::sin(x) / x;
+            float ratio = t / radius;
+            float window = BesselI0(beta * std::sqrt(std::max(1.0f - ratio * ratio, 0.0f))) / BesselI0(beta);
+            kernel.weights.push_back(sinc * window);
+            sum += sinc * window;
+        }
+        for (auto& weight : kernel.weights)
+            weight /= sum;
+        return kernel;
+    }
+
+    const Kernel& GetKernel(MipFilter filter)
+    {
+        static const Kernel boxKernel { 0, { 0.5f, 0.5f } };
+        static const Kernel kaiserKernel = MakeKaiserKernel();
+        return filter == MipFilter::Kaiser ? kaiserKernel : boxKernel;
+    }
+
+    float SrgbToLinear(float value)
+    {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    const std::array<float, 256>& GetSrgbTable()
+    {
+        static const std::array<float, 256> table = []() {
+            std::array<float, 256> table;
+            for (int i = 0; i < 256; ++i)
+                table[i] = SrgbToLinear(i / 255.0f);
+            return table;
+        }();
+        return table;
+    }
+
+    // linear 값이 thresholds[i] 보다 크면 i + 1 로 반올림된다
+    struct SrgbEncoder
+    {
+        std::array<float, 255> thresholds;
+        // linear 값을 4096 칸으로 나눈 칸마다 그 칸 시작의 byte. 여기서부터 몇 번만 올려 보면 된다
+        std::array<uint8_t, 4097> start;
+    };
+
+    const SrgbEncoder& GetSrgbEncoder()
+    {
+        static const SrgbEncoder encoder = []() {
+            SrgbEncoder encoder;
+            for (int i = 0; i < 255; ++i)
+                encoder.thresholds[i] = SrgbToLinear((i + 0.5f) / 255.0f);
+            for (int i = 0; i <= 4096; ++i)
+            {
+                auto iter = std::upper_bound(encoder.thresholds.begin(), encoder.thresholds.end(), i / 4096.0f);
+                encoder.start[i] = (uint8_t)(iter - encoder.thresholds.begin());
+            }
+            return encoder;
+        }();
+        return encoder;
+    }
+
+    uint8_t LinearToSrgb(const SrgbEncoder& encoder, float value)
+    {
+        int byte = encoder.start[(int)(value * 4096.0f)];
+        while (byte < 255 && value > encoder.thresholds[byte])
+            ++byte;
+        return (uint8_t)byte;
+    }
+
+    // channel 수를 compile time 에 알면 안쪽 loop 가 풀려서 pixel 단위로 vector 화된다
+    template <int CHANNEL_COUNT>
+    void FilterRows(const float* src, int width, int height, const Kernel& kernel, float* dest)
+    {
+        int halfWidth = std::max(width / 2, 1);
+        int tapCount = (int)kernel.weights.size();
+        const float* weights = kernel.weights.data();
+        for (int y = 0; y < height; ++y)
+        {
+            const float* in = src + (size_t)y * width * CHANNEL_COUNT;
+            float* out = dest + (size_t)y * halfWidth * CHANNEL_COUNT;
+            for (int x = 0; x < halfWidth; ++x)
+            {
+                int first = x * 2 + kernel.first;
+                float sum[CHANNEL_COUNT] = {};
+                // 가장자리가 아니면 clamp 없이 읽는다
+                if (first >= 0 && first + tapCount <= width)
+                {
+                    const float* tap = in + first * CHANNEL_COUNT;
+                    for (int k = 0; k < tapCount; ++k, tap += CHANNEL_COUNT)
+                    {
+                        for (int c = 0; c < CHANNEL_COUNT; ++c)
+                            sum[c] += weights[k] * tap[c];
+                    }
+                }
+                else
+                {
+                    for (int k = 0; k < tapCount; ++k)
+                    {
+                        const float* tap = in + std::clamp(first + k, 0, width - 1) * CHANNEL_COUNT;
+                        for (int c = 0; c < CHANNEL_COUNT; ++c)
+                            sum[c] += weights[k] * tap[c];
+                    }
+                }
+                for (int c = 0; c < CHANNEL_COUNT; ++c)
+                    out[x * CHANNEL_COUNT + c] = sum[c];
+            }
+        }
+    }
+}
+
+std::vector<float> MipGenerator::ToFloat(const uint8_t* data, size_t pixelCount, int channelCount, bool srgb)
+{
+    const auto& srgbTable = GetSrgbTable();
+    std::vector<float> result(pixelCount * channelCount);
+    size_t count = result.size();
+    for (size_t i = 0; i < count; ++i)
+        result[i] = data[i] / 255.0f;
+    // RGB 만 다시 덮어쓴다
+    if (srgb && channelCount >= 3)
+    {
+        for (size_t i = 0; i < count; i += channelCount)
+        {
+            result[i + 0] = srgbTable[data[i + 0]];
+            result[i + 1] = srgbTable[data[i + 1]];
+            result[i + 2] = srgbTable[data[i + 2]];
+        }
+    }
+    return result;
+}
+
+void MipGenerator::ToBytes(const float* data, size_t pixelCount, int channelCount, bool srgb, uint8_t* dest)
+{
+    size_t count = pixelCount * channelCount;
+    // kaiser 의 음수 weight 때문에 0 ~ 1 을 벗어날 수 있다
+    for (size_t i = 0; i < count; ++i)
+        dest[i] = (uint8_t)(std::clamp(data[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+    if (srgb && channelCount >= 3)
+    {
+        const auto& encoder = GetSrgbEncoder();
+        for (size_t i = 0; i < count; i += channelCount)
+        {
+            for (int c = 0; c < 3; ++c)
+                dest[i + c] = LinearToSrgb(encoder, std::clamp(data[i + c], 0.0f, 1.0f));
+        }
+    }
+}
+
+std::vector<float> MipGenerator::Downsample(const std::vector<float>& src, int width, int height,
+    int channelCount, MipFilter filter)
+{
+    const auto& kernel = GetKernel(filter);
+    int halfWidth = std::max(width / 2, 1);
+    int halfHeight = std::max(height / 2, 1);
+    size_t tapCount = kernel.weights.size();
+
+    // 가로: 가장자리 밖은 마지막 pixel 을 반복한다
+    std::vector<float> rows((size_t)halfWidth * height * channelCount);
+    switch (channelCount)
+    {
+        case 1: FilterRows<1>(src.data(), width, height, kernel, rows.data()); break;
+        case 2: FilterRows<2>(src.data(), width, height, kernel, rows.data()); break;
+        case 3: FilterRows<3>(src.data(), width, height, kernel, rows.data()); break;
+        default: FilterRows<4>(src.data(), width, height, kernel, rows.data()); break;
+    }
+
+    // 세로: row 단위로 더한다
+    size_t rowLength = (size_t)halfWidth * channelCount;
+    std::vector<float> result(rowLength * halfHeight, 0.0f);
+    for (int y = 0; y < halfHeight; ++y)
+    {
+        float* out = result.data() + y * rowLength;
+        for (size_t k = 0; k < tapCount; ++k)
+        {
+            int sy = std::clamp(y * 2 + kernel.first + (int)k, 0, height - 1);
+            const float* in = rows.data() + sy * rowLength;
+            float weight = kernel.weights[k];
+            for (size_t i = 0; i < rowLength; ++i)
+                out[i] += weight * in[i];
+        }
+    }
+    return result;
+}
\ No newline at end of file
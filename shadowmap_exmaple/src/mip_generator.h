@@ -0,0 +1,28 @@
+#ifndef __MIP_GENERATOR_H__
+#define __MIP_GENERATOR_H__
+
+#include "common.h"
+#include <vector>
+
+enum class MipFilter
+{
+    Box,    // 2x2 평균
+    Kaiser, // Kaiser window 를 씌운 sinc, 6 tap. box 보다 덜 흐려진다
+};
+
+// CPU 에서 mip level 을 만드는 filter
+// channel 이 이어진 float 배열에서 가로, 세로를 따로 filter 한다
+// 세로 pass 는 row 전체에 weight 를 곱해 더하는 loop 라 compiler 가 SIMD 로 바꾼다
+// thread 상태가 없어서 worker thread 에서 불러도 된다
+class MipGenerator
+{
+public:
+    // srgb 면 RGB 를 linear 로 바꾼다. alpha 와 1, 2 channel 은 그대로
+    static std::vector<float> ToFloat(const uint8_t* data, size_t pixelCount, int channelCount, bool srgb);
+    static void ToBytes(const float* data, size_t pixelCount, int channelCount, bool srgb, uint8_t* dest);
+    // 가로 세로를 반으로 줄인다 (홀수면 내림, 최소 1)
+    static std::vector<float> Downsample(const std::vector<float>& src, int width, int height,
+        int channelCount, MipFilter filter);
+};
+
+#endif // __MIP_GENERATOR_H__
\ No newline at end of file
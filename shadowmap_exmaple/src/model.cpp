@@ -1,76 +1,323 @@
 #include "model.h"
+#include "mesh_simplifier.h"
+#include "mesh_optimizer.h"
+#include "mip_cache.h"
+#include <assimp/DefaultIOSystem.h>
+#include <chrono>
+#include <future>
 
-ModelUPtr Model::Load(const std::string& filename)
+// assimp 가 model file 과 같이 연 file (.obj 의 mtllib 등) 을 모아서 mesh cache 가 바뀐 것을 알게 한다
+class DependencyRecorder : public Assimp::DefaultIOSystem
+{
+public:
+    Assimp::IOStream* Open(const char* file, const char* mode) override
+    {
+        auto stream = DefaultIOSystem::Open(file, mode);
+        if (stream)
+            openedFiles.push_back(file);
+        return stream;
+    }
+
+    std::vector<std::string> openedFiles;
+};
+
+// 같은 file 이라도 sRGB / linear 로 만든 mip 은 다른 image 다
+static std::string GetImageKey(const std::string& filename, bool srgb)
+{
+    return srgb ? filename : filename + "|linear";
+}
+
+// thread pool 이 없으면 get() 할 때 이 thread 에서 실행한다
+template <typename F>
+static auto RunTask(ThreadPool* threadPool, F&& task)
+{
+    if (threadPool)
+        return threadPool->Submit(std::forward<F>(task));
+    return std::async(std::launch::deferred, std::forward<F>(task));
+}
+
+ModelUPtr Model::Load(const std::string& filename, VertexFormat vertexFormat,
+    ThreadPool* threadPool, TextureCache* textureCache)
+{
+    auto model = ModelUPtr(new Model());
+    model->m_vertexFormat = vertexFormat;
+    model->m_threadPool = threadPool;
+    model->m_textureCache = textureCache;
+    bool loaded = model->LoadFile(filename);
+    model->m_threadPool = nullptr;
+    model->m_textureCache = nullptr;
+    if (!loaded)
+        return nullptr;
+    return std::move(model);
+}
+
+ModelUPtr Model::Load(const std::string& filename, GeometryPoolPtr geometryPool,
+    ThreadPool* threadPool, TextureCache* textureCache)
 {
     auto model = ModelUPtr(new Model());
-    if (!model->LoadByAssimp(filename))
+    model->m_vertexFormat = geometryPool->GetVertexFormat();
+    model->m_geometryPool = geometryPool;
+    model->m_threadPool = threadPool;
+    model->m_textureCache = textureCache;
+    bool loaded = model->LoadFile(filename);
+    model->m_threadPool = nullptr;
+    model->m_textureCache = nullptr;
+    if (!loaded)
         return nullptr;
     return std::move(model);
 }
 
-bool Model::LoadByAssimp(const std::string& filename)
+bool Model::LoadFile(const std::string& filename)
 {
+    auto startTime = std::chrono::steady_clock::now();
     std::string filepath = std::string(MODEL_PATH) + filename;
 
+    // cache key 는 원본 내용으로 만든다
+    auto source = MappedFile::Open(filepath);
+    if (!source)
+    {
+        SPDLOG_ERROR("failed to load model: {}", filename);
+        return false;
+    }
+    uint64_t key = MeshCache::MakeKey(*source, m_vertexFormat);
+    source.reset();
+
+    bool fromCache = LoadFromCache(filepath, key);
+    if (!fromCache)
+    {
+        // Finish 가 끝나야 cache 로 보이므로 import 가 실패하면 아무것도 남지 않는다
+        auto cacheWriter = MeshCacheWriter::Create(key);
+        if (!LoadByAssimp(filepath, cacheWriter.get()))
+        {
+            SPDLOG_ERROR("failed to load model: {}", filename);
+            return false;
+        }
+        if (cacheWriter && cacheWriter->Finish())
+            SPDLOG_INFO("mesh cache written: {}", MeshCache::GetFilePath(key));
+    }
+
+    size_t vertexBytes = 0;
+    size_t indexBytes = 0;
+    for (const auto& mesh : m_meshes)
+    {
+        vertexBytes += mesh->GetVertexDataSize();
+        indexBytes += mesh->GetIndexDataSize();
+    }
+    auto elapsed = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime);
+    SPDLOG_INFO("model {}: {} meshes, vertex {} KB, index {} KB, {:.1f} ms ({}, {} workers)", filename,
+        m_meshes.size(), vertexBytes / 1024, indexBytes / 1024, elapsed.count(),
+        fromCache ? "mesh cache" : "assimp", m_threadPool ? m_threadPool->GetThreadCount() : 0);
+    return true;
+}
+
+Model::ImageFutureMap Model::DecodeTextures(const std::string& dirname,
+    const std::vector<MeshCache::Material>& materials) const
+{
+    // 여러 material 이 같은 texture 를 쓰면 한 번만 decode 한다
+    ImageFutureMap images;
+    auto Decode = [&](const std::string& filename, bool srgb) {
+        // 압축 file 은 decode 할 것이 없다
+        auto imageKey = GetImageKey(filename, srgb);
+        if (filename.empty() || images.count(imageKey) || CompressedImage::IsCompressedFile(filename))
+            return;
+        auto filepath = fmt::format("{}/{}", dirname, filename);
+        if (m_textureCache && m_textureCache->Contains(filepath, true, false, srgb))
+            return;
+        images[imageKey] = RunTask(m_threadPool, [filepath, srgb]() -> ImagePtr {
+            return MipCache::Load(filepath, true, false, MipFilter::Kaiser, srgb);
+        }).share();
+    };
+    // specular 는 색이 아니라 세기라서 mip 을 linear 로 섞는다
+    for (const auto& material : materials)
+    {
+        Decode(material.diffuse, true);
+        Decode(material.specular, false);
+    }
+    return images;
+}
+
+void Model::CreateMaterials(const std::string& dirname, const std::vector<MeshCache::Material>& materials,
+    ImageFutureMap& images)
+{
+    // decode 를 걸지 않은 texture (cache 에 있던 것) 는 여기서 읽는다
+    auto GetImage = [&](const std::string& filename, const std::string& filepath, bool srgb) -> ImagePtr {
+        auto iter = images.find(GetImageKey(filename, srgb));
+        if (iter != images.end())
+            return iter->second.get();
+        return MipCache::Load(filepath, true, false, MipFilter::Kaiser, srgb);
+    };
+
+    std::unordered_map<std::string, TexturePtr> textures;
+    auto GetTexture = [&](const std::string& filename, bool srgb) -> TexturePtr {
+        if (filename.empty())
+            return nullptr;
+        auto filepath = fmt::format("{}/{}", dirname, filename);
+        bool compressed = CompressedImage::IsCompressedFile(filename);
+        if (m_textureCache)
+        {
+            return compressed ? m_textureCache->Load(filepath, true, false) :
+                m_textureCache->Load(filepath, true, false, srgb, [&]() { return GetImage(filename, filepath, srgb); });
+        }
+
+        // 압축 file 은 mip 이 file 에 있으므로 옵션과 상관없이 하나다
+        auto textureKey = compressed ? filename : GetImageKey(filename, srgb);
+        auto iter = textures.find(textureKey);
+        if (iter != textures.end())
+            return iter->second;
+        TexturePtr texture;
+        if (compressed)
+        {
+            auto image = CompressedImage::Load(filepath, false);
+            texture = image ? Texture::CreateFromCompressedImage(image.get()) : nullptr;
+        }
+        else
+        {
+            auto image = GetImage(filename, filepath, srgb);
+            texture = image ? Texture::CreateFromImage(image.get()) : nullptr;
+        }
+        textures[textureKey] = texture;
+        return texture;
+    };
+
+    for (const auto& material : materials)
+    {
+        auto glMaterial = Material::Create();
+        glMaterial->diffuse = GetTexture(material.diffuse, true);
+        glMaterial->specular = GetTexture(material.specular, false);
+        m_materials.push_back(std::move(glMaterial));
+    }
+}
+
+void Model::AddMesh(MeshPtr mesh, int32_t materialIndex)
+{
+    if (materialIndex >= 0 && materialIndex < (int32_t)m_materials.size())
+    {
+        mesh->SetMaterial(m_materials[materialIndex]);
+    }
+
+    m_boundingBox.Expand(mesh->GetBoundingBox());
+    m_meshes.push_back(std::move(mesh));
+}
+
+bool Model::LoadFromCache(const std::string& filepath, uint64_t key)
+{
+    auto cache = MeshCache::Open(key);
+    if (!cache)
+        return false;
+
+    auto dirname = filepath.substr(0, filepath.find_last_of("/"));
+    auto images = DecodeTextures(dirname, cache->GetMaterials());
+    CreateMaterials(dirname, cache->GetMaterials(), images);
+
+    // vertex / index 는 mapping 에서 바로 GPU 로 올라간다
+    for (size_t i = 0; i < cache->GetMeshCount(); ++i)
+    {
+        auto mesh = Mesh::CreateFromData(cache->GetMeshData(i), m_geometryPool);
+        if (!mesh)
+        {
+            // 중간까지 만든 것은 버리고 assimp 로 다시 읽는다
+            m_materials.clear();
+            m_meshes.clear();
+            m_boundingBox = BoundingBox();
+            return false;
+        }
+        AddMesh(std::move(mesh), cache->GetMaterialIndex(i));
+    }
+    return true;
+}
+
+bool Model::LoadByAssimp(const std::string& filepath, MeshCacheWriter* cacheWriter)
+{
     Assimp::Importer importer;
+    // importer 가 지운다
+    auto dependencyRecorder = new DependencyRecorder();
+    importer.SetIOHandler(dependencyRecorder);
     auto scene = importer.ReadFile(filepath,
         aiProcess_Triangulate |
         aiProcess_FlipUVs);
 
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
-    {
-        SPDLOG_ERROR("failed to load model: {}", filename);
         return false;
+
+    if (cacheWriter)
+    {
+        for (const auto& openedFile : dependencyRecorder->openedFiles)
+        {
+            if (openedFile != filepath)
+                cacheWriter->AddDependency(openedFile);
+        }
     }
 
-    auto dirname = filepath.substr(0, filepath.find_last_of("/"));
-    auto LoadTexture = [&](aiMaterial* material, aiTextureType type) -> TexturePtr{
+    auto GetTexturePath = [&](aiMaterial* material, aiTextureType type) -> std::string {
         if (material->GetTextureCount(type) <= 0)
-            return nullptr;
-        
+            return "";
+
         aiString filepath;
         material->GetTexture(type, 0, &filepath);
-        auto image = Image::Load(fmt::format("{}/{}", dirname, filepath.C_Str()), true, false);
-        if (!image)
-            return nullptr;
-        return Texture::CreateFromImage(image.get());
+        return filepath.C_Str();
     };
 
+    std::vector<MeshCache::Material> materials(scene->mNumMaterials);
     for (uint32_t i = 0; i < scene->mNumMaterials; ++i)
     {
         auto material = scene->mMaterials[i];
-        
-        auto glMaterial = Material::Create();
-        glMaterial->diffuse = LoadTexture(material, aiTextureType_DIFFUSE);
-        glMaterial->specular = LoadTexture(material, aiTextureType_SPECULAR);
+        materials[i].diffuse = GetTexturePath(material, aiTextureType_DIFFUSE);
+        materials[i].specular = GetTexturePath(material, aiTextureType_SPECULAR);
+        if (cacheWriter)
+            cacheWriter->AddMaterial(materials[i]);
+    }
 
-        m_materials.push_back(std::move(glMaterial));
+    // GL thread 가 먼저 기다리는 texture decode 를 queue 앞에 넣고 mesh 변환을 뒤에 건다
+    // 작업들이 scene 과 this 를 참조하므로 아래에서 모든 future 를 받기 전에 return 하면 안 된다
+    auto dirname = filepath.substr(0, filepath.find_last_of("/"));
+    auto images = DecodeTextures(dirname, materials);
+
+    std::vector<uint32_t> meshIndices;
+    CollectMeshes(scene->mRootNode, meshIndices);
+    std::vector<std::future<ImportedMeshUPtr>> importedMeshes;
+    importedMeshes.reserve(meshIndices.size());
+    for (auto meshIndex : meshIndices)
+    {
+        const aiMesh* mesh = scene->mMeshes[meshIndex];
+        uint32_t materialCount = scene->mNumMaterials;
+        importedMeshes.push_back(RunTask(m_threadPool, [this, mesh, materialCount]() {
+            return ImportMesh(mesh, materialCount);
+        }));
+    }
+
+    CreateMaterials(dirname, materials, images);
+    // node 순서대로 받아서 올리는 동안 뒤의 mesh 는 worker 에서 계속 변환된다
+    for (auto& importedMesh : importedMeshes)
+    {
+        auto imported = importedMesh.get();
+        auto glMesh = Mesh::CreateFromData(imported->data, m_geometryPool);
+        if (!glMesh)
+            continue;
+        if (cacheWriter)
+            cacheWriter->AddMesh(imported->data, imported->materialIndex);
+        AddMesh(std::move(glMesh), imported->materialIndex);
     }
-    
-    ProcessNode(scene->mRootNode, scene);
     return true;
 }
 
-void Model::ProcessNode(aiNode* node, const aiScene* scene)
+void Model::CollectMeshes(const aiNode* node, std::vector<uint32_t>& meshIndices)
 {
     for (unsigned int i = 0; i < node->mNumMeshes; ++i)
     {
-        auto meshIndex = node->mMeshes[i];
-        auto mesh = scene->mMeshes[meshIndex];
-        ProcessMesh(mesh, scene);
+        meshIndices.push_back(node->mMeshes[i]);
     }
 
     for (unsigned int i = 0; i < node->mNumChildren; ++i)
     {
-        ProcessNode(node->mChildren[i], scene);
+        CollectMeshes(node->mChildren[i], meshIndices);
     }
 }
 
-void Model::ProcessMesh(aiMesh* mesh, const aiScene* scene)
+Model::ImportedMeshUPtr Model::ImportMesh(const aiMesh* mesh, uint32_t materialCount) const
 {
-    std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
-
+    auto imported = std::make_unique<ImportedMesh>();
+    auto& vertices = imported->vertices;
+    std::vector<uint32_t> indices;
 
     vertices.resize(mesh->mNumVertices);
     for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
@@ -96,13 +343,20 @@ void Model::ProcessMesh(aiMesh* mesh, const aiScene* scene)
         indices[3*i + 2] = mesh->mFaces[i].mIndices[2];
     }
     
-    auto glMesh = Mesh::Create(vertices, indices, GL_TRIANGLES);
-    if (mesh->mMaterialIndex >= 0 && mesh->mMaterialIndex < m_materials.size())
-    {
-        glMesh->SetMaterial(m_materials[mesh->mMaterialIndex]);
-    }
+    // assimp 가 준 순서 그대로면 vertex cache / fetch 효율이 나쁘다
+    OptimizeMesh(mesh->mName.C_Str(), vertices, indices);
+
+    // 멀리서 작게 보일 때 쓸 단순화된 index 를 load 할 때 같이 만든다
+    auto lods = BuildLodChain(vertices, indices);
+    for (size_t i = 1; i < lods.size(); ++i)
+        OptimizeVertexCache(lods[i].indices, vertices.size());
+    SPDLOG_INFO("mesh {}: {} triangles, {} lods (coarsest {} triangles, error {:.4f})",
+        mesh->mName.C_Str(), indices.size() / 3, lods.size(),
+        lods.back().indices.size() / 3, lods.back().error);
 
-    m_meshes.push_back(std::move(glMesh));
+    imported->data = Mesh::BuildData(vertices, lods, GL_TRIANGLES, m_vertexFormat, imported->storage);
+    imported->materialIndex = mesh->mMaterialIndex < materialCount ? (int32_t)mesh->mMaterialIndex : -1;
+    return imported;
 }
 
 void Model::Draw(const Program* program) const
@@ -3,28 +3,71 @@
 
 #include "common.h"
 #include "mesh.h"
+#include "mesh_cache.h"
+#include "thread_pool.h"
+#include "texture_cache.h"
+#include <future>
+#include <unordered_map>
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+// 처음 읽을 때 assimp 로 import 한 결과를 mesh cache 에 저장하고
+// 다음부터는 원본이 그대로이면 cache 를 mmap 해서 바로 올린다
+// threadPool 을 주면 texture decode 와 mesh 변환은 worker 에서 나눠 하고 buffer / texture 생성만 이 thread 에서 한다
+// textureCache 를 주면 다른 model, material 과 같은 texture file 을 다시 읽지 않는다
 CLASS_PTR(Model);
 class Model {
 public:
-    static ModelUPtr Load(const std::string& filename);
+    // VERTEX_FORMAT_COMPACT 이면 vertex 를 양자화해서 올린다
+    static ModelUPtr Load(const std::string& filename, VertexFormat vertexFormat = VERTEX_FORMAT_FULL,
+        ThreadPool* threadPool = nullptr, TextureCache* textureCache = nullptr);
+    // 모든 mesh 를 geometryPool 에 (pool 의 vertex format 으로) 올린다
+    static ModelUPtr Load(const std::string& filename, GeometryPoolPtr geometryPool,
+        ThreadPool* threadPool = nullptr, TextureCache* textureCache = nullptr);
 
     int GetMeshCount() const { return (int)m_meshes.size(); }
     MeshPtr GetMesh(int index) const { return m_meshes[index]; }
     void Draw(const Program* program) const;
+    // 모든 mesh 를 감싸는 local space box
+    const BoundingBox& GetBoundingBox() const { return m_boundingBox; }
 
 private:
     Model() {}
-    bool LoadByAssimp(const std::string& filename);
-    void ProcessMesh(aiMesh* mesh, const aiScene* scene);
-    void ProcessNode(aiNode* node, const aiScene* scene);
+    // import 의 CPU 단계 결과. GL thread 에서 Mesh 로 만든다
+    struct ImportedMesh
+    {
+        std::vector<Vertex> vertices;
+        Mesh::DataStorage storage;
+        Mesh::Data data;
+        int32_t materialIndex { -1 };
+    };
+    using ImportedMeshUPtr = std::unique_ptr<ImportedMesh>;
+    // model directory 기준 texture 경로 -> decode 결과
+    using ImageFutureMap = std::unordered_map<std::string, std::shared_future<ImagePtr>>;
+
+    bool LoadFile(const std::string& filename);
+    bool LoadFromCache(const std::string& filepath, uint64_t key);
+    // cacheWriter 가 있으면 import 결과를 같이 쓴다
+    bool LoadByAssimp(const std::string& filepath, MeshCacheWriter* cacheWriter);
+    static void CollectMeshes(const aiNode* node, std::vector<uint32_t>& meshIndices);
+    // worker thread 에서 불리므로 멤버를 바꾸지 않는다
+    ImportedMeshUPtr ImportMesh(const aiMesh* mesh, uint32_t materialCount) const;
+    // texture cache 에 이미 있는 texture 는 decode 하지 않는다
+    ImageFutureMap DecodeTextures(const std::string& dirname, const std::vector<MeshCache::Material>& materials) const;
+    void CreateMaterials(const std::string& dirname, const std::vector<MeshCache::Material>& materials,
+        ImageFutureMap& images);
+    void AddMesh(MeshPtr mesh, int32_t materialIndex);
         
     std::vector<MeshPtr> m_meshes;
     std::vector<MaterialPtr> m_materials;
+    BoundingBox m_boundingBox;
+    VertexFormat m_vertexFormat { VERTEX_FORMAT_FULL };
+    GeometryPoolPtr m_geometryPool;
+    // load 하는 동안만 쓴다
+    ThreadPool* m_threadPool { nullptr };
+    TextureCache* m_textureCache { nullptr };
 
 };
 
@@ -0,0 +1,136 @@
+#include "occlusion_culler.h"
+#include "render_state.h"
+#include <cstring>
+
+static const UniformHandle<glm::mat4> s_viewProjection("viewProjection");
+static const UniformHandle<int> s_hiZ("hiZ");
+static const UniformHandle<int> s_hiZLevelCount("hiZLevelCount");
+// pyramid 를 읽을 texture unit, material 과 shadow map 이 쓰는 unit 을 피한다
+static const uint32_t HIZ_TEXTURE_UNIT = 4;
+
+OcclusionCullerUPtr OcclusionCuller::Create(uint32_t maxObjectCount)
+{
+    auto culler = OcclusionCullerUPtr(new OcclusionCuller());
+    if (!culler->Init(maxObjectCount))
+        return nullptr;
+    return std::move(culler);
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+    for (auto& result : m_results)
+    {
+        if (result.fence)
+            glDeleteSync(result.fence);
+    }
+}
+
+bool OcclusionCuller::Init(uint32_t maxObjectCount)
+{
+    if (maxObjectCount == 0)
+    {
+        SPDLOG_ERROR("occlusion culler needs at least one object");
+        return false;
+    }
+
+    ShaderPtr vs = Shader::CreateFromFile("/hiz_test.vs", GL_VERTEX_SHADER);
+    if (!vs)
+        return false;
+    m_testProgram = Program::Create({ vs }, { "outVisible" });
+    if (!m_testProgram)
+        return false;
+
+    m_maxObjectCount = maxObjectCount;
+    m_boxLayout = VertexLayout::Create();
+    m_boxBuffer = Buffer::CreateWithData(GL_ARRAY_BUFFER, GL_STREAM_DRAW,
+        nullptr, sizeof(glm::vec3) * 2, maxObjectCount);
+    m_boxLayout->SetAttrib(0, 3, GL_FLOAT, false, sizeof(glm::vec3) * 2, 0);
+    m_boxLayout->SetAttrib(1, 3, GL_FLOAT, false, sizeof(glm::vec3) * 2, sizeof(glm::vec3));
+
+    // GPU 가 쓰고 CPU 가 읽는다
+    for (auto& result : m_results)
+    {
+        result.buffer = Buffer::CreateWithData(GL_TRANSFORM_FEEDBACK_BUFFER, GL_STREAM_READ,
+            nullptr, sizeof(uint32_t), maxObjectCount);
+    }
+    m_boxData.reserve(maxObjectCount * 2);
+    return true;
+}
+
+void OcclusionCuller::Test(const std::vector<BoundingBox>& boxes, const glm::mat4& viewProjection,
+    const DepthPyramid* pyramid)
+{
+    ++m_frame;
+    auto& result = m_results[m_resultIndex];
+    // 세 frame 전 결과를 아직 못 읽었으면 그 자리를 덮어쓴다
+    if (result.fence)
+    {
+        glDeleteSync(result.fence);
+        result.fence = nullptr;
+    }
+
+    uint32_t objectCount = std::min((uint32_t)boxes.size(), m_maxObjectCount);
+    if (objectCount == 0)
+        return;
+    m_boxData.clear();
+    for (uint32_t i = 0; i < objectCount; ++i)
+    {
+        m_boxData.push_back(boxes[i].min);
+        m_boxData.push_back(boxes[i].max);
+    }
+    m_boxBuffer->Update(m_boxData.data(), m_boxData.size() * sizeof(glm::vec3));
+
+    m_testProgram->Use();
+    m_testProgram->SetUniform(s_viewProjection, viewProjection);
+    m_testProgram->SetUniform(s_hiZ, (int)HIZ_TEXTURE_UNIT);
+    m_testProgram->SetUniform(s_hiZLevelCount, pyramid->GetLevelCount());
+    pyramid->Bind(HIZ_TEXTURE_UNIT);
+
+    m_boxLayout->Bind();
+    RenderState::Get().BindBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, 0, (uint32_t)result.buffer->Get(), 0, 0);
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, (GLsizei)objectCount);
+    glEndTransformFeedback();
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    result.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    result.objectCount = objectCount;
+    result.frame = m_frame;
+    m_resultIndex = (m_resultIndex + 1) % RESULT_COUNT;
+}
+
+bool OcclusionCuller::ReadResults(std::vector<uint8_t>& occluded)
+{
+    // 끝난 것 중 가장 최근 frame 의 결과를 고른다
+    Result* latest = nullptr;
+    for (auto& result : m_results)
+    {
+        if (!result.fence || result.frame <= m_readFrame)
+            continue;
+        GLenum status = glClientWaitSync(result.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            continue;
+        if (!latest || result.frame > latest->frame)
+            latest = &result;
+    }
+    if (!latest)
+        return false;
+
+    auto& renderState = RenderState::Get();
+    renderState.BindBuffer(GL_COPY_READ_BUFFER, (uint32_t)latest->buffer->Get());
+    auto visible = (const uint32_t*)glMapBufferRange(GL_COPY_READ_BUFFER, 0,
+        latest->objectCount * sizeof(uint32_t), GL_MAP_READ_BIT);
+    if (!visible)
+        return false;
+
+    occluded.resize(std::max(occluded.size(), (size_t)latest->objectCount), 0);
+    for (uint32_t i = 0; i < latest->objectCount; ++i)
+        occluded[i] = visible[i] ? 0 : 1;
+    glUnmapBuffer(GL_COPY_READ_BUFFER);
+
+    m_readFrame = latest->frame;
+    glDeleteSync(latest->fence);
+    latest->fence = nullptr;
+    return true;
+}
\ No newline at end of file
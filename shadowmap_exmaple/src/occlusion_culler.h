@@ -0,0 +1,53 @@
+#ifndef __OCCLUSION_CULLER_H__
+#define __OCCLUSION_CULLER_H__
+
+#include "common.h"
+#include "buffer.h"
+#include "vertex_layout.h"
+#include "program.h"
+#include "bounds.h"
+#include "depth_pyramid.h"
+
+// bounding box 를 DepthPyramid 로 test 하는 GPU occlusion culling
+//
+// box 하나를 point 하나로 그려 vertex shader (hiz_test.vs) 가 결과를 transform feedback 으로 남긴다
+// 결과 buffer 는 frame 수만큼 돌려쓰고 fence 로 끝난 것만 읽으므로 CPU 는 기다리지 않는다
+// 대신 결과는 한 frame 이상 늦다. 늦게 보이게 된 물체는 그리는 쪽에서 한번 더 확인해야 한다
+CLASS_PTR(OcclusionCuller)
+class OcclusionCuller
+{
+public:
+    static OcclusionCullerUPtr Create(uint32_t maxObjectCount);
+    ~OcclusionCuller();
+
+    // viewProjection 은 pyramid 를 만든 depth 와 같은 시점이어야 한다
+    void Test(const std::vector<BoundingBox>& boxes, const glm::mat4& viewProjection, const DepthPyramid* pyramid);
+    // 끝난 test 중 가장 최근 것으로 occluded 를 채운다. 새 결과가 없으면 false
+    bool ReadResults(std::vector<uint8_t>& occluded);
+
+private:
+    OcclusionCuller() {}
+    bool Init(uint32_t maxObjectCount);
+
+    static const uint32_t RESULT_COUNT = 3;
+
+    struct Result
+    {
+        BufferUPtr buffer;
+        GLsync fence { nullptr };
+        uint32_t objectCount { 0 };
+        uint64_t frame { 0 };
+    };
+
+    ProgramUPtr m_testProgram;
+    BufferUPtr m_boxBuffer;
+    VertexLayoutUPtr m_boxLayout;
+    Result m_results[RESULT_COUNT];
+    uint32_t m_maxObjectCount { 0 };
+    uint32_t m_resultIndex { 0 };
+    uint64_t m_frame { 0 };
+    uint64_t m_readFrame { 0 };
+    std::vector<glm::vec3> m_boxData;
+};
+
+#endif // __OCCLUSION_CULLER_H__
\ No newline at end of file
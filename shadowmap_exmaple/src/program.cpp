@@ -1,32 +1,152 @@
 #include "program.h"
+#include "uniform_block.h"
+#include "program_binary_cache.h"
+#include "render_state.h"
+#include <cstring>
 
-ProgramUPtr Program::Create(const std::vector<ShaderPtr>& shaders)
+namespace
+{
+    struct UniformNameRegistry
+    {
+        std::unordered_map<std::string, uint32_t> ids;
+    };
+
+    UniformNameRegistry& GetUniformNameRegistry()
+    {
+        static UniformNameRegistry registry;
+        return registry;
+    }
+
+    bool IsParallelCompileSupported()
+    {
+        return GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile;
+    }
+
+    // driver 가 허용하는 만큼 compile thread 를 쓰도록 요청
+    void EnableParallelCompile()
+    {
+        static bool enabled = false;
+        if (enabled)
+            return;
+        enabled = true;
+
+        if (GLAD_GL_KHR_parallel_shader_compile)
+            glMaxShaderCompilerThreadsKHR(0xffffffff);
+        else if (GLAD_GL_ARB_parallel_shader_compile)
+            glMaxShaderCompilerThreadsARB(0xffffffff);
+    }
+}
+
+ProgramUPtr Program::Create(const std::vector<ShaderPtr>& shaders,
+    const std::vector<std::string>& feedbackVaryings)
 {
     auto program = ProgramUPtr(new Program());
-    if (!program->Link(shaders))
+    if (!program->Link(shaders, feedbackVaryings))
         return nullptr;
     return std::move(program);
 }
 
-ProgramUPtr Program::Create(const std::string& vertexShaderFilename, const std::string& fragmentShaderFilename)
+ProgramUPtr Program::Create(const std::string& vertexShaderFilename, const std::string& fragmentShaderFilename,
+    const ShaderDefines& defines, uint32_t permutationKey)
 {
-    ShaderPtr vs = Shader::CreateFromFile(vertexShaderFilename, GL_VERTEX_SHADER);
-    ShaderPtr fs = Shader::CreateFromFile(fragmentShaderFilename, GL_FRAGMENT_SHADER);
-    if (!vs || !fs)
+    auto program = CreateDeferred(vertexShaderFilename, fragmentShaderFilename, defines, permutationKey);
+    if (!program || !program->Resolve())
+        return nullptr;
+    return std::move(program);
+}
+
+ProgramUPtr Program::CreateDeferred(const std::string& vertexShaderFilename, const std::string& fragmentShaderFilename,
+    const ShaderDefines& defines, uint32_t permutationKey)
+{
+    EnableParallelCompile();
+
+    auto vsCode = Shader::LoadSource(vertexShaderFilename, defines);
+    auto fsCode = Shader::LoadSource(fragmentShaderFilename, defines);
+    if (!vsCode.has_value() || !fsCode.has_value())
         return nullptr;
 
-    return std::move(Create({vs, fs}));
+    // cache 에 link 된 binary 가 있으면 compile 을 건너뛴다
+    // define 은 source 에 들어가 있으므로 key 에 자동으로 반영된다
+    auto program = ProgramUPtr(new Program());
+    program->m_permutationKey = permutationKey;
+    uint64_t key = ProgramBinaryCache::MakeKey({ vsCode.value(), fsCode.value() });
+    if (program->LinkFromBinary(key))
+        return std::move(program);
+
+    ShaderPtr vs = Shader::SubmitFromSource(vsCode.value(), GL_VERTEX_SHADER, vertexShaderFilename);
+    ShaderPtr fs = Shader::SubmitFromSource(fsCode.value(), GL_FRAGMENT_SHADER, fragmentShaderFilename);
+    program->SubmitLink({vs, fs});
+    program->m_storeBinary = ProgramBinaryCache::IsSupported();
+    program->m_binaryKey = key;
+    return std::move(program);
+}
+
+uint32_t Program::RegisterUniformName(const std::string& name)
+{
+    auto& registry = GetUniformNameRegistry();
+    auto result = registry.ids.emplace(name, (uint32_t)registry.ids.size());
+    return result.first->second;
 }
 
-bool Program::Link(const std::vector<ShaderPtr>& shaders)
+bool Program::Link(const std::vector<ShaderPtr>& shaders, const std::vector<std::string>& feedbackVaryings)
 {
     m_program = glCreateProgram();
+    if (!feedbackVaryings.empty())
+    {
+        std::vector<const char*> names;
+        for (const auto& varying : feedbackVaryings)
+            names.push_back(varying.c_str());
+        glTransformFeedbackVaryings(m_program, (GLsizei)names.size(), names.data(), GL_INTERLEAVED_ATTRIBS);
+    }
+    SubmitLink(shaders);
+    return Resolve();
+}
+
+void Program::SubmitLink(const std::vector<ShaderPtr>& shaders)
+{
+    if (!m_program)
+        m_program = glCreateProgram();
+    if (ProgramBinaryCache::IsSupported())
+        glProgramParameteri(m_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
     for (auto& shader : shaders)
     {
         glAttachShader(m_program, shader->Get());
     }
     glLinkProgram(m_program);
 
+    m_pendingShaders = shaders;
+    m_pending = true;
+}
+
+bool Program::IsReady() const
+{
+    if (!m_pending)
+        return true;
+    // extension 이 없으면 Resolve() 에서 driver 가 끝날 때까지 기다린다
+    if (!IsParallelCompileSupported())
+        return true;
+
+    int completed = 0;
+    glGetProgramiv(m_program, GL_COMPLETION_STATUS_KHR, &completed);
+    return completed != 0;
+}
+
+bool Program::Resolve()
+{
+    if (!m_pending)
+        return m_linked;
+    m_pending = false;
+
+    bool compiled = true;
+    for (auto& shader : m_pendingShaders)
+    {
+        compiled = shader->CheckCompileStatus() && compiled;
+    }
+    m_pendingShaders.clear();
+    if (!compiled)
+        return false;
+
     int success = 0;
     glGetProgramiv(m_program, GL_LINK_STATUS, &success);
     if (!success)
@@ -36,55 +156,219 @@ bool Program::Link(const std::vector<ShaderPtr>& shaders)
         SPDLOG_ERROR("Failed to link program: {}", infoLog);
         return false;
     }
+
+    InitAfterLink();
+    if (m_storeBinary)
+        ProgramBinaryCache::Store(m_program, m_binaryKey);
     return true;
 }
 
+bool Program::LinkFromBinary(uint64_t key)
+{
+    if (!ProgramBinaryCache::IsSupported())
+        return false;
+
+    m_program = glCreateProgram();
+    if (!ProgramBinaryCache::Load(m_program, key))
+        return false;
+
+    InitAfterLink();
+    return true;
+}
+
+void Program::InitAfterLink()
+{
+    // block binding 은 binary 에 포함된다는 보장이 없어 link 후 매번 지정
+    for (const auto& block : UNIFORM_BLOCKS)
+    {
+        auto blockIndex = glGetUniformBlockIndex(m_program, block.name);
+        if (blockIndex != GL_INVALID_INDEX)
+            glUniformBlockBinding(m_program, blockIndex, block.binding);
+    }
+
+    ReflectUniforms();
+    m_linked = true;
+}
+
+void Program::ReflectUniforms()
+{
+    m_uniforms.clear();
+    m_uniformSlots.clear();
+
+    int uniformCount = 0;
+    int maxNameLength = 0;
+    glGetProgramiv(m_program, GL_ACTIVE_UNIFORMS, &uniformCount);
+    glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+    std::vector<char> nameBuffer(std::max(maxNameLength, 1));
+    auto SetSlot = [&](const std::string& name, int32_t slot) {
+        uint32_t id = RegisterUniformName(name);
+        if (id >= m_uniformSlots.size())
+            m_uniformSlots.resize(id + 1, -1);
+        m_uniformSlots[id] = slot;
+    };
+    auto AddUniform = [&](const std::string& name, int32_t location, uint32_t type) {
+        SetSlot(name, (int32_t)m_uniforms.size());
+        UniformInfo uniform;
+        uniform.location = location;
+        uniform.type = type;
+        m_uniforms.push_back(uniform);
+    };
+
+    for (int i = 0; i < uniformCount; ++i)
+    {
+        int size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(m_program, i, (GLsizei)nameBuffer.size(), nullptr, &size, &type, nameBuffer.data());
+        std::string name = nameBuffer.data();
+
+        // uniform block 의 member 는 location 이 없다
+        int32_t location = glGetUniformLocation(m_program, name.c_str());
+        if (location < 0)
+            continue;
+
+        // struct 배열의 member ("lights[1].position") 는 원소마다 따로 나오므로 받은 이름 그대로 등록
+        AddUniform(name, location, type);
+
+        // 배열은 "name[0]" 으로 나온다. "name" 은 같은 location 이므로 cache 도 같이 쓰게 한다
+        const std::string arraySuffix = "[0]";
+        if (name.size() <= arraySuffix.size() ||
+            name.compare(name.size() - arraySuffix.size(), arraySuffix.size(), arraySuffix) != 0)
+            continue;
+        auto baseName = name.substr(0, name.size() - arraySuffix.size());
+        SetSlot(baseName, (int32_t)m_uniforms.size() - 1);
+        for (int j = 1; j < size; ++j)
+        {
+            auto elementName = fmt::format("{}[{}]", baseName, j);
+            AddUniform(elementName, glGetUniformLocation(m_program, elementName.c_str()), type);
+        }
+    }
+}
+
 void Program::Use() const
 {
-    glUseProgram(m_program);
+    RenderState::Get().UseProgram(m_program);
 }
 
 Program::~Program()
 {
     if (m_program)
     {
+        RenderState::Get().OnDeleteProgram(m_program);
         glDeleteProgram(m_program);
     }
 }
 
+Program::UniformInfo* Program::FindUniform(uint32_t id) const
+{
+    if (id >= m_uniformSlots.size() || m_uniformSlots[id] < 0)
+        return nullptr;
+    return &m_uniforms[m_uniformSlots[id]];
+}
+
+Program::UniformInfo* Program::FindUniform(const std::string& name) const
+{
+    auto& registry = GetUniformNameRegistry();
+    auto iter = registry.ids.find(name);
+    if (iter == registry.ids.end())
+        return nullptr;
+    return FindUniform(iter->second);
+}
+
+// 마지막으로 올린 값과 같으면 false 를 돌려 upload 를 생략하게 한다
+template <typename T>
+bool Program::UpdateCache(UniformInfo* uniform, const T& value) const
+{
+    static_assert(sizeof(T) <= sizeof(UniformInfo::value), "uniform value is too large");
+    if (!uniform)
+        return false;
+    if (uniform->cached && memcmp(uniform->value, &value, sizeof(T)) == 0)
+        return false;
+    memcpy(uniform->value, &value, sizeof(T));
+    uniform->cached = true;
+    return true;
+}
+
 void Program::SetUniform(const std::string& name, int value) const
 {
-    auto loc = glGetUniformLocation(m_program, name.c_str());
-    glUniform1i(loc, value);
-    glUniform1i(glGetUniformLocation(m_program, name.c_str()), value);
+    auto uniform = FindUniform(name);
+    if (UpdateCache(uniform, value))
+        glUniform1i(uniform->location, value);
 }
 
 void Program::SetUniform(const std::string& name, float value) const
 {
-    auto loc = glGetUniformLocation(m_program, name.c_str());
-    glUniform1f(loc, value);
+    auto uniform = FindUniform(name);
+    if (UpdateCache(uniform, value))
+        glUniform1f(uniform->location, value);
 }
 
 void Program::SetUniform(const std::string& name, const glm::mat4& value) const
 {
-    auto loc = glGetUniformLocation(m_program, name.c_str());
-    glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(value));
+    auto uniform = FindUniform(name);
+    if (UpdateCache(uniform, value))
+        glUniformMatrix4fv(uniform->location, 1, GL_FALSE, glm::value_ptr(value));
 }
 
 void Program::SetUniform(const std::string& name, const glm::vec2& value) const
 {
-    auto loc = glGetUniformLocation(m_program, name.c_str());
-    glUniform2fv(loc, 1, glm::value_ptr(value));
+    auto uniform = FindUniform(name);
+    if (UpdateCache(uniform, value))
+        glUniform2fv(uniform->location, 1, glm::value_ptr(value));
 }
 
 void Program::SetUniform(const std::string& name, const glm::vec3& value) const
 {
-    auto loc = glGetUniformLocation(m_program, name.c_str());
-    glUniform3fv(loc, 1, glm::value_ptr(value));
+    auto uniform = FindUniform(name);
+    if (UpdateCache(uniform, value))
+        glUniform3fv(uniform->location, 1, glm::value_ptr(value));
 }
 
 void Program::SetUniform(const std::string& name, const glm::vec4& value) const
 {
-    auto loc = glGetUniformLocation(m_program, name.c_str());
-    glUniform4fv(loc, 1, glm::value_ptr(value));
+    auto uniform = FindUniform(name);
+    if (UpdateCache(uniform, value))
+        glUniform4fv(uniform->location, 1, glm::value_ptr(value));
+}
+
+void Program::SetUniform(const UniformHandle<int>& handle, int value) const
+{
+    auto uniform = FindUniform(handle.GetId());
+    if (UpdateCache(uniform, value))
+        glUniform1i(uniform->location, value);
+}
+
+void Program::SetUniform(const UniformHandle<float>& handle, float value) const
+{
+    auto uniform = FindUniform(handle.GetId());
+    if (UpdateCache(uniform, value))
+        glUniform1f(uniform->location, value);
+}
+
+void Program::SetUniform(const UniformHandle<glm::vec2>& handle, const glm::vec2& value) const
+{
+    auto uniform = FindUniform(handle.GetId());
+    if (UpdateCache(uniform, value))
+        glUniform2fv(uniform->location, 1, glm::value_ptr(value));
+}
+
+void Program::SetUniform(const UniformHandle<glm::vec3>& handle, const glm::vec3& value) const
+{
+    auto uniform = FindUniform(handle.GetId());
+    if (UpdateCache(uniform, value))
+        glUniform3fv(uniform->location, 1, glm::value_ptr(value));
+}
+
+void Program::SetUniform(const UniformHandle<glm::vec4>& handle, const glm::vec4& value) const
+{
+    auto uniform = FindUniform(handle.GetId());
+    if (UpdateCache(uniform, value))
+        glUniform4fv(uniform->location, 1, glm::value_ptr(value));
+}
+
+void Program::SetUniform(const UniformHandle<glm::mat4>& handle, const glm::mat4& value) const
+{
+    auto uniform = FindUniform(handle.GetId());
+    if (UpdateCache(uniform, value))
+        glUniformMatrix4fv(uniform->location, 1, GL_FALSE, glm::value_ptr(value));
 }
\ No newline at end of file
@@ -3,16 +3,43 @@
 
 #include "common.h"
 #include "shader.h"
+#include <unordered_map>
+
+// uniform 이름을 전역 id 로 바꿔둔 handle
+// 모든 Program 이 같은 id 를 공유하므로 hot path 에서 문자열을 다루지 않는다
+template <typename T>
+class UniformHandle
+{
+public:
+    explicit UniformHandle(const char* name);
+    uint32_t GetId() const { return m_id; }
+
+private:
+    uint32_t m_id { 0 };
+};
 
 CLASS_PTR(Program);
 class Program
 {
 public:
-    static ProgramUPtr Create(const std::vector<ShaderPtr>& shaders);
-    static ProgramUPtr Create(const std::string& vertexShaderFilename, const std::string& fragmentShaderFilename);
+    // feedbackVaryings 가 있으면 link 전에 transform feedback 으로 받을 output 을 지정
+    static ProgramUPtr Create(const std::vector<ShaderPtr>& shaders,
+        const std::vector<std::string>& feedbackVaryings = {});
+    static ProgramUPtr Create(const std::string& vertexShaderFilename, const std::string& fragmentShaderFilename,
+        const ShaderDefines& defines = {}, uint32_t permutationKey = 0);
+    // compile / link 를 제출만 하고 바로 돌려준다. 사용 전에 Resolve() 를 호출해야 함
+    static ProgramUPtr CreateDeferred(const std::string& vertexShaderFilename, const std::string& fragmentShaderFilename,
+        const ShaderDefines& defines = {}, uint32_t permutationKey = 0);
+    static uint32_t RegisterUniformName(const std::string& name);
     ~Program();
     void Use() const;
     uint32_t Get() const { return m_program; }
+    uint32_t GetPermutationKey() const { return m_permutationKey; }
+
+    // KHR_parallel_shader_compile 이 있으면 block 없이 완료 여부를 확인
+    bool IsReady() const;
+    // compile / link 결과를 확인하고 uniform 정보를 채운다
+    bool Resolve();
 
     void SetUniform(const std::string& name, int value) const;
     void SetUniform(const std::string& name, float value) const;
@@ -21,10 +48,54 @@ public:
     void SetUniform(const std::string& name, const glm::vec4& value) const;
     void SetUniform(const std::string& name, const glm::mat4& value) const;
 
+    void SetUniform(const UniformHandle<int>& uniform, int value) const;
+    void SetUniform(const UniformHandle<float>& uniform, float value) const;
+    void SetUniform(const UniformHandle<glm::vec2>& uniform, const glm::vec2& value) const;
+    void SetUniform(const UniformHandle<glm::vec3>& uniform, const glm::vec3& value) const;
+    void SetUniform(const UniformHandle<glm::vec4>& uniform, const glm::vec4& value) const;
+    void SetUniform(const UniformHandle<glm::mat4>& uniform, const glm::mat4& value) const;
+
+    bool HasUniform(uint32_t id) const { return FindUniform(id) != nullptr; }
+
 private:
     Program() {}
-    bool Link(const std::vector<ShaderPtr>& shaders);
+    bool Link(const std::vector<ShaderPtr>& shaders, const std::vector<std::string>& feedbackVaryings);
+    void SubmitLink(const std::vector<ShaderPtr>& shaders);
+    bool LinkFromBinary(uint64_t key);
+    void InitAfterLink();
+    void ReflectUniforms();
+
+    // link 시점에 reflect 한 active uniform 정보와 마지막으로 올린 값
+    struct UniformInfo
+    {
+        int32_t location { -1 };
+        uint32_t type { 0 };
+        bool cached { false };
+        alignas(16) uint8_t value[sizeof(glm::mat4)];
+    };
+
+    UniformInfo* FindUniform(uint32_t id) const;
+    UniformInfo* FindUniform(const std::string& name) const;
+    template <typename T>
+    bool UpdateCache(UniformInfo* uniform, const T& value) const;
+
     uint32_t m_program { 0 };
+    uint32_t m_permutationKey { 0 };
+    bool m_pending { false };
+    bool m_linked { false };
+    std::vector<ShaderPtr> m_pendingShaders;
+    bool m_storeBinary { false };
+    uint64_t m_binaryKey { 0 };
+
+    // uniform id -> m_uniforms index, 없으면 -1
+    std::vector<int32_t> m_uniformSlots;
+    mutable std::vector<UniformInfo> m_uniforms;
 };
 
+template <typename T>
+UniformHandle<T>::UniformHandle(const char* name)
+    : m_id(Program::RegisterUniformName(name))
+{
+}
+
 #endif // __PROGRAM_H__
\ No newline at end of file
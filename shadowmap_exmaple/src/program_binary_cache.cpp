@@ -0,0 +1,131 @@
+#include "program_binary_cache.h"
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+    const uint32_t BINARY_MAGIC = 0x4e494250; // "PBIN"
+    const uint32_t BINARY_VERSION = 1;
+
+    struct BinaryHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint32_t format;
+        uint32_t length;
+    };
+}
+
+ProgramBinaryCache::Stats ProgramBinaryCache::s_stats;
+
+bool ProgramBinaryCache::IsSupported()
+{
+    static const bool supported = [] {
+        if (!GLAD_GL_VERSION_4_1 && !GLAD_GL_ARB_get_program_binary)
+            return false;
+        int formatCount = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+        return formatCount > 0;
+    }();
+    return supported;
+}
+
+uint64_t ProgramBinaryCache::MakeKey(const std::vector<std::string>& sources)
+{
+    static const std::string driver = fmt::format("{}/{}/{}",
+        reinterpret_cast<const char*>(glGetString(GL_VENDOR)),
+        reinterpret_cast<const char*>(glGetString(GL_RENDERER)),
+        reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+
+    uint64_t key = HashBytes(&BINARY_VERSION, sizeof(BINARY_VERSION));
+    key = HashString(driver, key);
+    for (const auto& source : sources)
+    {
+        key = HashString(source, key);
+    }
+    return key;
+}
+
+std::string ProgramBinaryCache::GetFilePath(uint64_t key)
+{
+    return fmt::format("{}/{:016x}.bin", PROGRAM_CACHE_PATH, key);
+}
+
+bool ProgramBinaryCache::Load(uint32_t program, uint64_t key)
+{
+    auto filepath = GetFilePath(key);
+    std::ifstream fin(filepath, std::ios::binary);
+    if (!fin.is_open())
+    {
+        ++s_stats.missCount;
+        return false;
+    }
+
+    std::error_code error;
+    uint64_t fileSize = std::filesystem::file_size(filepath, error);
+    if (error)
+        fileSize = 0;
+
+    BinaryHeader header = {};
+    fin.read(reinterpret_cast<char*>(&header), sizeof(header));
+    std::vector<char> binary;
+    // 깨진 file 의 length 로 큰 buffer 를 잡지 않게 file 크기와 먼저 맞춰 본다
+    if (fin && header.magic == BINARY_MAGIC && header.version == BINARY_VERSION && header.key == key &&
+        fileSize >= sizeof(header) && header.length <= fileSize - sizeof(header))
+    {
+        binary.resize(header.length);
+        fin.read(binary.data(), binary.size());
+    }
+    fin.close();
+
+    if (binary.empty() || !fin)
+    {
+        SPDLOG_WARN("broken program binary: {}", filepath);
+        ++s_stats.rejectCount;
+        std::filesystem::remove(filepath, error);
+        return false;
+    }
+
+    glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+    int success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        // driver 업데이트 등으로 binary 가 거부되면 source 에서 다시 만든다
+        SPDLOG_INFO("program binary rejected by driver: {}", filepath);
+        ++s_stats.rejectCount;
+        std::filesystem::remove(filepath, error);
+        return false;
+    }
+
+    ++s_stats.hitCount;
+    return true;
+}
+
+void ProgramBinaryCache::Store(uint32_t program, uint64_t key)
+{
+    int length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    std::error_code error;
+    std::filesystem::create_directories(PROGRAM_CACHE_PATH, error);
+
+    auto filepath = GetFilePath(key);
+    std::ofstream fout(filepath, std::ios::binary);
+    if (!fout.is_open())
+    {
+        SPDLOG_WARN("failed to write program binary: {}", filepath);
+        return;
+    }
+
+    BinaryHeader header = { BINARY_MAGIC, BINARY_VERSION, key, format, (uint32_t)length };
+    fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    fout.write(binary.data(), length);
+}
\ No newline at end of file
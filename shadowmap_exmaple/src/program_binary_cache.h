@@ -0,0 +1,29 @@
+#ifndef __PROGRAM_BINARY_CACHE_H__
+#define __PROGRAM_BINARY_CACHE_H__
+
+#include "common.h"
+
+// glGetProgramBinary / glProgramBinary 를 이용한 link 결과 disk cache
+// key 는 shader source 와 driver 정보로 만들기 때문에 driver 가 바뀌면 자동으로 miss 난다
+class ProgramBinaryCache
+{
+public:
+    struct Stats
+    {
+        int hitCount { 0 };
+        int missCount { 0 };
+        int rejectCount { 0 };
+    };
+
+    static bool IsSupported();
+    static uint64_t MakeKey(const std::vector<std::string>& sources);
+    static bool Load(uint32_t program, uint64_t key);
+    static void Store(uint32_t program, uint64_t key);
+    static const Stats& GetStats() { return s_stats; }
+
+private:
+    static std::string GetFilePath(uint64_t key);
+    static Stats s_stats;
+};
+
+#endif // __PROGRAM_BINARY_CACHE_H__
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include "program_variants.h"
+
+ProgramVariantsUPtr ProgramVariants::Create(
+    const std::string& vertexShaderFilename, const std::string& fragmentShaderFilename,
+    DefineBuilder defineBuilder)
+{
+    auto variants = ProgramVariantsUPtr(new ProgramVariants());
+    variants->m_vertexShaderFilename = vertexShaderFilename;
+    variants->m_fragmentShaderFilename = fragmentShaderFilename;
+    variants->m_defineBuilder = std::move(defineBuilder);
+    return std::move(variants);
+}
+
+bool ProgramVariants::Prepare(uint32_t permutationKey)
+{
+    auto iter = m_variants.find(permutationKey);
+    if (iter != m_variants.end())
+        return iter->second != nullptr;
+
+    auto program = Program::CreateDeferred(
+        m_vertexShaderFilename, m_fragmentShaderFilename,
+        m_defineBuilder(permutationKey), permutationKey);
+    bool success = program != nullptr;
+    m_variants[permutationKey] = std::move(program);
+    return success;
+}
+
+bool ProgramVariants::ResolveAll()
+{
+    bool success = true;
+    for (auto& variant : m_variants)
+    {
+        if (variant.second && !variant.second->Resolve())
+        {
+            SPDLOG_ERROR("failed to build variant {:#x} of {}, {}",
+                variant.first, m_vertexShaderFilename, m_fragmentShaderFilename);
+            variant.second.reset();
+        }
+        success = success && variant.second != nullptr;
+    }
+    return success;
+}
+
+const Program* ProgramVariants::Get(uint32_t permutationKey)
+{
+    auto iter = m_variants.find(permutationKey);
+    if (iter == m_variants.end())
+    {
+        Prepare(permutationKey);
+        iter = m_variants.find(permutationKey);
+    }
+
+    auto& program = iter->second;
+    if (!program)
+        return nullptr;
+    if (!program->Resolve())
+    {
+        SPDLOG_ERROR("failed to build variant {:#x} of {}, {}",
+            permutationKey, m_vertexShaderFilename, m_fragmentShaderFilename);
+        program.reset();
+        return nullptr;
+    }
+    return program.get();
+}
\ No newline at end of file
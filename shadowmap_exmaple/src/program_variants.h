@@ -0,0 +1,37 @@
+#ifndef __PROGRAM_VARIANTS_H__
+#define __PROGRAM_VARIANTS_H__
+
+#include "program.h"
+#include <functional>
+#include <unordered_map>
+
+// 같은 shader 파일을 permutation key 별 define 으로 특수화한 program 모음
+// key 마다 한번만 compile 하고, draw 할 때 key 로 골라 쓴다
+CLASS_PTR(ProgramVariants)
+class ProgramVariants
+{
+public:
+    using DefineBuilder = std::function<ShaderDefines(uint32_t permutationKey)>;
+
+    static ProgramVariantsUPtr Create(
+        const std::string& vertexShaderFilename, const std::string& fragmentShaderFilename,
+        DefineBuilder defineBuilder);
+
+    // 아직 없는 variant 의 compile 을 제출만 해둔다
+    bool Prepare(uint32_t permutationKey);
+    bool ResolveAll();
+    // 준비되지 않은 variant 는 여기서 compile 을 기다린다. 실패하면 nullptr
+    const Program* Get(uint32_t permutationKey);
+    size_t GetVariantCount() const { return m_variants.size(); }
+
+private:
+    ProgramVariants() {}
+
+    std::string m_vertexShaderFilename;
+    std::string m_fragmentShaderFilename;
+    DefineBuilder m_defineBuilder;
+    // compile 에 실패한 key 는 nullptr 로 남겨 매 frame 재시도하지 않는다
+    std::unordered_map<uint32_t, ProgramUPtr> m_variants;
+};
+
+#endif // __PROGRAM_VARIANTS_H__
\ No newline at end of file
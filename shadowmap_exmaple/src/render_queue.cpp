@@ -0,0 +1,269 @@
+#include "render_queue.h"
+#include "render_state.h"
+#include <algorithm>
+
+static const UniformHandle<glm::mat4> s_modelTransform("modelTransform");
+
+static const uint32_t PASS_BITS = 4;
+static const uint32_t PROGRAM_BITS = 10;
+static const uint32_t MATERIAL_BITS = 12;
+static const uint32_t MESH_BITS = 14;
+static const uint32_t DEPTH_BITS = 24;
+static const uint32_t PASS_SHIFT = 64 - PASS_BITS;
+// shader/model_transform.glsl 의 aModelTransform location
+static const uint32_t INSTANCE_TRANSFORM_LOCATION = 4;
+static_assert(PASS_BITS + PROGRAM_BITS + MATERIAL_BITS + MESH_BITS + DEPTH_BITS == 64,
+    "sort key must use exactly 64 bits");
+
+RenderQueueUPtr RenderQueue::Create(StreamBufferPtr instanceStream)
+{
+    auto renderQueue = RenderQueueUPtr(new RenderQueue());
+    renderQueue->m_instanceStream = instanceStream;
+    return std::move(renderQueue);
+}
+
+void RenderQueue::Clear()
+{
+    m_items.clear();
+    m_entries.clear();
+    m_batches.clear();
+    m_instanceTransforms.clear();
+    m_instanceAllocation = StreamBuffer::Allocation();
+    m_programSlots.clear();
+    m_materialSlots.clear();
+    m_meshSlots.clear();
+    m_sorted = false;
+    for (auto& stats : m_stats)
+        stats = Stats();
+}
+
+uint32_t RenderQueue::GetSlot(std::unordered_map<const void*, uint32_t>& slots, const void* object, uint32_t limit)
+{
+    auto result = slots.emplace(object, (uint32_t)slots.size());
+    // 개수가 넘치면 마지막 번호를 같이 쓴다. 정렬만 덜 묶일 뿐 그리는 결과는 같다
+    return std::min(result.first->second, limit - 1);
+}
+
+void RenderQueue::Add(RenderPass pass, const Program* program, const Program* instancedProgram,
+    const Mesh* mesh, const Material* material, const glm::mat4& transform, float depth, uint32_t lod)
+{
+    // Mesh::Draw 는 mesh 의 material 을 bind 하므로 그것을 item 의 material 로 삼아야
+    // Execute 가 추적하는 material 과 실제로 bind 된 material 이 어긋나지 않는다
+    if (mesh->GetMaterial())
+        material = mesh->GetMaterial().get();
+    uint64_t programSlot = GetSlot(m_programSlots, program, 1u << PROGRAM_BITS);
+    uint64_t materialSlot = GetSlot(m_materialSlots, material, 1u << MATERIAL_BITS);
+    // lod 구간의 주소로 mesh 와 lod 를 같이 구분한다
+    uint64_t meshSlot = GetSlot(m_meshSlots, &mesh->GetLod(lod), 1u << MESH_BITS);
+    const uint64_t depthMax = (1u << DEPTH_BITS) - 1;
+    uint64_t quantizedDepth = (uint64_t)(glm::clamp(depth, 0.0f, 1.0f) * depthMax);
+
+    uint64_t state = (programSlot << (MATERIAL_BITS + MESH_BITS)) | (materialSlot << MESH_BITS) | meshSlot;
+    uint64_t key = (uint64_t)pass << PASS_SHIFT;
+    if (pass == RENDER_PASS_TRANSPARENT)
+        key |= ((depthMax - quantizedDepth) << (PROGRAM_BITS + MATERIAL_BITS + MESH_BITS)) | state;
+    else
+        key |= (state << DEPTH_BITS) | quantizedDepth;
+
+    m_entries.push_back({ key, (uint32_t)m_items.size() });
+    DrawItem item;
+    item.program = program;
+    item.instancedProgram = instancedProgram;
+    item.mesh = mesh;
+    item.material = material;
+    item.transform = transform;
+    item.lod = lod;
+    m_items.push_back(item);
+    m_sorted = false;
+}
+
+void RenderQueue::Sort()
+{
+    if (m_sorted)
+        return;
+    RadixSort();
+    BuildBatches();
+    UploadInstances();
+    m_sorted = true;
+}
+
+// LSD radix sort, 8bit 씩 8번
+// 모든 key 의 자리 값이 같은 byte 는 건너뛴다 (대부분 pass / slot 상위 bit)
+void RenderQueue::RadixSort()
+{
+    const size_t count = m_entries.size();
+    if (count < 2)
+        return;
+
+    uint32_t histograms[8][256] = {};
+    for (const auto& entry : m_entries)
+    {
+        for (int digit = 0; digit < 8; ++digit)
+            ++histograms[digit][(entry.key >> (digit * 8)) & 0xff];
+    }
+
+    m_sortBuffer.resize(count);
+    auto* source = &m_entries;
+    auto* dest = &m_sortBuffer;
+    for (int digit = 0; digit < 8; ++digit)
+    {
+        auto& histogram = histograms[digit];
+        uint32_t firstBucket = (source->front().key >> (digit * 8)) & 0xff;
+        if (histogram[firstBucket] == count)
+            continue;
+
+        uint32_t offsets[256];
+        uint32_t offset = 0;
+        for (int bucket = 0; bucket < 256; ++bucket)
+        {
+            offsets[bucket] = offset;
+            offset += histogram[bucket];
+        }
+        for (const auto& entry : *source)
+            (*dest)[offsets[(entry.key >> (digit * 8)) & 0xff]++] = entry;
+        std::swap(source, dest);
+    }
+    if (source != &m_entries)
+        m_entries.swap(m_sortBuffer);
+}
+
+void RenderQueue::BuildBatches()
+{
+    m_batches.clear();
+    m_instanceTransforms.clear();
+
+    uint32_t entryIndex = 0;
+    const uint32_t entryCount = (uint32_t)m_entries.size();
+    for (uint32_t pass = 0; pass < RENDER_PASS_COUNT; ++pass)
+    {
+        m_passBatches[pass] = (uint32_t)m_batches.size();
+        while (entryIndex < entryCount && (m_entries[entryIndex].key >> PASS_SHIFT) == pass)
+        {
+            const auto& first = m_items[m_entries[entryIndex].index];
+            uint32_t end = entryIndex + 1;
+            if (first.instancedProgram)
+            {
+                // 정렬 덕분에 같이 그릴 수 있는 item 은 붙어 있다
+                while (end < entryCount && (m_entries[end].key >> PASS_SHIFT) == pass)
+                {
+                    const auto& item = m_items[m_entries[end].index];
+                    if (item.program != first.program || item.mesh != first.mesh ||
+                        item.lod != first.lod || item.material != first.material)
+                        break;
+                    ++end;
+                }
+            }
+
+            Batch batch;
+            batch.firstEntry = entryIndex;
+            batch.instanceCount = end - entryIndex;
+            batch.instanceOffset = (uint32_t)m_instanceTransforms.size();
+            if (batch.instanceCount > 1)
+            {
+                for (uint32_t i = entryIndex; i < end; ++i)
+                    m_instanceTransforms.push_back(m_items[m_entries[i].index].transform);
+            }
+            m_batches.push_back(batch);
+            entryIndex = end;
+        }
+    }
+    m_passBatches[RENDER_PASS_COUNT] = (uint32_t)m_batches.size();
+}
+
+void RenderQueue::UploadInstances()
+{
+    m_instanceAllocation = StreamBuffer::Allocation();
+    if (m_instanceTransforms.empty())
+        return;
+
+    m_instanceAllocation = m_instanceStream->Push(m_instanceTransforms.data(),
+        m_instanceTransforms.size(), sizeof(glm::mat4));
+    m_instanceStream->Flush();
+}
+
+const VertexLayout* RenderQueue::GetInstanceLayout(const Mesh* mesh)
+{
+    auto iter = m_instanceLayouts.find(mesh->GetVertexLayout());
+    if (iter != m_instanceLayouts.end())
+        return iter->second.get();
+
+    auto layout = VertexLayout::Create();
+    mesh->AttachToVertexLayout(layout.get());
+    for (uint32_t column = 0; column < 4; ++column)
+        layout->SetAttribDivisor(INSTANCE_TRANSFORM_LOCATION + column, 1);
+    auto result = layout.get();
+    m_instanceLayouts[mesh->GetVertexLayout()] = std::move(layout);
+    return result;
+}
+
+void RenderQueue::Execute(RenderPass pass)
+{
+    Sort();
+
+    auto& renderState = RenderState::Get();
+    DepthState depthState;
+    BlendState blendState;
+    if (pass == RENDER_PASS_TRANSPARENT)
+    {
+        // 뒤에서 앞으로 섞으므로 depth 는 test 만
+        depthState.write = false;
+        blendState.enable = true;
+        blendState.srcFactor = GL_SRC_ALPHA;
+        blendState.dstFactor = GL_ONE_MINUS_SRC_ALPHA;
+    }
+    renderState.SetDepthState(depthState);
+    renderState.SetBlendState(blendState);
+
+    auto& stats = m_stats[pass];
+    const Program* currentProgram = nullptr;
+    const Material* currentMaterial = nullptr;
+    for (uint32_t batchIndex = m_passBatches[pass]; batchIndex < m_passBatches[pass + 1]; ++batchIndex)
+    {
+        const auto& batch = m_batches[batchIndex];
+        const auto& item = m_items[m_entries[batch.firstEntry].index];
+        bool instanced = batch.instanceCount > 1 && m_instanceAllocation.IsValid();
+        const Program* program = instanced ? item.instancedProgram : item.program;
+        if (program != currentProgram)
+        {
+            program->Use();
+            currentProgram = program;
+            currentMaterial = nullptr;
+            ++stats.programChanges;
+        }
+        if (item.material && item.material != currentMaterial)
+        {
+            item.material->SetToProgram(program);
+            currentMaterial = item.material;
+            ++stats.materialChanges;
+        }
+        stats.itemCount += batch.instanceCount;
+        stats.triangleCount += item.mesh->GetLod(item.lod).indexCount / 3 * batch.instanceCount;
+        ++stats.drawCount;
+
+        if (!instanced)
+        {
+            for (uint32_t i = 0; i < batch.instanceCount; ++i)
+            {
+                const auto& batchItem = m_items[m_entries[batch.firstEntry + i].index];
+                program->SetUniform(s_modelTransform, batchItem.transform);
+                batchItem.mesh->Draw(program, batchItem.lod);
+            }
+            continue;
+        }
+
+        auto layout = GetInstanceLayout(item.mesh);
+        layout->Bind();
+        m_instanceStream->Bind();
+        size_t offset = m_instanceAllocation.offset + batch.instanceOffset * sizeof(glm::mat4);
+        for (uint32_t column = 0; column < 4; ++column)
+        {
+            layout->SetAttrib(INSTANCE_TRANSFORM_LOCATION + column, 4, GL_FLOAT, GL_FALSE,
+                sizeof(glm::mat4), offset + column * sizeof(glm::vec4));
+        }
+        item.mesh->SetVertexUniforms(program);
+        glDrawElementsInstancedBaseVertex(item.mesh->GetPrimitiveType(), (GLsizei)item.mesh->GetLod(item.lod).indexCount,
+            item.mesh->GetIndexType(), (void*)item.mesh->GetLodByteOffset(item.lod), batch.instanceCount,
+            item.mesh->GetBaseVertex());
+        ++stats.instancedDrawCount;
+    }
+}
\ No newline at end of file
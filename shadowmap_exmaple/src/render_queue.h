@@ -0,0 +1,117 @@
+#ifndef __RENDER_QUEUE_H__
+#define __RENDER_QUEUE_H__
+
+#include "common.h"
+#include "mesh.h"
+#include "buffer.h"
+#include "vertex_layout.h"
+#include "stream_buffer.h"
+#include <unordered_map>
+
+enum RenderPass : uint32_t
+{
+    RENDER_PASS_SHADOW = 0,
+    RENDER_PASS_OPAQUE = 1,
+    RENDER_PASS_TRANSPARENT = 2,
+    RENDER_PASS_COUNT,
+};
+
+struct DrawItem
+{
+    const Program* program { nullptr };
+    // INSTANCED 로 compile 한 같은 shader. 없으면 instancing 하지 않는다
+    const Program* instancedProgram { nullptr };
+    const Mesh* mesh { nullptr };
+    const Material* material { nullptr };
+    glm::mat4 transform { glm::mat4(1.0f) };
+    uint32_t lod { 0 };
+};
+
+// frame 마다 draw item 을 모아 64bit key 로 정렬한 뒤 pass 별로 그린다
+//
+// opaque / shadow : [pass 4][program 10][material 12][mesh 14][depth 24]
+//   state 가 같은 것끼리 모이고, 그 안에서는 가까운 것부터 (early-z)
+// transparent     : [pass 4][~depth 24][program 10][material 12][mesh 14]
+//   blending 결과가 맞도록 먼 것부터
+//
+// mesh 의 lod 가 다르면 다른 mesh 로 취급한다
+// 정렬 후 program / material / mesh 가 같은 연속된 item 은
+// model matrix 를 instance buffer 에 모아 한번의 glDrawElementsInstanced 로 그린다
+CLASS_PTR(RenderQueue)
+class RenderQueue
+{
+public:
+    // instance data 는 instanceStream 에 frame 마다 새로 쓴다
+    static RenderQueueUPtr Create(StreamBufferPtr instanceStream);
+
+    struct Stats
+    {
+        uint32_t itemCount { 0 };
+        uint32_t drawCount { 0 };
+        uint32_t instancedDrawCount { 0 };
+        uint32_t programChanges { 0 };
+        uint32_t materialChanges { 0 };
+        uint32_t triangleCount { 0 };
+    };
+
+    void Clear();
+    // depth 는 view 방향 거리를 [0, 1] 로 정규화한 값
+    // mesh 가 material 을 가지고 있으면 Mesh::Draw 처럼 material 인자 대신 그것을 쓴다
+    void Add(RenderPass pass, const Program* program, const Program* instancedProgram,
+        const Mesh* mesh, const Material* material, const glm::mat4& transform, float depth, uint32_t lod = 0);
+    // 정렬하고 instancing batch 를 만들어 instance buffer 에 올린다
+    void Sort();
+    // pass 에 맞는 depth / blend state 를 설정하고 정렬된 순서대로 그린다
+    void Execute(RenderPass pass);
+
+    size_t GetItemCount() const { return m_items.size(); }
+    const Stats& GetStats(RenderPass pass) const { return m_stats[pass]; }
+
+private:
+    RenderQueue() {}
+
+    struct SortEntry
+    {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    // 정렬된 m_entries 의 연속 구간. instanceCount 가 1 이면 instancing 하지 않는다
+    struct Batch
+    {
+        uint32_t firstEntry;
+        uint32_t instanceCount;
+        uint32_t instanceOffset;
+    };
+
+    static uint32_t GetSlot(std::unordered_map<const void*, uint32_t>& slots, const void* object, uint32_t limit);
+    void RadixSort();
+    void BuildBatches();
+    void UploadInstances();
+    const VertexLayout* GetInstanceLayout(const Mesh* mesh);
+
+    std::vector<DrawItem> m_items;
+    std::vector<SortEntry> m_entries;
+    std::vector<SortEntry> m_sortBuffer;
+    bool m_sorted { false };
+
+    std::vector<Batch> m_batches;
+    // pass 별 m_batches 구간 [begin, end)
+    uint32_t m_passBatches[RENDER_PASS_COUNT + 1] {};
+    std::vector<glm::mat4> m_instanceTransforms;
+    StreamBufferPtr m_instanceStream;
+    // 공간이 모자라 할당에 실패하면 batch 를 하나씩 그린다
+    StreamBuffer::Allocation m_instanceAllocation;
+    // mesh 의 buffer 에 instance attribute 를 더한 VAO (grass 와 같은 방식)
+    // geometry pool 의 mesh 들은 buffer 가 같으므로 mesh 의 VAO 를 key 로 하나를 같이 쓴다
+    std::unordered_map<const VertexLayout*, VertexLayoutUPtr> m_instanceLayouts;
+
+    // key 에 넣을 작은 번호. frame 마다 처음 나온 순서대로 매긴다
+    std::unordered_map<const void*, uint32_t> m_programSlots;
+    std::unordered_map<const void*, uint32_t> m_materialSlots;
+    std::unordered_map<const void*, uint32_t> m_meshSlots;
+
+    Stats m_stats[RENDER_PASS_COUNT];
+};
+
+#endif // __RENDER_QUEUE_H__
\ No newline at end of file
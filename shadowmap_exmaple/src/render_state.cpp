@@ -0,0 +1,360 @@
+#include "render_state.h"
+
+RenderState& RenderState::Get()
+{
+    static RenderState renderState;
+    return renderState;
+}
+
+const char* RenderState::GetStateTypeName(StateType type)
+{
+    switch (type)
+    {
+        case STATE_PROGRAM: return "program";
+        case STATE_VERTEX_ARRAY: return "vertex array";
+        case STATE_BUFFER: return "buffer";
+        case STATE_TEXTURE: return "texture";
+        case STATE_SAMPLER: return "sampler";
+        case STATE_FRAMEBUFFER: return "framebuffer";
+        case STATE_VIEWPORT: return "viewport";
+        case STATE_FIXED_FUNCTION: return "fixed function";
+        default: return "unknown";
+    }
+}
+
+void RenderState::Invalidate()
+{
+    m_program = UNKNOWN;
+    m_vertexArray = UNKNOWN;
+    m_buffers.fill(UNKNOWN);
+    m_uniformBufferRanges.fill({ UNKNOWN, 0, 0 });
+    m_activeTexture = UNKNOWN;
+    for (auto& unit : m_textures)
+        unit.fill(UNKNOWN);
+    m_samplers.fill(UNKNOWN);
+    m_drawFramebuffer = UNKNOWN;
+    m_readFramebuffer = UNKNOWN;
+    m_viewportValid = false;
+
+    m_depthTest = UNKNOWN;
+    m_depthWrite = UNKNOWN;
+    m_depthFunc = UNKNOWN;
+    m_blend = UNKNOWN;
+    m_blendSrc = UNKNOWN;
+    m_blendDst = UNKNOWN;
+    m_blendEquation = UNKNOWN;
+    m_colorWrite = UNKNOWN;
+    m_stencilTest = UNKNOWN;
+    m_stencilFunc = UNKNOWN;
+    m_stencilRef = UNKNOWN;
+    m_stencilReadMask = UNKNOWN;
+    m_stencilWriteMask = UNKNOWN;
+    m_stencilFail = UNKNOWN;
+    m_stencilDepthFail = UNKNOWN;
+    m_stencilDepthPass = UNKNOWN;
+    m_cullFace = UNKNOWN;
+    m_cullMode = UNKNOWN;
+    m_frontFace = UNKNOWN;
+}
+
+bool RenderState::Changed(uint32_t& cached, uint32_t value, StateType type)
+{
+    if (cached == value)
+    {
+        ++m_stats.skipped[type];
+        return false;
+    }
+    cached = value;
+    ++m_stats.issued[type];
+    return true;
+}
+
+void RenderState::SetCapability(uint32_t capability, uint32_t& cached, bool enable)
+{
+    if (!Changed(cached, enable ? 1 : 0, STATE_FIXED_FUNCTION))
+        return;
+    if (enable)
+        glEnable(capability);
+    else
+        glDisable(capability);
+}
+
+int RenderState::GetBufferTargetIndex(uint32_t target)
+{
+    switch (target)
+    {
+        case GL_ARRAY_BUFFER: return BUFFER_ARRAY;
+        case GL_ELEMENT_ARRAY_BUFFER: return BUFFER_ELEMENT_ARRAY;
+        case GL_UNIFORM_BUFFER: return BUFFER_UNIFORM;
+        case GL_COPY_READ_BUFFER: return BUFFER_COPY_READ;
+        case GL_COPY_WRITE_BUFFER: return BUFFER_COPY_WRITE;
+        case GL_PIXEL_PACK_BUFFER: return BUFFER_PIXEL_PACK;
+        case GL_PIXEL_UNPACK_BUFFER: return BUFFER_PIXEL_UNPACK;
+        case GL_TRANSFORM_FEEDBACK_BUFFER: return BUFFER_TRANSFORM_FEEDBACK;
+        case GL_DRAW_INDIRECT_BUFFER: return BUFFER_DRAW_INDIRECT;
+        default: return -1;
+    }
+}
+
+int RenderState::GetTextureTargetIndex(uint32_t target)
+{
+    switch (target)
+    {
+        case GL_TEXTURE_2D: return TEXTURE_2D;
+        case GL_TEXTURE_CUBE_MAP: return TEXTURE_CUBE_MAP;
+        default: return -1;
+    }
+}
+
+void RenderState::UseProgram(uint32_t program)
+{
+    if (Changed(m_program, program, STATE_PROGRAM))
+        glUseProgram(program);
+}
+
+void RenderState::BindVertexArray(uint32_t vertexArray)
+{
+    if (!Changed(m_vertexArray, vertexArray, STATE_VERTEX_ARRAY))
+        return;
+    glBindVertexArray(vertexArray);
+    // element array buffer binding 은 VAO 에 속한 state
+    m_buffers[BUFFER_ELEMENT_ARRAY] = UNKNOWN;
+}
+
+void RenderState::BindBuffer(uint32_t target, uint32_t buffer)
+{
+    int index = GetBufferTargetIndex(target);
+    if (index < 0)
+    {
+        ++m_stats.issued[STATE_BUFFER];
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if (Changed(m_buffers[index], buffer, STATE_BUFFER))
+        glBindBuffer(target, buffer);
+}
+
+void RenderState::BindBufferRange(uint32_t target, uint32_t index, uint32_t buffer, size_t offset, size_t size)
+{
+    if (target == GL_UNIFORM_BUFFER && index < MAX_UNIFORM_BUFFER_BINDINGS)
+    {
+        auto& range = m_uniformBufferRanges[index];
+        if (range.buffer == buffer && range.offset == offset && range.size == size)
+        {
+            ++m_stats.skipped[STATE_BUFFER];
+            return;
+        }
+        range = { buffer, offset, size };
+    }
+    ++m_stats.issued[STATE_BUFFER];
+
+    // size 0 은 buffer 전체
+    if (size == 0)
+        glBindBufferBase(target, index, buffer);
+    else
+        glBindBufferRange(target, index, buffer, offset, size);
+
+    // indexed binding 은 generic binding point 도 바꾼다
+    int targetIndex = GetBufferTargetIndex(target);
+    if (targetIndex >= 0)
+        m_buffers[targetIndex] = buffer;
+}
+
+void RenderState::ActiveTexture(uint32_t unit)
+{
+    if (Changed(m_activeTexture, unit, STATE_TEXTURE))
+        glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void RenderState::BindTexture(uint32_t target, uint32_t texture)
+{
+    if (m_activeTexture == UNKNOWN)
+        ActiveTexture(0);
+    BindTexture(m_activeTexture, target, texture);
+}
+
+void RenderState::BindTexture(uint32_t unit, uint32_t target, uint32_t texture)
+{
+    int index = GetTextureTargetIndex(target);
+    if (unit < MAX_TEXTURE_UNITS && index >= 0)
+    {
+        // 이미 bind 되어 있으면 active unit 도 바꿀 필요가 없다
+        if (m_textures[unit][index] == texture)
+        {
+            ++m_stats.skipped[STATE_TEXTURE];
+            return;
+        }
+        m_textures[unit][index] = texture;
+    }
+    ActiveTexture(unit);
+    ++m_stats.issued[STATE_TEXTURE];
+    glBindTexture(target, texture);
+}
+
+void RenderState::BindSampler(uint32_t unit, uint32_t sampler)
+{
+    // glBindSampler 는 unit 을 직접 받으므로 active unit 을 바꾸지 않는다
+    if (unit >= MAX_TEXTURE_UNITS || Changed(m_samplers[unit], sampler, STATE_SAMPLER))
+        glBindSampler(unit, sampler);
+}
+
+void RenderState::BindFramebuffer(uint32_t target, uint32_t framebuffer)
+{
+    bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+    bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+    if ((!draw || m_drawFramebuffer == framebuffer) && (!read || m_readFramebuffer == framebuffer))
+    {
+        ++m_stats.skipped[STATE_FRAMEBUFFER];
+        return;
+    }
+    if (draw)
+        m_drawFramebuffer = framebuffer;
+    if (read)
+        m_readFramebuffer = framebuffer;
+    ++m_stats.issued[STATE_FRAMEBUFFER];
+    glBindFramebuffer(target, framebuffer);
+}
+
+void RenderState::SetViewport(int x, int y, int width, int height)
+{
+    std::array<int, 4> viewport = { x, y, width, height };
+    if (m_viewportValid && m_viewport == viewport)
+    {
+        ++m_stats.skipped[STATE_VIEWPORT];
+        return;
+    }
+    m_viewport = viewport;
+    m_viewportValid = true;
+    ++m_stats.issued[STATE_VIEWPORT];
+    glViewport(x, y, width, height);
+}
+
+void RenderState::SetDepthState(const DepthState& state)
+{
+    SetCapability(GL_DEPTH_TEST, m_depthTest, state.test);
+    if (Changed(m_depthWrite, state.write ? 1 : 0, STATE_FIXED_FUNCTION))
+        glDepthMask(state.write ? GL_TRUE : GL_FALSE);
+    if (Changed(m_depthFunc, state.func, STATE_FIXED_FUNCTION))
+        glDepthFunc(state.func);
+}
+
+void RenderState::SetBlendState(const BlendState& state)
+{
+    // color mask 는 glClear 에도 적용된다
+    if (Changed(m_colorWrite, state.colorWrite ? 1 : 0, STATE_FIXED_FUNCTION))
+    {
+        GLboolean write = state.colorWrite ? GL_TRUE : GL_FALSE;
+        glColorMask(write, write, write, write);
+    }
+    SetCapability(GL_BLEND, m_blend, state.enable);
+    if (!state.enable)
+        return;
+
+    if (m_blendSrc != state.srcFactor || m_blendDst != state.dstFactor)
+    {
+        m_blendSrc = state.srcFactor;
+        m_blendDst = state.dstFactor;
+        ++m_stats.issued[STATE_FIXED_FUNCTION];
+        glBlendFunc(state.srcFactor, state.dstFactor);
+    }
+    else
+    {
+        ++m_stats.skipped[STATE_FIXED_FUNCTION];
+    }
+    if (Changed(m_blendEquation, state.equation, STATE_FIXED_FUNCTION))
+        glBlendEquation(state.equation);
+}
+
+void RenderState::SetStencilState(const StencilState& state)
+{
+    SetCapability(GL_STENCIL_TEST, m_stencilTest, state.enable);
+    // glStencilMask 는 stencil test 와 상관없이 glClear 에도 적용된다
+    if (Changed(m_stencilWriteMask, state.writeMask, STATE_FIXED_FUNCTION))
+        glStencilMask(state.writeMask);
+    if (!state.enable)
+        return;
+
+    if (m_stencilFunc != state.func || m_stencilRef != (uint32_t)state.ref || m_stencilReadMask != state.readMask)
+    {
+        m_stencilFunc = state.func;
+        m_stencilRef = (uint32_t)state.ref;
+        m_stencilReadMask = state.readMask;
+        ++m_stats.issued[STATE_FIXED_FUNCTION];
+        glStencilFunc(state.func, state.ref, state.readMask);
+    }
+    else
+    {
+        ++m_stats.skipped[STATE_FIXED_FUNCTION];
+    }
+
+    if (m_stencilFail != state.stencilFail || m_stencilDepthFail != state.depthFail || m_stencilDepthPass != state.depthPass)
+    {
+        m_stencilFail = state.stencilFail;
+        m_stencilDepthFail = state.depthFail;
+        m_stencilDepthPass = state.depthPass;
+        ++m_stats.issued[STATE_FIXED_FUNCTION];
+        glStencilOp(state.stencilFail, state.depthFail, state.depthPass);
+    }
+    else
+    {
+        ++m_stats.skipped[STATE_FIXED_FUNCTION];
+    }
+}
+
+void RenderState::SetRasterState(const RasterState& state)
+{
+    SetCapability(GL_CULL_FACE, m_cullFace, state.cullFace);
+    if (state.cullFace && Changed(m_cullMode, state.cullMode, STATE_FIXED_FUNCTION))
+        glCullFace(state.cullMode);
+    if (Changed(m_frontFace, state.frontFace, STATE_FIXED_FUNCTION))
+        glFrontFace(state.frontFace);
+}
+
+void RenderState::OnDeleteProgram(uint32_t program)
+{
+    if (m_program == program)
+        m_program = UNKNOWN;
+}
+
+void RenderState::OnDeleteVertexArray(uint32_t vertexArray)
+{
+    if (m_vertexArray == vertexArray)
+    {
+        m_vertexArray = UNKNOWN;
+        m_buffers[BUFFER_ELEMENT_ARRAY] = UNKNOWN;
+    }
+}
+
+void RenderState::OnDeleteBuffer(uint32_t buffer)
+{
+    for (auto& binding : m_buffers)
+    {
+        if (binding == buffer)
+            binding = UNKNOWN;
+    }
+    for (auto& range : m_uniformBufferRanges)
+    {
+        if (range.buffer == buffer)
+            range.buffer = UNKNOWN;
+    }
+}
+
+void RenderState::OnDeleteTexture(uint32_t texture)
+{
+    for (auto& unit : m_textures)
+    {
+        for (auto& binding : unit)
+        {
+            if (binding == texture)
+                binding = UNKNOWN;
+        }
+    }
+}
+
+void RenderState::OnDeleteFramebuffer(uint32_t framebuffer)
+{
+    if (m_drawFramebuffer == framebuffer)
+        m_drawFramebuffer = UNKNOWN;
+    if (m_readFramebuffer == framebuffer)
+        m_readFramebuffer = UNKNOWN;
+}
\ No newline at end of file
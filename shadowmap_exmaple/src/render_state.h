@@ -0,0 +1,178 @@
+#ifndef __RENDER_STATE_H__
+#define __RENDER_STATE_H__
+
+#include "common.h"
+#include <array>
+
+// 고정 기능 state 묶음. RenderState 에 통째로 넘기면 바뀐 항목만 GL 에 반영된다
+struct DepthState
+{
+    bool test { true };
+    bool write { true };
+    uint32_t func { GL_LESS };
+};
+
+struct BlendState
+{
+    bool enable { false };
+    uint32_t srcFactor { GL_ONE };
+    uint32_t dstFactor { GL_ZERO };
+    uint32_t equation { GL_FUNC_ADD };
+    // false 면 color buffer 에 쓰지 않는다 (depth 만 쓰거나 occlusion query 용)
+    bool colorWrite { true };
+};
+
+struct StencilState
+{
+    bool enable { false };
+    uint32_t func { GL_ALWAYS };
+    int ref { 0 };
+    uint32_t readMask { 0xff };
+    uint32_t writeMask { 0xff };
+    uint32_t stencilFail { GL_KEEP };
+    uint32_t depthFail { GL_KEEP };
+    uint32_t depthPass { GL_KEEP };
+};
+
+struct RasterState
+{
+    bool cullFace { false };
+    uint32_t cullMode { GL_BACK };
+    uint32_t frontFace { GL_CCW };
+};
+
+// 현재 bind 된 GL object 와 고정 기능 state 를 기억해 두고
+// 이미 같은 값이면 GL 호출을 생략한다
+// GL 을 직접 건드리는 코드(ImGui 등)가 지나간 뒤에는 Invalidate() 를 호출해야 함
+class RenderState
+{
+public:
+    static RenderState& Get();
+
+    enum StateType
+    {
+        STATE_PROGRAM,
+        STATE_VERTEX_ARRAY,
+        STATE_BUFFER,
+        STATE_TEXTURE,
+        STATE_SAMPLER,
+        STATE_FRAMEBUFFER,
+        STATE_VIEWPORT,
+        STATE_FIXED_FUNCTION,
+        STATE_TYPE_COUNT,
+    };
+
+    struct Stats
+    {
+        std::array<uint32_t, STATE_TYPE_COUNT> issued {};
+        std::array<uint32_t, STATE_TYPE_COUNT> skipped {};
+    };
+
+    static const char* GetStateTypeName(StateType type);
+
+    void Invalidate();
+    const Stats& GetStats() const { return m_stats; }
+    void ResetStats() { m_stats = Stats(); }
+
+    void UseProgram(uint32_t program);
+    void BindVertexArray(uint32_t vertexArray);
+    void BindBuffer(uint32_t target, uint32_t buffer);
+    void BindBufferRange(uint32_t target, uint32_t index, uint32_t buffer, size_t offset, size_t size);
+    void ActiveTexture(uint32_t unit);
+    // 현재 active unit 에 bind
+    void BindTexture(uint32_t target, uint32_t texture);
+    void BindTexture(uint32_t unit, uint32_t target, uint32_t texture);
+    // unit 에 bind 된 sampler 는 그 unit 의 texture 가 가진 filter / wrap 설정보다 우선한다
+    void BindSampler(uint32_t unit, uint32_t sampler);
+    void BindFramebuffer(uint32_t target, uint32_t framebuffer);
+    void SetViewport(int x, int y, int width, int height);
+
+    void SetDepthState(const DepthState& state);
+    void SetBlendState(const BlendState& state);
+    void SetStencilState(const StencilState& state);
+    void SetRasterState(const RasterState& state);
+
+    // 삭제된 object 의 이름은 재사용될 수 있으므로 cache 에서 지운다
+    void OnDeleteProgram(uint32_t program);
+    void OnDeleteVertexArray(uint32_t vertexArray);
+    void OnDeleteBuffer(uint32_t buffer);
+    void OnDeleteTexture(uint32_t texture);
+    void OnDeleteFramebuffer(uint32_t framebuffer);
+
+private:
+    RenderState() { Invalidate(); }
+
+    // 알 수 없는 상태. 어떤 GL 값과도 같지 않다
+    static const uint32_t UNKNOWN = 0xffffffff;
+    static const int MAX_TEXTURE_UNITS = 16;
+    static const int MAX_UNIFORM_BUFFER_BINDINGS = 16;
+
+    enum BufferTarget
+    {
+        BUFFER_ARRAY,
+        BUFFER_ELEMENT_ARRAY,
+        BUFFER_UNIFORM,
+        BUFFER_COPY_READ,
+        BUFFER_COPY_WRITE,
+        BUFFER_PIXEL_PACK,
+        BUFFER_PIXEL_UNPACK,
+        BUFFER_TRANSFORM_FEEDBACK,
+        BUFFER_DRAW_INDIRECT,
+        BUFFER_TARGET_COUNT,
+    };
+    static int GetBufferTargetIndex(uint32_t target);
+
+    enum TextureTarget
+    {
+        TEXTURE_2D,
+        TEXTURE_CUBE_MAP,
+        TEXTURE_TARGET_COUNT,
+    };
+    static int GetTextureTargetIndex(uint32_t target);
+
+    bool Changed(uint32_t& cached, uint32_t value, StateType type);
+    void SetCapability(uint32_t capability, uint32_t& cached, bool enable);
+
+    struct BufferRange
+    {
+        uint32_t buffer;
+        size_t offset;
+        size_t size;
+    };
+
+    uint32_t m_program;
+    uint32_t m_vertexArray;
+    std::array<uint32_t, BUFFER_TARGET_COUNT> m_buffers;
+    std::array<BufferRange, MAX_UNIFORM_BUFFER_BINDINGS> m_uniformBufferRanges;
+    uint32_t m_activeTexture;
+    std::array<std::array<uint32_t, TEXTURE_TARGET_COUNT>, MAX_TEXTURE_UNITS> m_textures;
+    std::array<uint32_t, MAX_TEXTURE_UNITS> m_samplers;
+    uint32_t m_drawFramebuffer;
+    uint32_t m_readFramebuffer;
+    std::array<int, 4> m_viewport;
+    bool m_viewportValid;
+
+    uint32_t m_depthTest;
+    uint32_t m_depthWrite;
+    uint32_t m_depthFunc;
+    uint32_t m_blend;
+    uint32_t m_blendSrc;
+    uint32_t m_blendDst;
+    uint32_t m_blendEquation;
+    uint32_t m_colorWrite;
+    uint32_t m_stencilTest;
+    uint32_t m_stencilFunc;
+    uint32_t m_stencilRef;
+    uint32_t m_stencilReadMask;
+    uint32_t m_stencilWriteMask;
+    uint32_t m_stencilFail;
+    uint32_t m_stencilDepthFail;
+    uint32_t m_stencilDepthPass;
+    uint32_t m_cullFace;
+    uint32_t m_cullMode;
+    uint32_t m_frontFace;
+
+    Stats m_stats;
+};
+
+#endif // __RENDER_STATE_H__
\ No newline at end of file
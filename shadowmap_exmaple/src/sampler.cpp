@@ -0,0 +1,82 @@
+#include "sampler.h"
+#include <algorithm>
+
+SamplerState SamplerState::Nearest(uint32_t wrap)
+{
+    SamplerState state;
+    state.minFilter = GL_NEAREST;
+    state.magFilter = GL_NEAREST;
+    state.wrapS = state.wrapT = state.wrapR = wrap;
+    return state;
+}
+
+SamplerState SamplerState::Linear(uint32_t wrap)
+{
+    SamplerState state;
+    state.wrapS = state.wrapT = state.wrapR = wrap;
+    return state;
+}
+
+SamplerState SamplerState::Trilinear(uint32_t wrap)
+{
+    SamplerState state = Linear(wrap);
+    state.minFilter = GL_LINEAR_MIPMAP_LINEAR;
+    return state;
+}
+
+SamplerState SamplerState::Anisotropic(float maxAnisotropy, uint32_t wrap)
+{
+    SamplerState state = Trilinear(wrap);
+    state.maxAnisotropy = maxAnisotropy;
+    return state;
+}
+
+bool SamplerState::operator==(const SamplerState& other) const
+{
+    return minFilter == other.minFilter && magFilter == other.magFilter &&
+        wrapS == other.wrapS && wrapT == other.wrapT && wrapR == other.wrapR &&
+        maxAnisotropy == other.maxAnisotropy && borderColor == other.borderColor;
+}
+
+SamplerCache& SamplerCache::Get()
+{
+    static SamplerCache cache;
+    return cache;
+}
+
+float SamplerCache::GetMaxAnisotropy()
+{
+    if (m_maxAnisotropy == 0.0f)
+    {
+        m_maxAnisotropy = 1.0f;
+        if (GLAD_GL_VERSION_4_6 || GLAD_GL_ARB_texture_filter_anisotropic || GLAD_GL_EXT_texture_filter_anisotropic)
+            glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &m_maxAnisotropy);
+    }
+    return m_maxAnisotropy;
+}
+
+uint32_t SamplerCache::GetSampler(const SamplerState& state)
+{
+    // 지원 범위로 자른 뒤에 찾아야 16x 와 8x 를 요청해도 하드웨어 최대가 8x 면 하나로 모인다
+    SamplerState clamped = state;
+    clamped.maxAnisotropy = std::clamp(state.maxAnisotropy, 1.0f, GetMaxAnisotropy());
+    for (const auto& entry : m_samplers)
+    {
+        if (entry.first == clamped)
+            return entry.second;
+    }
+
+    uint32_t sampler = 0;
+    glGenSamplers(1, &sampler);
+    glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, clamped.minFilter);
+    glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, clamped.magFilter);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, clamped.wrapS);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, clamped.wrapT);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_R, clamped.wrapR);
+    glSamplerParameterfv(sampler, GL_TEXTURE_BORDER_COLOR, glm::value_ptr(clamped.borderColor));
+    if (clamped.maxAnisotropy > 1.0f)
+        glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, clamped.maxAnisotropy);
+
+    m_samplers.push_back({ clamped, sampler });
+    return sampler;
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef __SAMPLER_H__
+#define __SAMPLER_H__
+
+#include "common.h"
+#include <vector>
+
+// texture 를 읽는 방법. texture object 가 아니라 texture unit 에 bind 되는 sampler object 로 만든다
+struct SamplerState
+{
+    uint32_t minFilter { GL_LINEAR };
+    uint32_t magFilter { GL_LINEAR };
+    uint32_t wrapS { GL_CLAMP_TO_EDGE };
+    uint32_t wrapT { GL_CLAMP_TO_EDGE };
+    uint32_t wrapR { GL_CLAMP_TO_EDGE };
+    // 1 이면 끈다. 지원하는 최대값보다 크면 잘린다
+    float maxAnisotropy { 1.0f };
+    glm::vec4 borderColor { 0.0f };
+
+    // mip 을 쓰지 않는 render target 등
+    static SamplerState Nearest(uint32_t wrap = GL_CLAMP_TO_EDGE);
+    static SamplerState Linear(uint32_t wrap = GL_CLAMP_TO_EDGE);
+    static SamplerState Trilinear(uint32_t wrap = GL_CLAMP_TO_EDGE);
+    // 비스듬히 보이는 바닥 같은 면이 흐려지지 않게 한다. mip 이 있는 file texture 의 기본값
+    static SamplerState Anisotropic(float maxAnisotropy = 8.0f, uint32_t wrap = GL_CLAMP_TO_EDGE);
+
+    bool operator==(const SamplerState& other) const;
+};
+
+// 같은 SamplerState 는 sampler object 하나를 같이 쓴다
+// 종류가 몇 개 안 되므로 지우지 않고 GL context 가 없어질 때 같이 없어지게 둔다
+// GL thread 에서만 쓴다
+class SamplerCache
+{
+public:
+    static SamplerCache& Get();
+
+    uint32_t GetSampler(const SamplerState& state);
+    size_t GetSamplerCount() const { return m_samplers.size(); }
+    // anisotropic filtering 을 지원하지 않으면 1
+    float GetMaxAnisotropy();
+
+private:
+    SamplerCache() {}
+
+    // 몇 개 안 되므로 순서대로 찾는다
+    std::vector<std::pair<SamplerState, uint32_t>> m_samplers;
+    float m_maxAnisotropy { 0.0f };
+};
+
+#endif // __SAMPLER_H__
\ No newline at end of file
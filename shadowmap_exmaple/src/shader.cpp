@@ -1,35 +1,121 @@
 #include "shader.h"
+#include <sstream>
+#include <algorithm>
 
-ShaderUPtr Shader::CreateFromFile(const std::string& filename, GLenum shaderType)
+ShaderUPtr Shader::CreateFromFile(const std::string& filename, GLenum shaderType, const ShaderDefines& defines)
 {
-    std::string filepath = std::string(SHADER_PATH) + filename;
-    ShaderUPtr shader = ShaderUPtr(new Shader());
-    if (!shader->LoadFile(filepath, shaderType))
+    auto code = LoadSource(filename, defines);
+    if (!code.has_value())
+        return nullptr;
+    return CreateFromSource(code.value(), shaderType, filename);
+}
+
+ShaderUPtr Shader::CreateFromSource(const std::string& code, GLenum shaderType, const std::string& name)
+{
+    ShaderUPtr shader = SubmitFromSource(code, shaderType, name);
+    if (!shader->CheckCompileStatus())
         return nullptr;
     return std::move(shader);
 }
 
-bool Shader::LoadFile(const std::string &filename, GLenum shaderType)
+ShaderUPtr Shader::SubmitFromSource(const std::string& code, GLenum shaderType, const std::string& name)
+{
+    ShaderUPtr shader = ShaderUPtr(new Shader());
+    shader->Submit(code, shaderType, name);
+    return std::move(shader);
+}
+
+std::optional<std::string> Shader::LoadSource(const std::string& filename, const ShaderDefines& defines)
+{
+    std::unordered_set<std::string> included;
+    std::string code;
+    if (!ExpandIncludes(filename, included, code))
+        return {};
+
+    std::string defineBlock;
+    for (const auto& define : defines)
+    {
+        defineBlock += fmt::format("#define {} {}\n", define.first, define.second);
+    }
+
+    // #version 은 반드시 첫 줄에 와야 하므로 그 뒤에 define 을 넣는다
+    auto versionPos = code.find("#version");
+    if (versionPos == std::string::npos)
+        return defineBlock + code;
+
+    auto lineEnd = code.find('\n', versionPos);
+    if (lineEnd == std::string::npos)
+        return code + "\n" + defineBlock;
+
+    auto versionLine = std::count(code.begin(), code.begin() + lineEnd, '\n') + 1;
+    return code.substr(0, lineEnd + 1) + defineBlock +
+        fmt::format("#line {}\n", versionLine + 1) + code.substr(lineEnd + 1);
+}
+
+bool Shader::ExpandIncludes(const std::string& filename,
+    std::unordered_set<std::string>& included, std::string& output)
 {
-    auto result = LoadTextFile(filename);
+    // 같은 파일은 한번만 포함 (#pragma once 와 같은 동작)
+    if (!included.insert(filename).second)
+        return true;
+
+    auto result = LoadTextFile(std::string(SHADER_PATH) + filename);
     if (!result.has_value())
         return false;
 
-    auto& code = result.value();
+    std::istringstream lines(result.value());
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(lines, line))
+    {
+        ++lineNumber;
+        auto directive = line.find_first_not_of(" \t");
+        if (directive == std::string::npos || line.compare(directive, 8, "#include") != 0)
+        {
+            output += line + "\n";
+            continue;
+        }
+
+        auto nameBegin = line.find('"', directive);
+        auto nameEnd = nameBegin == std::string::npos ? nameBegin : line.find('"', nameBegin + 1);
+        if (nameEnd == std::string::npos)
+        {
+            SPDLOG_ERROR("invalid #include in {}({}): {}", filename, lineNumber, line);
+            return false;
+        }
+
+        auto includeName = "/" + line.substr(nameBegin + 1, nameEnd - nameBegin - 1);
+        output += "#line 1\n";
+        if (!ExpandIncludes(includeName, included, output))
+        {
+            SPDLOG_ERROR("failed to include {} from {}({})", includeName, filename, lineNumber);
+            return false;
+        }
+        output += fmt::format("#line {}\n", lineNumber + 1);
+    }
+    return true;
+}
+
+void Shader::Submit(const std::string& code, GLenum shaderType, const std::string& name)
+{
     const char* codePtr = code.c_str();
     int32_t codeLength = (int32_t)code.length();
     
+    m_name = name;
     m_shader = glCreateShader(shaderType);
     glShaderSource(m_shader, 1, &codePtr, &codeLength);
     glCompileShader(m_shader);
+}
 
+bool Shader::CheckCompileStatus() const
+{
     int sucess = 0;
     glGetShaderiv(m_shader, GL_COMPILE_STATUS, &sucess);
     if (!sucess)
     {
         char infoLog[512];
         glGetShaderInfoLog(m_shader, 512, nullptr, infoLog);
-        SPDLOG_ERROR("Failed to compile shader: \"{}\"", filename);
+        SPDLOG_ERROR("Failed to compile shader: \"{}\"", m_name);
         SPDLOG_ERROR("reason: {}", infoLog);
         return false;
     }
@@ -2,19 +2,32 @@
 #define __SHADER_H__
 
 #include "common.h"
+#include <unordered_set>
+
+// shader source 앞에 주입할 #define 목록 (이름, 값)
+using ShaderDefines = std::vector<std::pair<std::string, std::string>>;
 
 CLASS_PTR(Shader);
 class Shader
 {
 public:
-    static ShaderUPtr CreateFromFile(const std::string& filename, GLenum shaderType);
+    static ShaderUPtr CreateFromFile(const std::string& filename, GLenum shaderType, const ShaderDefines& defines = {});
+    static ShaderUPtr CreateFromSource(const std::string& code, GLenum shaderType, const std::string& name);
+    // compile 만 제출하고 결과 확인은 CheckCompileStatus() 로 미룬다
+    static ShaderUPtr SubmitFromSource(const std::string& code, GLenum shaderType, const std::string& name);
+    // #include 를 펼치고 #version 바로 뒤에 define 을 넣은 source 를 돌려준다
+    static std::optional<std::string> LoadSource(const std::string& filename, const ShaderDefines& defines = {});
     ~Shader();    
     uint32_t Get() const { return m_shader; }
+    bool CheckCompileStatus() const;
     
 private:
     Shader() {}
-    bool LoadFile(const std::string& filename, GLenum shaderType);
+    static bool ExpandIncludes(const std::string& filename,
+        std::unordered_set<std::string>& included, std::string& output);
+    void Submit(const std::string& code, GLenum shaderType, const std::string& name);
     uint32_t m_shader { 0 };
+    std::string m_name;
 };
 
 #endif // __SHADER_H__
\ No newline at end of file
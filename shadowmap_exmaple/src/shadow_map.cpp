@@ -1,4 +1,5 @@
 #include "shadow_map.h"
+#include "render_state.h"
 
 ShadowMapUPtr ShadowMap::Create(int width, int height)
 {
@@ -14,6 +15,7 @@ ShadowMap::~ShadowMap()
 {
     if (m_framebuffer)
     {
+        RenderState::Get().OnDeleteFramebuffer(m_framebuffer);
         glDeleteFramebuffers(1, &m_framebuffer);
     }
 }
@@ -24,9 +26,10 @@ bool ShadowMap::Init(int width, int height)
     Bind();
 
     m_shadowMap = Texture::Create(width, height, GL_DEPTH_COMPONENT, GL_FLOAT);
-    m_shadowMap->SetFilter(GL_NEAREST, GL_NEAREST);
-    m_shadowMap->SetWrap(GL_CLAMP_TO_BORDER, GL_CLAMP_TO_BORDER);
-    m_shadowMap->SetBorderColor(glm::vec4(1.0f));
+    // 영역 밖은 가장 먼 depth 로 읽혀서 그림자가 생기지 않는다
+    auto samplerState = SamplerState::Nearest(GL_CLAMP_TO_BORDER);
+    samplerState.borderColor = glm::vec4(1.0f);
+    m_shadowMap->SetSampler(samplerState);
 
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_shadowMap->Get(), 0);
     glDrawBuffer(GL_NONE);
@@ -36,15 +39,15 @@ bool ShadowMap::Init(int width, int height)
     if (status != GL_FRAMEBUFFER_COMPLETE)
     {
         SPDLOG_ERROR("Failed to complete shadow map!: {:x}", status);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        RenderState::Get().BindFramebuffer(GL_FRAMEBUFFER, 0);
         return false;
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    RenderState::Get().BindFramebuffer(GL_FRAMEBUFFER, 0);
     return true;
 }
 
 void ShadowMap::Bind() const
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    RenderState::Get().BindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
 }
\ No newline at end of file
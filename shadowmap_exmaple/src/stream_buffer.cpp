@@ -0,0 +1,176 @@
+#include "stream_buffer.h"
+#include "render_state.h"
+
+StreamBufferUPtr StreamBuffer::Create(uint32_t bufferType, size_t frameSize, uint32_t frameCount)
+{
+    auto buffer = StreamBufferUPtr(new StreamBuffer());
+    if (!buffer->Init(bufferType, frameSize, frameCount))
+        return nullptr;
+    return std::move(buffer);
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    for (auto fence : m_fences)
+    {
+        if (fence)
+            glDeleteSync(fence);
+    }
+    if (m_buffer)
+    {
+        if (m_mapped)
+        {
+            Bind();
+            glUnmapBuffer(m_bufferType);
+        }
+        RenderState::Get().OnDeleteBuffer(m_buffer);
+        glDeleteBuffers(1, &m_buffer);
+    }
+}
+
+bool StreamBuffer::Init(uint32_t bufferType, size_t frameSize, uint32_t frameCount)
+{
+    if (frameSize == 0 || frameCount == 0)
+    {
+        SPDLOG_ERROR("invalid stream buffer size: {} x {}", frameSize, frameCount);
+        return false;
+    }
+
+    m_bufferType = bufferType;
+    m_frameSize = frameSize;
+    m_frameCount = frameCount;
+    glGenBuffers(1, &m_buffer);
+    Bind();
+
+    if (GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage)
+        m_persistent = InitPersistent();
+    if (!m_persistent)
+        InitOrphaning();
+
+    SPDLOG_INFO("stream buffer: {} KB x {}, {}", m_frameSize / 1024, m_frameCount,
+        m_persistent ? "persistent mapping" : "orphaning");
+    return true;
+}
+
+bool StreamBuffer::InitPersistent()
+{
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    size_t totalSize = m_frameSize * m_frameCount;
+    glBufferStorage(m_bufferType, totalSize, nullptr, flags);
+    m_mapped = (uint8_t*)glMapBufferRange(m_bufferType, 0, totalSize, flags);
+    if (!m_mapped)
+    {
+        // storage 는 immutable 이라 다시 만들어야 한다
+        SPDLOG_ERROR("failed to map persistent stream buffer, fallback to orphaning");
+        RenderState::Get().OnDeleteBuffer(m_buffer);
+        glDeleteBuffers(1, &m_buffer);
+        glGenBuffers(1, &m_buffer);
+        Bind();
+        return false;
+    }
+    m_fences.resize(m_frameCount, nullptr);
+    m_frameIndex = m_frameCount - 1;
+    return true;
+}
+
+void StreamBuffer::InitOrphaning()
+{
+    // orphaning 하면 driver 가 알아서 새 storage 를 주므로 구간은 하나면 된다
+    m_frameCount = 1;
+    m_frameIndex = 0;
+    m_staging.resize(m_frameSize);
+    glBufferData(m_bufferType, m_frameSize, nullptr, GL_STREAM_DRAW);
+}
+
+void StreamBuffer::BeginFrame()
+{
+    if (m_persistent)
+    {
+        m_frameIndex = (m_frameIndex + 1) % m_frameCount;
+        m_frameBegin = m_frameIndex * m_frameSize;
+
+        // frameCount frame 전에 이 구간을 쓴 draw 가 끝날 때까지 기다린다
+        auto& fence = m_fences[m_frameIndex];
+        if (fence)
+        {
+            GLenum result = GL_TIMEOUT_EXPIRED;
+            while (result == GL_TIMEOUT_EXPIRED)
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            if (result == GL_WAIT_FAILED)
+                SPDLOG_ERROR("failed to wait stream buffer fence");
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    else
+    {
+        Bind();
+        glBufferData(m_bufferType, m_frameSize, nullptr, GL_STREAM_DRAW);
+        m_frameBegin = 0;
+    }
+
+    m_cursor = m_frameBegin;
+    m_flushed = m_frameBegin;
+}
+
+void StreamBuffer::EndFrame()
+{
+    Flush();
+    if (m_persistent)
+        m_fences[m_frameIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+StreamBuffer::Allocation StreamBuffer::Allocate(size_t size, size_t alignment)
+{
+    size_t offset = (m_cursor + alignment - 1) / alignment * alignment;
+    if (offset + size > m_frameBegin + m_frameSize)
+    {
+        if (!m_overflowReported)
+        {
+            SPDLOG_ERROR("stream buffer overflow: {} bytes requested, {} / {} used",
+                size, m_cursor - m_frameBegin, m_frameSize);
+            m_overflowReported = true;
+        }
+        return Allocation();
+    }
+    m_cursor = offset + size;
+
+    Allocation allocation;
+    allocation.offset = offset;
+    allocation.size = size;
+    allocation.data = m_persistent ? m_mapped + offset : m_staging.data() + offset;
+    return allocation;
+}
+
+void StreamBuffer::Flush()
+{
+    // persistent coherent 는 쓰는 즉시 GPU 에 보인다
+    if (m_persistent || m_cursor == m_flushed)
+        return;
+
+    // orphan 된 storage 에서 아직 아무도 안 쓴 구간이므로 동기화 없이 map
+    Bind();
+    size_t size = m_cursor - m_flushed;
+    void* dest = glMapBufferRange(m_bufferType, m_flushed, size,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (dest)
+    {
+        memcpy(dest, m_staging.data() + m_flushed, size);
+        glUnmapBuffer(m_bufferType);
+    }
+    else
+    {
+        glBufferSubData(m_bufferType, m_flushed, size, m_staging.data() + m_flushed);
+    }
+    m_flushed = m_cursor;
+}
+
+void StreamBuffer::Bind() const
+{
+    RenderState::Get().BindBuffer(m_bufferType, m_buffer);
+}
+
+void StreamBuffer::BindRange(uint32_t index, const Allocation& allocation) const
+{
+    RenderState::Get().BindBufferRange(m_bufferType, index, m_buffer, allocation.offset, allocation.size);
+}
\ No newline at end of file
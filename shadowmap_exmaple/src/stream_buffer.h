@@ -0,0 +1,79 @@
+#ifndef __STREAM_BUFFER_H__
+#define __STREAM_BUFFER_H__
+
+#include "common.h"
+#include <vector>
+#include <cstring>
+
+// frame 마다 새로 채우는 데이터 (uniform block, instance data, debug geometry 등) 용 ring buffer
+//
+// GL 4.4 / ARB_buffer_storage 가 있으면 frameCount 개의 구간을 persistent coherent 로 map 해두고
+// 구간마다 fence 로 GPU 가 다 읽었는지 확인한 뒤 다시 쓴다
+// 없으면 (GL 3.3) frame 시작에 buffer 를 orphan 하고, CPU 쪽 staging 에 쓴 내용을
+// Flush() 에서 glMapBufferRange(UNSYNCHRONIZED) 로 복사한다
+//
+// BeginFrame / Allocate / Flush / EndFrame 은 heap 할당을 하지 않는다
+CLASS_PTR(StreamBuffer)
+class StreamBuffer
+{
+public:
+    static StreamBufferUPtr Create(uint32_t bufferType, size_t frameSize, uint32_t frameCount = 3);
+    ~StreamBuffer();
+
+    struct Allocation
+    {
+        void* data { nullptr };
+        size_t offset { 0 };
+        size_t size { 0 };
+        bool IsValid() const { return data != nullptr; }
+    };
+
+    void BeginFrame();
+    void EndFrame();
+    // 이번 frame 구간에서 size 만큼 잘라준다. 공간이 모자라면 IsValid() 가 false
+    Allocation Allocate(size_t size, size_t alignment = 16);
+    template <typename T>
+    Allocation Push(const T* data, size_t count, size_t alignment = 16);
+    // 지금까지 Allocate 한 내용을 GPU 가 볼 수 있게 한다. draw 전에 호출
+    void Flush();
+
+    uint32_t Get() const { return m_buffer; }
+    bool IsPersistent() const { return m_persistent; }
+    size_t GetFrameSize() const { return m_frameSize; }
+    size_t GetUsedSize() const { return m_cursor - m_frameBegin; }
+    void Bind() const;
+    void BindRange(uint32_t index, const Allocation& allocation) const;
+
+private:
+    StreamBuffer() {}
+    bool Init(uint32_t bufferType, size_t frameSize, uint32_t frameCount);
+    bool InitPersistent();
+    void InitOrphaning();
+
+    uint32_t m_buffer { 0 };
+    uint32_t m_bufferType { 0 };
+    size_t m_frameSize { 0 };
+    uint32_t m_frameCount { 1 };
+    bool m_persistent { false };
+
+    uint8_t* m_mapped { nullptr };
+    std::vector<uint8_t> m_staging;
+    std::vector<GLsync> m_fences;
+
+    uint32_t m_frameIndex { 0 };
+    size_t m_frameBegin { 0 };
+    size_t m_cursor { 0 };
+    size_t m_flushed { 0 };
+    bool m_overflowReported { false };
+};
+
+template <typename T>
+StreamBuffer::Allocation StreamBuffer::Push(const T* data, size_t count, size_t alignment)
+{
+    auto allocation = Allocate(sizeof(T) * count, alignment);
+    if (allocation.IsValid())
+        memcpy(allocation.data, data, allocation.size);
+    return allocation;
+}
+
+#endif // __STREAM_BUFFER_H__
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include "texture.h"
+#include "render_state.h"
+#include <algorithm>
 
 TextureUPtr Texture::CreateFromImage(const Image* image)
 {
@@ -16,69 +18,278 @@ TextureUPtr Texture::Create(int width, int height, uint32_t format, uint32_t typ
     return std::move(texture);
 }
 
+TextureUPtr Texture::CreateFromCompressedImage(const CompressedImage* image)
+{
+    if (!IsFormatSupported(image->GetFormat()))
+    {
+        SPDLOG_ERROR("{} texture is not supported by this OpenGL context",
+            CompressedImage::GetFormatName(image->GetFormat()));
+        return nullptr;
+    }
+
+    auto texture = TextureUPtr(new Texture());
+    texture->CreateTexture();
+    texture->CreateTextureFromCompressedImage(image);
+    return std::move(texture);
+}
+
+bool Texture::IsFormatSupported(CompressedImage::Format format)
+{
+    switch (format)
+    {
+        case CompressedImage::Format::BC1:
+        case CompressedImage::Format::BC3:
+            return GLAD_GL_EXT_texture_compression_s3tc;
+        // RGTC 는 3.0 부터 core
+        case CompressedImage::Format::BC4:
+        case CompressedImage::Format::BC5:
+            return true;
+        case CompressedImage::Format::BC7:
+            return GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_texture_compression_bptc;
+        case CompressedImage::Format::ETC2_RGB:
+        case CompressedImage::Format::ETC2_RGBA:
+            return GLAD_GL_VERSION_4_3 || GLAD_GL_ARB_ES3_compatibility;
+    }
+    return false;
+}
+
+void Texture::AllocateStorage(uint32_t target, int levelCount, uint32_t internalFormat,
+    int width, int height, uint32_t format, uint32_t type)
+{
+    if (GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_texture_storage)
+    {
+        glTexStorage2D(target, levelCount, internalFormat, width, height);
+        return;
+    }
+
+    for (int level = 0; level < levelCount; ++level)
+    {
+        int levelWidth = std::max(width >> level, 1);
+        int levelHeight = std::max(height >> level, 1);
+        if (target == GL_TEXTURE_CUBE_MAP)
+        {
+            for (uint32_t face = 0; face < 6; ++face)
+            {
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, internalFormat,
+                    levelWidth, levelHeight, 0, format, type, nullptr);
+            }
+        }
+        else
+        {
+            glTexImage2D(target, level, internalFormat, levelWidth, levelHeight, 0, format, type, nullptr);
+        }
+    }
+    // 잡지 않은 level 이 있으면 mipmap filter 로 읽을 때 incomplete texture 가 된다
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+}
+
+int Texture::GetMipLevelCount(int width, int height)
+{
+    int levelCount = 1;
+    while ((std::max(width, height) >> levelCount) > 0)
+        ++levelCount;
+    return levelCount;
+}
+
 Texture::~Texture()
 {
     if (m_texture)
     {
+        RenderState::Get().OnDeleteTexture(m_texture);
         glDeleteTextures(1, &m_texture);
     }
 }
 
 void Texture::Bind() const
 {
-    glBindTexture(GL_TEXTURE_2D, m_texture);
+    RenderState::Get().BindTexture(GL_TEXTURE_2D, m_texture);
 }
 
-void Texture::SetFilter(uint32_t minFilter, uint32_t magFilter) const
+void Texture::Bind(uint32_t unit) const
 {
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
+    auto& renderState = RenderState::Get();
+    renderState.BindTexture(unit, GL_TEXTURE_2D, m_texture);
+    renderState.BindSampler(unit, m_sampler);
 }
 
-void Texture::SetWrap(uint32_t sWrap, uint32_t tWrap) const
+void Texture::SetSampler(const SamplerState& state)
 {
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, sWrap);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, tWrap);
-}
-
-void Texture::SetBorderColor(const glm::vec4& color) const
-{
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, glm::value_ptr(color));
+    m_samplerState = state;
+    m_sampler = SamplerCache::Get().GetSampler(state);
 }
 
 void Texture::CreateTexture()
 {
     glGenTextures(1, &m_texture);
-    
-    // bind and set default filter and wrap options
     Bind();
-    SetFilter(GL_LINEAR, GL_LINEAR);
-    //SetFilter(GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR);
-    SetWrap(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
 }
 
-void Texture::CreateTextureFromImage(const Image* image)
+uint32_t Texture::GetImageFormat(int channelCount)
+{
+    switch (channelCount)
+    {
+        default: return GL_RGBA;
+        case 1: return GL_RED;
+        case 2: return GL_RG;
+        case 3: return GL_RGB;
+    }
+}
+
+uint32_t Texture::GetCompressedFormat(CompressedImage::Format format)
+{
+    switch (format)
+    {
+        case CompressedImage::Format::BC1: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        case CompressedImage::Format::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case CompressedImage::Format::BC4: return GL_COMPRESSED_RED_RGTC1;
+        case CompressedImage::Format::BC5: return GL_COMPRESSED_RG_RGTC2;
+        case CompressedImage::Format::BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        case CompressedImage::Format::ETC2_RGB: return GL_COMPRESSED_RGB8_ETC2;
+        case CompressedImage::Format::ETC2_RGBA: return GL_COMPRESSED_RGBA8_ETC2_EAC;
+    }
+    return 0;
+}
+
+uint32_t Texture::GetSizedFormat(uint32_t format, uint32_t type)
 {
-    GLenum format = GL_RGBA;
-    switch (image->GetChannelCount())
+    bool halfFloat = type == GL_HALF_FLOAT;
+    bool fullFloat = type == GL_FLOAT;
+    switch (format)
     {
+        case GL_RED: return halfFloat ? GL_R16F : fullFloat ? GL_R32F : GL_R8;
+        case GL_RG: return halfFloat ? GL_RG16F : fullFloat ? GL_RG32F : GL_RG8;
+        case GL_RGB: return halfFloat ? GL_RGB16F : fullFloat ? GL_RGB32F : GL_RGB8;
+        case GL_RGBA: return halfFloat ? GL_RGBA16F : fullFloat ? GL_RGBA32F : GL_RGBA8;
+        case GL_DEPTH_COMPONENT: return fullFloat ? GL_DEPTH_COMPONENT32F : GL_DEPTH_COMPONENT24;
+        case GL_DEPTH_STENCIL:
+            return type == GL_FLOAT_32_UNSIGNED_INT_24_8_REV ? GL_DEPTH32F_STENCIL8 : GL_DEPTH24_STENCIL8;
+        // 이미 크기가 정해진 format
+        default: return format;
+    }
+}
+
+size_t Texture::GetPixelSize(uint32_t format, uint32_t type)
+{
+    size_t channelCount = 4;
+    switch (format)
+    {
+        case GL_RED:
+        case GL_DEPTH_COMPONENT:
+        case GL_DEPTH_STENCIL:
+            channelCount = 1;
+            break;
+        case GL_RG: channelCount = 2; break;
+        case GL_RGB: channelCount = 3; break;
         default: break;
-        case 1: format = GL_RED; break;
-        case 2: format = GL_RG; break;
-        case 3: format = GL_RGB; break;
     }
 
+    switch (type)
+    {
+        case GL_HALF_FLOAT:
+        case GL_UNSIGNED_SHORT:
+            return channelCount * 2;
+        case GL_FLOAT:
+        case GL_UNSIGNED_INT:
+        case GL_UNSIGNED_INT_24_8:
+            return channelCount * 4;
+        default:
+            return channelCount;
+    }
+}
+
+size_t Texture::GetMipChainSize(int width, int height, size_t pixelSize)
+{
+    size_t size = 0;
+    while (true)
+    {
+        size += (size_t)width * height * pixelSize;
+        if (width == 1 && height == 1)
+            return size;
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+}
+
+void Texture::CreateTextureFromImage(const Image* image)
+{
+    GLenum format = GetImageFormat(image->GetChannelCount());
+
     m_width = image->GetWidth();
     m_height = image->GetHeight();
     m_format = format;
+    m_internalFormat = GetSizedFormat(format, GL_UNSIGNED_BYTE);
     m_type = GL_UNSIGNED_BYTE;
+    // CPU 에서 만든 mip 이 없어도 GPU 에서 만들 자리까지 1x1 까지 잡는다
+    m_levelCount = GetMipLevelCount(m_width, m_height);
+    AllocateStorage(GL_TEXTURE_2D, m_levelCount, m_internalFormat, m_width, m_height, m_format, m_type);
+
+    // RGB 나 홀수 크기 mip 은 row 가 4 byte 배수가 아니다
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int level = 0; level < image->GetLevelCount(); ++level)
+    {
+        glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0,
+            image->GetLevelWidth(level), image->GetLevelHeight(level),
+            m_format, m_type,
+            image->GetLevelData(level));
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, m_format,
-        m_width, m_height, 0,
-        m_format, m_type,
-        image->GetData());
-    
-    glGenerateMipmap(GL_TEXTURE_2D);
+    // CPU 에서 만든 mip 이 없는 image (코드로 만든 것 등) 만 GPU 에서 만든다
+    if (image->GetLevelCount() == 1)
+        glGenerateMipmap(GL_TEXTURE_2D);
+    m_memorySize = GetMipChainSize(m_width, m_height, GetPixelSize(m_format, m_type));
+    SetSampler(SamplerState::Anisotropic());
+}
+
+void Texture::CreateTextureFromCompressedImage(const CompressedImage* image)
+{
+    const auto& levels = image->GetLevels();
+    m_width = image->GetWidth();
+    m_height = image->GetHeight();
+    m_format = GetCompressedFormat(image->GetFormat());
+    m_internalFormat = m_format;
+    m_levelCount = (int)levels.size();
+    m_compressed = true;
+    m_memorySize = image->GetDataSize();
+
+    // 압축 format 은 glTexImage2D 로 빈 level 을 잡을 수 없는 것도 있어서 storage 가 없으면 바로 올린다
+    bool immutable = GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_texture_storage;
+    if (immutable)
+        glTexStorage2D(GL_TEXTURE_2D, m_levelCount, m_internalFormat, m_width, m_height);
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        if (immutable)
+        {
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, (GLint)i, 0, 0, levels[i].width, levels[i].height,
+                m_internalFormat, (GLsizei)levels[i].size, image->GetLevelData(i));
+        }
+        else
+        {
+            glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, m_internalFormat,
+                levels[i].width, levels[i].height, 0,
+                (GLsizei)levels[i].size, image->GetLevelData(i));
+        }
+    }
+    // file 에 없는 작은 level 은 쓰지 않는다
+    if (!immutable)
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_levelCount - 1);
+    SetSampler(m_levelCount > 1 ? SamplerState::Anisotropic() : SamplerState::Linear());
+}
+
+void Texture::ReplaceTexture(uint32_t texture, int width, int height, uint32_t format)
+{
+    // sampler 는 Texture 에 있으므로 GL texture 만 바꾸면 된다
+    RenderState::Get().OnDeleteTexture(m_texture);
+    glDeleteTextures(1, &m_texture);
+    m_texture = texture;
+    m_width = width;
+    m_height = height;
+    m_format = format;
+    m_internalFormat = GetSizedFormat(format, GL_UNSIGNED_BYTE);
+    m_type = GL_UNSIGNED_BYTE;
+    m_levelCount = GetMipLevelCount(width, height);
+    m_compressed = false;
+    m_memorySize = GetMipChainSize(width, height, GetPixelSize(format, m_type));
 }
 
 void Texture::SetTextureFormat(int width, int height, uint32_t format, uint32_t type)
@@ -86,9 +297,14 @@ void Texture::SetTextureFormat(int width, int height, uint32_t format, uint32_t
     m_width = width;
     m_height = height;
     m_format = format;
+    m_internalFormat = GetSizedFormat(format, type);
     m_type = type;
+    m_levelCount = 1;
+    m_memorySize = (size_t)width * height * GetPixelSize(format, type);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, m_format, m_width, m_height, 0, m_format, m_type, nullptr);
+    // render target 이라 mip 이 없다
+    AllocateStorage(GL_TEXTURE_2D, 1, m_internalFormat, m_width, m_height, m_format, m_type);
+    SetSampler(SamplerState::Linear());
 }
 
 CubeTextureUPtr CubeTexture::CreateFromImages(const std::vector<Image*>& images)
@@ -105,22 +321,36 @@ CubeTexture::~CubeTexture()
 {
     if (m_texture)
     {
+        RenderState::Get().OnDeleteTexture(m_texture);
         glDeleteTextures(1, &m_texture);
     }
 }
 
 bool CubeTexture::InitFromImages(const std::vector<Image*>& images)
 {
+    // 여섯 면의 storage 를 한 번에 잡으므로 크기가 모두 같아야 한다
+    if (images.size() != 6)
+    {
+        SPDLOG_ERROR("cube texture needs 6 images: {}", images.size());
+        return false;
+    }
+    int width = images[0]->GetWidth();
+    int height = images[0]->GetHeight();
+    for (auto image : images)
+    {
+        if (image->GetWidth() != width || image->GetHeight() != height)
+        {
+            SPDLOG_ERROR("cube texture faces have different sizes");
+            return false;
+        }
+    }
+
     glGenTextures(1, &m_texture);
     Bind();
+    Texture::AllocateStorage(GL_TEXTURE_CUBE_MAP, 1, GL_RGB8, width, height, GL_RGB, GL_UNSIGNED_BYTE);
 
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-    for (uint32_t i = 0; i< static_cast<uint32_t>(images.size()); ++i)
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (uint32_t i = 0; i < static_cast<uint32_t>(images.size()); ++i)
     {
         auto image = images[i];
         GLenum format = GL_RGBA;
@@ -133,16 +363,25 @@ bool CubeTexture::InitFromImages(const std::vector<Image*>& images)
             case 3: format = GL_RGB; break;
         }
         
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB,
-            image->GetWidth(), image->GetHeight(), 0,
+        glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, 0, 0,
+            width, height,
             format, GL_UNSIGNED_BYTE,
             image->GetData());
     }
-    
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    m_sampler = SamplerCache::Get().GetSampler(SamplerState::Linear());
     return true;
 }
 
 void CubeTexture::Bind() const
 {
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_texture);
+    RenderState::Get().BindTexture(GL_TEXTURE_CUBE_MAP, m_texture);
+}
+
+void CubeTexture::Bind(uint32_t unit) const
+{
+    auto& renderState = RenderState::Get();
+    renderState.BindTexture(unit, GL_TEXTURE_CUBE_MAP, m_texture);
+    renderState.BindSampler(unit, m_sampler);
 }
\ No newline at end of file
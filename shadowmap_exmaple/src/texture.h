@@ -2,6 +2,8 @@
 #define __TEXTURE_H__
 
 #include "image.h"
+#include "compressed_image.h"
+#include "sampler.h"
 
 CLASS_PTR(Texture)
 
@@ -10,29 +12,65 @@ class Texture
 public:
     static TextureUPtr CreateFromImage(const Image* image);
     static TextureUPtr Create(int width, int height, uint32_t format, uint32_t type = GL_UNSIGNED_BYTE);
+    // 들어 있는 mip level 을 모두 올린다. 지금 GL context 가 format 을 지원하지 않으면 nullptr
+    static TextureUPtr CreateFromCompressedImage(const CompressedImage* image);
+    static bool IsFormatSupported(CompressedImage::Format format);
+    // 지금 bind 된 texture 에 크기가 바뀌지 않는 storage 를 잡는다
+    // glTexStorage2D (4.2 / ARB_texture_storage) 가 없으면 glTexImage2D 로 level 을 하나씩 잡고 max level 을 맞춘다
+    static void AllocateStorage(uint32_t target, int levelCount, uint32_t internalFormat,
+        int width, int height, uint32_t format, uint32_t type);
+    // 1x1 까지의 level 수
+    static int GetMipLevelCount(int width, int height);
     ~Texture();
 
     const uint32_t Get() const { return m_texture; }
     const int GetWidth() const { return m_width; }
     const int GetHeight() const { return m_height; }
     const uint32_t GetType() const { return m_format; }
+    // 압축 texture 면 GL_COMPRESSED_* internal format
+    const uint32_t GetFormat() const { return m_format; }
+    // GL_RGBA8 처럼 크기가 정해진 format
+    const uint32_t GetInternalFormat() const { return m_internalFormat; }
+    int GetLevelCount() const { return m_levelCount; }
+    bool IsCompressed() const { return m_compressed; }
+    // mip level 까지 합친 크기 (driver 의 padding 은 모르므로 추정치)
+    size_t GetMemorySize() const { return m_memorySize; }
 
+    // 현재 active unit 에 texture 만 bind (upload 용)
     void Bind() const;
-    void SetFilter(uint32_t minFilter, uint32_t magFilter) const;
-    void SetWrap(uint32_t sWrap, uint32_t tWrap) const;
-    void SetBorderColor(const glm::vec4& color) const;
+    // unit 에 texture 와 sampler 를 같이 bind
+    void Bind(uint32_t unit) const;
+    // filter / wrap 은 texture object 가 아니라 같은 설정끼리 같이 쓰는 sampler object 에 있다
+    void SetSampler(const SamplerState& state);
+    const SamplerState& GetSamplerState() const { return m_samplerState; }
 
 private:
+    friend class TextureStreamer;
+
     Texture() {}
     void CreateTexture();
     void CreateTextureFromImage(const Image* image);
+    void CreateTextureFromCompressedImage(const CompressedImage* image);
     void SetTextureFormat(int width, int height, uint32_t format, uint32_t type);
+    static uint32_t GetImageFormat(int channelCount);
+    static uint32_t GetCompressedFormat(CompressedImage::Format format);
+    static uint32_t GetSizedFormat(uint32_t format, uint32_t type);
+    static size_t GetPixelSize(uint32_t format, uint32_t type);
+    static size_t GetMipChainSize(int width, int height, size_t pixelSize);
+    // streaming 이 끝난 GL texture (1x1 까지 모든 level 이 있는 것) 로 바꾸고 지금 texture 는 지운다
+    void ReplaceTexture(uint32_t texture, int width, int height, uint32_t format);
 
     uint32_t m_texture { 0 };
     int m_width { 0 };
     int m_height { 0 };
     uint32_t m_format { 0 };
+    uint32_t m_internalFormat { 0 };
     uint32_t m_type { GL_UNSIGNED_BYTE };
+    int m_levelCount { 1 };
+    bool m_compressed { false };
+    size_t m_memorySize { 0 };
+    SamplerState m_samplerState;
+    uint32_t m_sampler { 0 };
 };
 
 CLASS_PTR(CubeTexture)
@@ -44,11 +82,13 @@ public:
 
     const uint32_t Get() const { return m_texture; }
     void Bind() const;
+    void Bind(uint32_t unit) const;
 
 private:
     CubeTexture() {}
     bool InitFromImages(const std::vector<Image*>& images);
     uint32_t m_texture { 0 };
+    uint32_t m_sampler { 0 };
 };
 
 #endif // __TEXTURE_H__
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include "texture_cache.h"
+#include "mip_cache.h"
+#include <filesystem>
+
+TextureCacheUPtr TextureCache::Create(TextureStreamer* streamer)
+{
+    auto cache = TextureCacheUPtr(new TextureCache());
+    cache->m_streamer = streamer;
+    return std::move(cache);
+}
+
+std::string TextureCache::MakePathKey(const std::string& filepath, bool flipVertical, bool defaultPath, bool srgb)
+{
+    std::string fullPath = defaultPath ? std::string(IMAGE_PATH) : "";
+    fullPath += filepath;
+
+    // "a/../b.png", "./b.png" 처럼 다르게 쓴 같은 file 을 하나로 모은다
+    std::error_code error;
+    auto canonical = std::filesystem::weakly_canonical(fullPath, error);
+    if (error)
+        canonical = std::filesystem::path(fullPath).lexically_normal();
+    // 압축 file 은 뒤집지 않고 mip 도 file 에 있으므로 옵션과 상관없이 같은 texture 다
+    if (CompressedImage::IsCompressedFile(filepath))
+    {
+        flipVertical = false;
+        srgb = true;
+    }
+    return fmt::format("{}|{}|{}", canonical.generic_string(), flipVertical ? "flip" : "noflip",
+        srgb ? "srgb" : "linear");
+}
+
+uint64_t TextureCache::MakeContentKey(const Image* image)
+{
+    int header[3] = { image->GetWidth(), image->GetHeight(), image->GetChannelCount() };
+    uint64_t key = HashBytes(header, sizeof(header));
+    return HashBytes(image->GetData(), (size_t)header[0] * header[1] * header[2], key);
+}
+
+template <typename Key>
+TexturePtr TextureCache::Find(const std::unordered_map<Key, TextureWPtr>& textures, const Key& key)
+{
+    auto iter = textures.find(key);
+    if (iter == textures.end())
+        return nullptr;
+    auto texture = iter->second.lock();
+    if (texture)
+        ++m_stats.hitCount;
+    return texture;
+}
+
+void TextureCache::RemoveExpired()
+{
+    auto Remove = [](auto& textures) {
+        for (auto iter = textures.begin(); iter != textures.end();)
+            iter = iter->second.expired() ? textures.erase(iter) : std::next(iter);
+    };
+    Remove(m_fileTextures);
+    Remove(m_imageTextures);
+}
+
+void TextureCache::CountMiss()
+{
+    ++m_stats.missCount;
+    if ((m_stats.missCount & 63) == 0)
+        RemoveExpired();
+}
+
+TexturePtr TextureCache::Load(const std::string& filepath, bool flipVertical, bool defaultPath, bool srgb)
+{
+    if (CompressedImage::IsCompressedFile(filepath))
+        return LoadCompressed(filepath, defaultPath);
+    return Load(filepath, flipVertical, defaultPath, srgb, [&]() -> ImagePtr {
+        return MipCache::Load(filepath, flipVertical, defaultPath, MipFilter::Kaiser, srgb);
+    });
+}
+
+TexturePtr TextureCache::Load(const std::string& filepath, bool flipVertical, bool defaultPath, bool srgb,
+    const std::function<ImagePtr()>& decode)
+{
+    auto key = MakePathKey(filepath, flipVertical, defaultPath, srgb);
+    if (auto texture = Find(m_fileTextures, key))
+        return texture;
+
+    auto image = decode();
+    if (!image)
+        return nullptr;
+    CountMiss();
+
+    TexturePtr texture = m_streamer ? m_streamer->Stream(std::move(image)) : Texture::CreateFromImage(image.get());
+    m_fileTextures[key] = texture;
+    return texture;
+}
+
+TexturePtr TextureCache::LoadCompressed(const std::string& filepath, bool defaultPath)
+{
+    auto key = MakePathKey(filepath, false, defaultPath, true);
+    if (auto texture = Find(m_fileTextures, key))
+        return texture;
+
+    auto image = CompressedImage::Load(filepath, defaultPath);
+    if (!image)
+        return nullptr;
+    TexturePtr texture = Texture::CreateFromCompressedImage(image.get());
+    if (!texture)
+        return nullptr;
+    CountMiss();
+    m_fileTextures[key] = texture;
+    return texture;
+}
+
+bool TextureCache::Contains(const std::string& filepath, bool flipVertical, bool defaultPath, bool srgb) const
+{
+    auto iter = m_fileTextures.find(MakePathKey(filepath, flipVertical, defaultPath, srgb));
+    return iter != m_fileTextures.end() && !iter->second.expired();
+}
+
+TexturePtr TextureCache::CreateFromImage(const Image* image)
+{
+    auto key = MakeContentKey(image);
+    if (auto texture = Find(m_imageTextures, key))
+        return texture;
+
+    CountMiss();
+
+    TexturePtr texture = Texture::CreateFromImage(image);
+    m_imageTextures[key] = texture;
+    return texture;
+}
+
+TexturePtr TextureCache::CreateSingleColor(const glm::vec4& color, int width, int height)
+{
+    auto image = Image::CreateSingleColorImage(width, height, color);
+    return CreateFromImage(image.get());
+}
+
+size_t TextureCache::GetLiveCount() const
+{
+    size_t count = 0;
+    for (const auto& entry : m_fileTextures)
+        count += entry.second.expired() ? 0 : 1;
+    for (const auto& entry : m_imageTextures)
+        count += entry.second.expired() ? 0 : 1;
+    return count;
+}
+
+size_t TextureCache::GetLiveMemorySize() const
+{
+    size_t size = 0;
+    auto Add = [&](const auto& textures) {
+        for (const auto& entry : textures)
+        {
+            if (auto texture = entry.second.lock())
+                size += texture->GetMemorySize();
+        }
+    };
+    Add(m_fileTextures);
+    Add(m_imageTextures);
+    return size;
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef __TEXTURE_CACHE_H__
+#define __TEXTURE_CACHE_H__
+
+#include "common.h"
+#include "texture.h"
+#include "texture_streamer.h"
+#include <functional>
+#include <unordered_map>
+
+// 같은 texture 를 한 번만 decode / upload 하고 TexturePtr 를 나눠 준다
+// file 은 정규화한 경로 + load 옵션 (flip, sRGB) 으로, 코드로 만든 image 는 내용 hash 로 찾는다
+// cache 는 weak_ptr 만 들고 있어서 쓰는 곳이 모두 없어진 texture 는 바로 해제된다
+// GL thread 에서만 쓴다
+CLASS_PTR(TextureCache)
+class TextureCache
+{
+public:
+    struct Stats
+    {
+        int hitCount { 0 };
+        int missCount { 0 };
+    };
+
+    // streamer 가 있으면 file texture 는 placeholder 로 먼저 돌려주고 내용은 여러 frame 에 나눠 올린다
+    static TextureCacheUPtr Create(TextureStreamer* streamer = nullptr);
+
+    // MipCache::Load 와 같은 인자. 읽지 못하면 nullptr 이고 실패는 cache 하지 않는다
+    // srgb 는 mip 을 만들 때 색으로 섞을지 정한다. specular 처럼 색이 아닌 data 는 false
+    // .dds / .ktx2 는 CompressedImage 로 읽어 streamer 를 거치지 않고 바로 올린다
+    TexturePtr Load(const std::string& filepath, bool flipVertical = true, bool defaultPath = true, bool srgb = true);
+    // decode 를 다른 곳 (worker thread 등) 에서 하는 경우, cache 에 없을 때만 decode 를 불러 image 를 받는다
+    TexturePtr Load(const std::string& filepath, bool flipVertical, bool defaultPath, bool srgb,
+        const std::function<ImagePtr()>& decode);
+    // 통계에 세지 않고 살아 있는 texture 가 있는지만 본다 (decode 를 걸지 정할 때)
+    bool Contains(const std::string& filepath, bool flipVertical, bool defaultPath, bool srgb) const;
+
+    TexturePtr CreateFromImage(const Image* image);
+    TexturePtr CreateSingleColor(const glm::vec4& color, int width = 4, int height = 4);
+
+    const Stats& GetStats() const { return m_stats; }
+    // 아직 누군가 쓰고 있는 texture 수
+    size_t GetLiveCount() const;
+    // 살아 있는 texture 의 GPU memory 합 (Texture::GetMemorySize)
+    size_t GetLiveMemorySize() const;
+
+private:
+    TextureCache() {}
+    static std::string MakePathKey(const std::string& filepath, bool flipVertical, bool defaultPath, bool srgb);
+    static uint64_t MakeContentKey(const Image* image);
+    TexturePtr LoadCompressed(const std::string& filepath, bool defaultPath);
+    template <typename Key>
+    TexturePtr Find(const std::unordered_map<Key, TextureWPtr>& textures, const Key& key);
+    // 해제된 항목이 쌓이지 않게 가끔 지운다
+    void RemoveExpired();
+    void CountMiss();
+
+    TextureStreamer* m_streamer { nullptr };
+    std::unordered_map<std::string, TextureWPtr> m_fileTextures;
+    std::unordered_map<uint64_t, TextureWPtr> m_imageTextures;
+    Stats m_stats;
+};
+
+#endif // __TEXTURE_CACHE_H__
\ No newline at end of file
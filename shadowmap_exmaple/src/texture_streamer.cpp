@@ -0,0 +1,233 @@
+#include "texture_streamer.h"
+#include "render_state.h"
+#include <cstring>
+
+TextureStreamerUPtr TextureStreamer::Create(size_t bufferSize, uint32_t bufferCount, size_t frameBudget)
+{
+    auto streamer = TextureStreamerUPtr(new TextureStreamer());
+    if (!streamer->Init(bufferSize, bufferCount, frameBudget))
+        return nullptr;
+    return std::move(streamer);
+}
+
+bool TextureStreamer::Init(size_t bufferSize, uint32_t bufferCount, size_t frameBudget)
+{
+    if (bufferSize == 0 || bufferCount == 0)
+    {
+        SPDLOG_ERROR("invalid texture streamer buffer: {} x {}", bufferSize, bufferCount);
+        return false;
+    }
+
+    m_bufferSize = bufferSize;
+    m_frameBudget = frameBudget;
+    m_buffers.resize(bufferCount);
+    auto& renderState = RenderState::Get();
+    for (auto& pixelBuffer : m_buffers)
+    {
+        glGenBuffers(1, &pixelBuffer.buffer);
+        renderState.BindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer.buffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, m_bufferSize, nullptr, GL_STREAM_DRAW);
+    }
+    // unpack buffer 가 bind 되어 있으면 다른 glTexImage2D 의 data 포인터가 offset 으로 해석된다
+    renderState.BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    m_placeholderImage = Image::CreateSingleColorImage(1, 1, glm::vec4(0.5f, 0.5f, 0.5f, 1.0f));
+    SPDLOG_INFO("texture streamer: {} KB x {}, {} KB per frame",
+        m_bufferSize / 1024, bufferCount, m_frameBudget / 1024);
+    return true;
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    auto DeleteJob = [](Job& job) {
+        if (job.fence)
+            glDeleteSync(job.fence);
+        if (job.streamTexture)
+        {
+            RenderState::Get().OnDeleteTexture(job.streamTexture);
+            glDeleteTextures(1, &job.streamTexture);
+        }
+    };
+    for (auto& job : m_pending)
+        DeleteJob(job);
+    for (auto& job : m_finishing)
+        DeleteJob(job);
+
+    for (auto& pixelBuffer : m_buffers)
+    {
+        if (pixelBuffer.fence)
+            glDeleteSync(pixelBuffer.fence);
+        RenderState::Get().OnDeleteBuffer(pixelBuffer.buffer);
+        glDeleteBuffers(1, &pixelBuffer.buffer);
+    }
+}
+
+TexturePtr TextureStreamer::Stream(ImagePtr image)
+{
+    size_t rowSize = (size_t)image->GetWidth() * image->GetChannelCount();
+    if (rowSize > m_bufferSize)
+    {
+        SPDLOG_WARN("texture row ({} bytes) does not fit in a pixel buffer, uploading directly", rowSize);
+        return Texture::CreateFromImage(image.get());
+    }
+
+    TexturePtr texture = Texture::CreateFromImage(m_placeholderImage.get());
+    Job job;
+    job.texture = texture;
+    job.image = std::move(image);
+    job.format = Texture::GetImageFormat(job.image->GetChannelCount());
+    m_pending.push_back(std::move(job));
+    m_stats.pendingCount = (uint32_t)(m_pending.size() + m_finishing.size());
+    return texture;
+}
+
+bool TextureStreamer::IsSignaled(GLsync fence)
+{
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+void TextureStreamer::BeginJob(Job& job)
+{
+    const auto& image = job.image;
+    glGenTextures(1, &job.streamTexture);
+    RenderState::Get().BindTexture(GL_TEXTURE_2D, job.streamTexture);
+    // mip 이 없는 image 는 끝에 glGenerateMipmap 으로 채우므로 1x1 까지 잡는다
+    int levelCount = image->GetLevelCount() > 1 ? image->GetLevelCount()
+        : Texture::GetMipLevelCount(image->GetWidth(), image->GetHeight());
+    Texture::AllocateStorage(GL_TEXTURE_2D, levelCount, Texture::GetSizedFormat(job.format, GL_UNSIGNED_BYTE),
+        image->GetWidth(), image->GetHeight(), job.format, GL_UNSIGNED_BYTE);
+}
+
+TextureStreamer::PixelBuffer* TextureStreamer::FindFreeBuffer()
+{
+    for (auto& pixelBuffer : m_buffers)
+    {
+        if (!pixelBuffer.fence)
+            return &pixelBuffer;
+    }
+    return nullptr;
+}
+
+void TextureStreamer::Update()
+{
+    auto& renderState = RenderState::Get();
+    m_stats.uploadedBytes = 0;
+
+    // GPU 가 다 쓴 texture 를 placeholder 와 바꾼다
+    for (size_t i = 0; i < m_finishing.size();)
+    {
+        auto& job = m_finishing[i];
+        if (!IsSignaled(job.fence))
+        {
+            ++i;
+            continue;
+        }
+        glDeleteSync(job.fence);
+        if (auto texture = job.texture.lock())
+        {
+            texture->ReplaceTexture(job.streamTexture, job.image->GetWidth(), job.image->GetHeight(), job.format);
+        }
+        else
+        {
+            renderState.OnDeleteTexture(job.streamTexture);
+            glDeleteTextures(1, &job.streamTexture);
+        }
+        ++m_stats.completedCount;
+        if (i + 1 < m_finishing.size())
+            m_finishing[i] = std::move(m_finishing.back());
+        m_finishing.pop_back();
+    }
+
+    for (auto& pixelBuffer : m_buffers)
+    {
+        if (pixelBuffer.fence && IsSignaled(pixelBuffer.fence))
+        {
+            glDeleteSync(pixelBuffer.fence);
+            pixelBuffer.fence = nullptr;
+        }
+    }
+
+    // image row 는 빈틈 없이 붙어 있다 (RGB 는 4 byte 배수가 아닐 수 있다)
+    bool unpackChanged = false;
+    while (!m_pending.empty())
+    {
+        auto& job = m_pending.front();
+        if (job.texture.expired())
+        {
+            if (job.streamTexture)
+            {
+                renderState.OnDeleteTexture(job.streamTexture);
+                glDeleteTextures(1, &job.streamTexture);
+            }
+            m_pending.pop_front();
+            continue;
+        }
+
+        auto pixelBuffer = FindFreeBuffer();
+        if (!pixelBuffer)
+            break;
+        const auto& image = job.image;
+        int levelWidth = image->GetLevelWidth(job.level);
+        int levelHeight = image->GetLevelHeight(job.level);
+        size_t rowSize = (size_t)levelWidth * image->GetChannelCount();
+        size_t remainingBudget = m_frameBudget > m_stats.uploadedBytes ? m_frameBudget - m_stats.uploadedBytes : 0;
+        int rowCount = (int)(std::min(m_bufferSize, remainingBudget) / rowSize);
+        // budget 이 row 하나보다 작아도 frame 마다 조금씩은 진행한다
+        if (rowCount == 0 && m_stats.uploadedBytes == 0)
+            rowCount = 1;
+        rowCount = std::min(rowCount, levelHeight - job.nextRow);
+        if (rowCount <= 0)
+            break;
+
+        if (!job.streamTexture)
+            BeginJob(job);
+        if (!unpackChanged)
+        {
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            unpackChanged = true;
+        }
+
+        size_t size = rowSize * rowCount;
+        renderState.BindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer->buffer);
+        // fence 로 GPU 가 다 읽은 것을 확인했으므로 이전 내용은 버려도 된다
+        void* dest = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (!dest)
+        {
+            SPDLOG_ERROR("failed to map pixel unpack buffer");
+            break;
+        }
+        memcpy(dest, image->GetLevelData(job.level) + job.nextRow * rowSize, size);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        renderState.BindTexture(GL_TEXTURE_2D, job.streamTexture);
+        glTexSubImage2D(GL_TEXTURE_2D, job.level, 0, job.nextRow, levelWidth, rowCount,
+            job.format, GL_UNSIGNED_BYTE, nullptr);
+        pixelBuffer->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        job.nextRow += rowCount;
+        m_stats.uploadedBytes += size;
+
+        if (job.nextRow == levelHeight && job.level + 1 < image->GetLevelCount())
+        {
+            ++job.level;
+            job.nextRow = 0;
+        }
+        else if (job.nextRow == levelHeight)
+        {
+            // sampler 는 placeholder Texture 의 것을 그대로 쓴다
+            if (image->GetLevelCount() == 1)
+                glGenerateMipmap(GL_TEXTURE_2D);
+            job.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            m_finishing.push_back(std::move(job));
+            m_pending.pop_front();
+        }
+    }
+
+    if (unpackChanged)
+    {
+        renderState.BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+    m_stats.pendingCount = (uint32_t)(m_pending.size() + m_finishing.size());
+}
\ No newline at end of file
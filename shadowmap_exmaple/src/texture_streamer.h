@@ -0,0 +1,80 @@
+#ifndef __TEXTURE_STREAMER_H__
+#define __TEXTURE_STREAMER_H__
+
+#include "common.h"
+#include "texture.h"
+#include <deque>
+#include <vector>
+
+// decode 된 image 를 pixel unpack buffer (PBO) 로 여러 frame 에 나눠 올린다
+//
+// Stream 은 바로 1x1 placeholder texture 를 돌려주고, 실제 내용은 따로 만든 GL texture 에
+// frame 마다 budget 만큼의 row 를 PBO 에 복사해 glTexSubImage2D 로 올린다
+// image 에 CPU 에서 만든 mip 이 있으면 level 마다 같은 방법으로 올리고, 없으면 마지막에 GPU 에서 만든다
+// 마지막 row 뒤에 건 fence 가 끝나면 Texture 안의 GL texture 를 바꿔 끼운다
+// PBO 도 각자 fence 로 GPU 가 다 읽은 것을 확인한 뒤에 다시 쓰므로 기다리는 일이 없다
+CLASS_PTR(TextureStreamer)
+class TextureStreamer
+{
+public:
+    // bufferSize 는 PBO 하나의 크기, 한 번에 올리는 row 묶음의 최대 크기이기도 하다
+    static TextureStreamerUPtr Create(size_t bufferSize = 1024 * 1024, uint32_t bufferCount = 4,
+        size_t frameBudget = 2 * 1024 * 1024);
+    ~TextureStreamer();
+
+    // image 는 다 올릴 때까지 streamer 가 들고 있는다
+    // row 하나가 PBO 보다 크면 그 자리에서 바로 올린다
+    TexturePtr Stream(ImagePtr image);
+    // frame 처음에 한 번. 끝난 upload 를 반영하고 budget 만큼 새로 올린다
+    void Update();
+
+    void SetFrameBudget(size_t frameBudget) { m_frameBudget = frameBudget; }
+    size_t GetFrameBudget() const { return m_frameBudget; }
+
+    struct Stats
+    {
+        uint32_t pendingCount { 0 };
+        uint32_t completedCount { 0 };
+        // 지난 Update 에서 올린 byte 수
+        size_t uploadedBytes { 0 };
+    };
+    const Stats& GetStats() const { return m_stats; }
+
+private:
+    TextureStreamer() {}
+    bool Init(size_t bufferSize, uint32_t bufferCount, size_t frameBudget);
+
+    struct Job
+    {
+        // 쓰는 곳이 모두 없어지면 upload 를 그만둔다
+        TextureWPtr texture;
+        ImagePtr image;
+        uint32_t streamTexture { 0 };
+        uint32_t format { 0 };
+        int level { 0 };
+        int nextRow { 0 };
+        GLsync fence { nullptr };
+    };
+    struct PixelBuffer
+    {
+        uint32_t buffer { 0 };
+        // GPU 가 아직 읽는 중이면 nullptr 가 아니다
+        GLsync fence { nullptr };
+    };
+
+    static bool IsSignaled(GLsync fence);
+    void BeginJob(Job& job);
+    PixelBuffer* FindFreeBuffer();
+
+    std::vector<PixelBuffer> m_buffers;
+    size_t m_bufferSize { 0 };
+    size_t m_frameBudget { 0 };
+    // 앞에서부터 하나씩 올린다
+    std::deque<Job> m_pending;
+    // 다 올리고 fence 를 기다리는 중
+    std::vector<Job> m_finishing;
+    ImageUPtr m_placeholderImage;
+    Stats m_stats;
+};
+
+#endif // __TEXTURE_STREAMER_H__
\ No newline at end of file
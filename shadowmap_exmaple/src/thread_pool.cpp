@@ -0,0 +1,60 @@
+#include "thread_pool.h"
+
+ThreadPoolUPtr ThreadPool::Create(uint32_t threadCount)
+{
+    auto threadPool = ThreadPoolUPtr(new ThreadPool());
+    threadPool->Init(threadCount);
+    return std::move(threadPool);
+}
+
+void ThreadPool::Init(uint32_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        // hardware_concurrency 는 알 수 없으면 0 을 돌려준다
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    m_threads.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i)
+        m_threads.emplace_back(&ThreadPool::WorkerMain, this);
+    SPDLOG_INFO("thread pool: {} workers", threadCount);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+    for (auto& thread : m_threads)
+        thread.join();
+}
+
+void ThreadPool::Enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_condition.notify_one();
+}
+
+void ThreadPool::WorkerMain()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+            if (m_tasks.empty())
+                return;
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
\ No newline at end of file
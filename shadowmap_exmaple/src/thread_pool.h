@@ -0,0 +1,52 @@
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include "common.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// 고정 개수의 worker thread 가 하나의 queue 에서 작업을 꺼내 실행한다
+// 작업 안에서는 GL 함수를 부르면 안 된다 (GL context 는 main thread 에만 있다)
+CLASS_PTR(ThreadPool)
+class ThreadPool
+{
+public:
+    // threadCount 가 0 이면 hardware thread 수 - 1 (main thread 몫을 남긴다)
+    static ThreadPoolUPtr Create(uint32_t threadCount = 0);
+    // queue 에 남은 작업까지 마치고 thread 를 join 한다
+    ~ThreadPool();
+
+    uint32_t GetThreadCount() const { return (uint32_t)m_threads.size(); }
+
+    // 결과 (또는 작업이 던진 예외) 는 future 로 받는다
+    template <typename F>
+    std::future<std::invoke_result_t<std::decay_t<F>>> Submit(F&& task)
+    {
+        using Result = std::invoke_result_t<std::decay_t<F>>;
+        // std::function 은 복사 가능해야 해서 move-only 인 packaged_task 를 shared_ptr 로 감싼다
+        auto packagedTask = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        auto future = packagedTask->get_future();
+        Enqueue([packagedTask]() { (*packagedTask)(); });
+        return future;
+    }
+
+private:
+    ThreadPool() {}
+    void Init(uint32_t threadCount);
+    void Enqueue(std::function<void()> task);
+    void WorkerMain();
+
+    std::vector<std::thread> m_threads;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopping { false };
+};
+
+#endif // __THREAD_POOL_H__
\ No newline at end of file
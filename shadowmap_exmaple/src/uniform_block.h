@@ -0,0 +1,60 @@
+#ifndef __UNIFORM_BLOCK_H__
+#define __UNIFORM_BLOCK_H__
+
+#include "common.h"
+
+// shader/ 의 모든 program 이 공유하는 uniform block binding point
+enum UniformBlockBinding : uint32_t
+{
+    UNIFORM_BLOCK_FRAME = 0,
+    UNIFORM_BLOCK_LIGHT = 1,
+};
+
+struct UniformBlockInfo
+{
+    const char* name;
+    uint32_t binding;
+};
+
+// Program::Link 에서 이름으로 찾아 binding point 를 지정한다
+// (#version 330 에서는 layout(binding = N) 을 쓸 수 없음)
+const UniformBlockInfo UNIFORM_BLOCKS[] = {
+    { "FrameBlock", UNIFORM_BLOCK_FRAME },
+    { "LightBlock", UNIFORM_BLOCK_LIGHT },
+};
+
+// std140 layout, shader 의 FrameBlock 과 순서가 같아야 함
+struct FrameBlock
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::vec3 viewPos;
+    float padding0;
+};
+
+// std140 layout, shader 의 LightBlock 과 순서가 같아야 함
+struct LightBlock
+{
+    glm::mat4 transform;
+    glm::vec3 position;
+    int directional;
+    glm::vec3 direction;
+    int blinn;
+    glm::vec3 attenuation;
+    float padding0;
+    glm::vec2 cutoff;
+    glm::vec2 padding1;
+    glm::vec3 ambient;
+    float padding2;
+    glm::vec3 diffuse;
+    float padding3;
+    glm::vec3 specular;
+    float padding4;
+};
+
+static_assert(offsetof(FrameBlock, viewPos) == 192, "FrameBlock must follow std140 layout");
+static_assert(offsetof(LightBlock, cutoff) == 112, "LightBlock must follow std140 layout");
+static_assert(offsetof(LightBlock, specular) == 160, "LightBlock must follow std140 layout");
+
+#endif // __UNIFORM_BLOCK_H__
\ No newline at end of file
@@ -0,0 +1,21 @@
+#include "vertex_format.h"
+
+size_t GetVertexFormatStride(VertexFormat vertexFormat)
+{
+    return vertexFormat == VERTEX_FORMAT_COMPACT ? sizeof(CompactVertex) : sizeof(Vertex);
+}
+
+const std::vector<VertexAttribFormat>& GetVertexAttribFormats(VertexFormat vertexFormat)
+{
+    static const std::vector<VertexAttribFormat> fullFormats = {
+        { 0, 3, GL_FLOAT, false, (uint32_t)offsetof(Vertex, position) },
+        { 1, 3, GL_FLOAT, false, (uint32_t)offsetof(Vertex, normal) },
+        { 2, 2, GL_FLOAT, false, (uint32_t)offsetof(Vertex, texCoord) },
+    };
+    static const std::vector<VertexAttribFormat> compactFormats = {
+        { 0, 3, GL_UNSIGNED_SHORT, true, (uint32_t)offsetof(CompactVertex, position) },
+        { 1, 2, GL_SHORT, true, (uint32_t)offsetof(CompactVertex, normal) },
+        { 2, 2, GL_HALF_FLOAT, false, (uint32_t)offsetof(CompactVertex, texCoord) },
+    };
+    return vertexFormat == VERTEX_FORMAT_COMPACT ? compactFormats : fullFormats;
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef __VERTEX_FORMAT_H__
+#define __VERTEX_FORMAT_H__
+
+#include "common.h"
+#include <vector>
+
+struct Vertex
+{
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texCoord;
+};
+
+enum VertexFormat : uint32_t
+{
+    // Vertex 그대로, 32 byte
+    VERTEX_FORMAT_FULL = 0,
+    // CompactVertex, 16 byte. shader 는 compact_vertex.glsl 로 복원한다
+    VERTEX_FORMAT_COMPACT = 1,
+    VERTEX_FORMAT_COUNT,
+};
+
+// position: bounding box 최소점 기준, 가장 긴 변을 1 로 본 unorm16 (w 는 4 byte 정렬용)
+// normal: octahedral snorm16
+// texCoord: half float (0~1 밖의 반복 uv 도 표현)
+struct CompactVertex
+{
+    uint16_t position[4];
+    int16_t normal[2];
+    uint16_t texCoord[2];
+};
+static_assert(sizeof(CompactVertex) == 16, "compact vertex must be 16 bytes");
+
+// vertex format 의 attribute 하나, offset 은 vertex 안에서의 위치
+struct VertexAttribFormat
+{
+    uint32_t location;
+    int count;
+    uint32_t type;
+    bool normalized;
+    uint32_t offset;
+};
+
+size_t GetVertexFormatStride(VertexFormat vertexFormat);
+const std::vector<VertexAttribFormat>& GetVertexAttribFormats(VertexFormat vertexFormat);
+
+#endif // __VERTEX_FORMAT_H__
\ No newline at end of file
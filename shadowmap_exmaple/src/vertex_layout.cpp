@@ -1,4 +1,5 @@
 #include "vertex_layout.h"
+#include "render_state.h"
 
 VertexLayoutUPtr VertexLayout::Create()
 {
@@ -10,12 +11,15 @@ VertexLayoutUPtr VertexLayout::Create()
 VertexLayout::~VertexLayout()
 {
     if (m_vertexArrayObject != 0)
+    {
+        RenderState::Get().OnDeleteVertexArray(m_vertexArrayObject);
         glDeleteVertexArrays(1, &m_vertexArrayObject);
+    }
 }
 
 void VertexLayout::Bind() const
 {
-    glBindVertexArray(m_vertexArrayObject);
+    RenderState::Get().BindVertexArray(m_vertexArrayObject);
 }
 
 void VertexLayout::SetAttrib(
@@ -27,6 +31,49 @@ void VertexLayout::SetAttrib(
     glVertexAttribPointer(attribIndex, count, type, normalized, stride, (void*)offset);
 }
 
+void VertexLayout::SetAttribDivisor(uint32_t attribIndex, uint32_t divisor) const
+{
+    glVertexAttribDivisor(attribIndex, divisor);
+}
+
+static bool HasVertexAttribBinding()
+{
+    return GLAD_GL_VERSION_4_3 || GLAD_GL_ARB_vertex_attrib_binding;
+}
+
+void VertexLayout::SetAttribFormat(uint32_t attribIndex, int count, uint32_t type, bool normalized,
+    uint32_t relativeOffset, uint32_t bindingIndex)
+{
+    Bind();
+    glEnableVertexAttribArray(attribIndex);
+    if (HasVertexAttribBinding())
+    {
+        glVertexAttribFormat(attribIndex, count, type, normalized, relativeOffset);
+        glVertexAttribBinding(attribIndex, bindingIndex);
+        return;
+    }
+    m_attribFormats.push_back({ attribIndex, count, type, normalized, relativeOffset, bindingIndex });
+}
+
+void VertexLayout::SetVertexBuffer(uint32_t bindingIndex, uint32_t buffer, size_t offset, size_t stride)
+{
+    Bind();
+    if (HasVertexAttribBinding())
+    {
+        glBindVertexBuffer(bindingIndex, buffer, (GLintptr)offset, (GLsizei)stride);
+        return;
+    }
+
+    RenderState::Get().BindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (const auto& format : m_attribFormats)
+    {
+        if (format.bindingIndex != bindingIndex)
+            continue;
+        glVertexAttribPointer(format.attribIndex, format.count, format.type, format.normalized,
+            (GLsizei)stride, (const void*)(offset + format.relativeOffset));
+    }
+}
+
 void VertexLayout::Init()
 {
     glGenVertexArrays(1, &m_vertexArrayObject);
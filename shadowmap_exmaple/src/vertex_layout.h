@@ -2,6 +2,7 @@
 #define __VERTEX_LAYOUT_H__
 
 #include "common.h"
+#include <vector>
 
 CLASS_PTR(VertexLayout)
 class VertexLayout {
@@ -15,12 +16,31 @@ public:
         uint32_t attribIndex, int count,
         uint32_t type, bool normalized,
         size_t stride, uint64_t offset) const;
+    void SetAttribDivisor(uint32_t attribIndex, uint32_t divisor) const;
     void DisableAttrib(int attribIndex) const;
 
+    // attribute format 과 vertex buffer binding 을 나눠 설정한다
+    // GL 4.3 / ARB_vertex_attrib_binding 이 있으면 buffer 만 바꿔 끼울 수 있고
+    // 없으면 format 을 기억해 두었다가 SetVertexBuffer 에서 glVertexAttribPointer 로 설정한다
+    void SetAttribFormat(uint32_t attribIndex, int count, uint32_t type, bool normalized,
+        uint32_t relativeOffset, uint32_t bindingIndex = 0);
+    void SetVertexBuffer(uint32_t bindingIndex, uint32_t buffer, size_t offset, size_t stride);
+
 private:
     VertexLayout() {}
     void Init();
     uint32_t m_vertexArrayObject { 0 };
+
+    struct AttribFormat
+    {
+        uint32_t attribIndex;
+        int count;
+        uint32_t type;
+        bool normalized;
+        uint32_t relativeOffset;
+        uint32_t bindingIndex;
+    };
+    std::vector<AttribFormat> m_attribFormats;
 };
 
 #endif // __VERTEX_LAYOUT_H__
\ No newline at end of file